@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_API_CIRCUIT_BREAKER_H_
+#define YOUTUBE_API_CIRCUIT_BREAKER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace youtube {
+namespace api {
+
+/**
+ * Stops sending requests to an endpoint that keeps failing.
+ *
+ * Each endpoint keeps a window of its most recent outcomes. Once enough of
+ * them have failed the circuit opens and requests fail straight away. After
+ * a while a single probe request is let through, and the circuit closes
+ * again if it succeeds.
+ */
+class CircuitBreaker {
+public:
+    typedef std::shared_ptr<CircuitBreaker> Ptr;
+
+    enum class State {
+        closed, open, half_open
+    };
+
+    struct Options {
+        /* Outcomes remembered per endpoint */
+        std::size_t window;
+
+        /* Outcomes needed before the circuit can open */
+        std::size_t min_requests;
+
+        /* Fraction of the window that must have failed */
+        double failure_rate;
+
+        /* How long to fail fast before probing */
+        std::chrono::milliseconds open_for;
+    };
+
+    struct Stats {
+        unsigned long opened = 0;
+
+        unsigned long rejected = 0;
+    };
+
+    static Ptr instance();
+
+    /**
+     * Drops the shared instance, so the next call to instance() starts
+     * afresh. For tests; clients made before keep the old one.
+     */
+    static void reset_instance();
+
+    CircuitBreaker(const Options &options = Options { 20, 10, 0.5,
+            std::chrono::seconds(30) });
+
+    /**
+     * Whether a request to the endpoint may go out now.
+     */
+    bool allow(const std::string &endpoint);
+
+    /**
+     * Records how a request that was allowed turned out.
+     */
+    void record(const std::string &endpoint, bool success);
+
+    /**
+     * For a request that was allowed but never went out, or was cancelled,
+     * so tells us nothing about the endpoint.
+     */
+    void release(const std::string &endpoint);
+
+    State state(const std::string &endpoint);
+
+    Stats stats();
+
+    void dump_stats(std::ostream &out);
+
+protected:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Circuit {
+        State state = State::closed;
+
+        std::deque<bool> outcomes;
+
+        std::size_t failures = 0;
+
+        Clock::time_point opened;
+
+        bool probing = false;
+
+        Clock::time_point probe_started;
+    };
+
+    void open(Circuit &circuit, const std::string &endpoint);
+
+    Options options_;
+
+    std::map<std::string, Circuit> circuits_;
+
+    Stats stats_;
+
+    std::mutex mutex_;
+};
+
+}
+}
+
+#endif // YOUTUBE_API_CIRCUIT_BREAKER_H_
@@ -25,9 +25,11 @@
 #include <youtube/api/subscription.h>
 #include <youtube/api/subscription-item.h>
 #include <youtube/api/channel-section.h>
+#include <youtube/api/deadline.h>
 #include <youtube/api/guide-category.h>
 #include <youtube/api/playlist.h>
 #include <youtube/api/playlist-item.h>
+#include <youtube/api/scheduler.h>
 #include <youtube/api/search-list-response.h>
 #include <youtube/api/video.h>
 #include <youtube/api/comment.h>
@@ -66,26 +68,72 @@ public:
     
     typedef std::deque<Comment::Ptr> CommentList;
 
-    Client(std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client);
+    /* One page of subscriptions, and the token for the next, if any */
+    struct SubscriptionPage {
+        SubscriptionList subscriptions;
+
+        std::string next_page_token;
+    };
+
+    /* Set to give up on the requests it was passed with */
+    typedef std::shared_ptr<std::atomic<bool>> Abort;
+
+    Client(std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client,
+            Scheduler::Priority priority = Scheduler::Priority::foreground);
 
     virtual ~Client() = default;
 
+    /**
+     * A client making its requests through this one, which also gives up on
+     * the reads among them once abort is set, without touching our other
+     * requests.
+     */
+    virtual Ptr abortable(const Abort &abort);
+
     virtual std::future<GuideCategoryList> guide_categories(
             const std::string &region_code, const std::string &locale);
 
     virtual std::future<SearchListResponse::Ptr> search(
             const std::string &query, unsigned int max_results, const std::string &category_id="");
 
-    virtual std::future<SubscriptionList> subscription_channels();
+    virtual std::future<SubscriptionList> subscription_channels(
+            unsigned int max_results = 50);
 
-    virtual std::future<ChannelList> auth_user_info();
-
-    virtual std::future<std::string> subscription_channel_uploads(std::string const &department_id);
+    /**
+     * The page of subscriptions starting at page_token, or the first page
+     * if it is empty.
+     */
+    virtual std::future<SubscriptionPage> subscription_page(
+            const std::string &page_token, unsigned int max_results = 50);
 
-    virtual std::future<SubscriptionItemList> subscription_items( const std::string &playlistId);
+    virtual std::future<ChannelList> auth_user_info();
 
+    /**
+     * The uploads playlist of a channel. For standard channel ids this is
+     * derived locally without a request, so the caller should fall back to
+     * lookup_channel_uploads() if the derived playlist turns out not to exist.
+     */
+    virtual std::future<std::string> subscription_channel_uploads(std::string const &channel_id);
+
+    /**
+     * Asks YouTube for the uploads playlist of a channel.
+     */
+    virtual std::future<std::string> lookup_channel_uploads(std::string const &channel_id);
+
+    /**
+     * Returns the uploads playlist id for a standard "UC" channel id, or an
+     * empty string.
+     */
+    static std::string derive_uploads_playlist(const std::string &channel_id);
+
+    virtual std::future<SubscriptionItemList> subscription_items( const std::string &playlistId,
+            unsigned int max_results = 50);
+
+    /*
+     * For these, a max_results of 0 leaves the API's default page size.
+     */
     virtual std::future<ChannelList> category_channels(
-            const std::string &categoryId);
+            const std::string &categoryId, unsigned int max_results = 0);
 
     virtual std::future<ChannelList> channels_statistics(
             const std::string &channelId);
@@ -93,16 +141,18 @@ public:
     virtual std::future<ChannelSectionList> channel_sections(
             const std::string &channelId, int maxResults);
 
-    virtual std::future<VideoList> channel_videos(const std::string &channelId);
+    virtual std::future<VideoList> channel_videos(const std::string &channelId,
+            unsigned int max_results = 0);
 
     virtual std::future<VideoList> chart_videos(const std::string &chart_name,
-            const std::string &region_code, const std::string &category_id);
+            const std::string &region_code, const std::string &category_id,
+            unsigned int max_results = 0);
 
     virtual std::future<PlaylistList> channel_playlists(
-            const std::string &channelId);
+            const std::string &channelId, unsigned int max_results = 0);
 
     virtual std::future<PlaylistItemList> playlist_items(
-            const std::string &playlistId);
+            const std::string &playlistId, unsigned int max_results = 0);
 
     virtual std::future<VideoList> videos(const std::string &videoId);
 
@@ -123,13 +173,42 @@ public:
 
     virtual void cancel();
 
+    virtual bool cancelled();
+
+    /**
+     * Requests still waiting to be sent when the deadline passes fail
+     * without being sent, and those that are sent only get the time left.
+     */
+    virtual void set_deadline(const Deadline &deadline);
+
+    virtual Deadline deadline();
+
     virtual bool authenticated();
 
+    /**
+     * The account used by the most recent request or authenticated() check.
+     */
+    virtual unsigned int account_id();
+
+    /**
+     * Data API quota units spent by this client's requests.
+     */
+    virtual unsigned long quota_used();
+
+    /**
+     * Quota units spent by every client since the scope started.
+     */
+    static unsigned long total_quota_used();
+
 protected:
+    Client(const Client &client, const Abort &abort);
+
     class Priv;
     friend Priv;
 
     std::shared_ptr<Priv> p;
+
+    Abort abort_;
 };
 
 }
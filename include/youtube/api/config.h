@@ -67,6 +67,11 @@ struct Config {
      * Have we got access to private APIs?
      */
     bool authenticated = false;
+
+    /*
+     * The online accounts id of the authenticated account
+     */
+    unsigned int account_id = 0;
 };
 
 }
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef YOUTUBE_API_DEADLINE_H_
+#define YOUTUBE_API_DEADLINE_H_
+
+#include <algorithm>
+#include <chrono>
+
+namespace youtube {
+namespace api {
+
+/**
+ * The time a query, or one stage of it, has to finish by.
+ *
+ * Stages take a deadline within their parent's, so however they are
+ * nested, nothing runs past the deadline of the query as a whole.
+ */
+class Deadline {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * A deadline that never passes.
+     */
+    Deadline() :
+            at_(Clock::time_point::max()) {
+    }
+
+    explicit Deadline(std::chrono::milliseconds budget) :
+            at_(Clock::now() + budget) {
+    }
+
+    bool unlimited() const {
+        return at_ == Clock::time_point::max();
+    }
+
+    Clock::time_point time_point() const {
+        return at_;
+    }
+
+    /**
+     * The time left, or milliseconds::max() if there is no deadline.
+     */
+    std::chrono::milliseconds remaining() const {
+        if (unlimited()) {
+            return std::chrono::milliseconds::max();
+        }
+        auto now = Clock::now();
+        if (now >= at_) {
+            return std::chrono::milliseconds(0);
+        }
+        return std::chrono::duration_cast<std::chrono::milliseconds>(at_ - now);
+    }
+
+    bool expired() const {
+        return !unlimited() && Clock::now() >= at_;
+    }
+
+    /**
+     * Whether there is enough time left for a stage that needs this long
+     * to be worth starting.
+     */
+    bool allows(std::chrono::milliseconds needed) const {
+        return remaining() >= needed;
+    }
+
+    /**
+     * A deadline for a stage that should take no longer than limit.
+     */
+    Deadline within(std::chrono::milliseconds limit) const {
+        Deadline stage(limit);
+        stage.at_ = std::min(stage.at_, at_);
+        return stage;
+    }
+
+protected:
+    Clock::time_point at_;
+};
+
+}
+}
+
+#endif // YOUTUBE_API_DEADLINE_H_
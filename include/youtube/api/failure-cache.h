@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_API_FAILURE_CACHE_H_
+#define YOUTUBE_API_FAILURE_CACHE_H_
+
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace youtube {
+namespace api {
+
+/**
+ * Remembers requests that failed in a way that won't change if we ask
+ * again, such as a 404 for a channel that doesn't exist, so for a while
+ * they can fail without going out.
+ */
+class FailureCache {
+public:
+    typedef std::shared_ptr<FailureCache> Ptr;
+
+    static Ptr instance();
+
+    /**
+     * Drops the shared instance, so the next call to instance() starts
+     * afresh. For tests; clients made before keep the old one.
+     */
+    static void reset_instance();
+
+    FailureCache(std::chrono::seconds ttl = std::chrono::minutes(5),
+            std::size_t max_entries = 500);
+
+    /**
+     * Returns true and the error message if the request is known to fail.
+     */
+    bool get(const std::string &request, std::string &message);
+
+    /**
+     * As above, also saying whether it failed because what it asked for
+     * doesn't exist.
+     */
+    bool get(const std::string &request, std::string &message,
+            bool &not_found);
+
+    void put(const std::string &request, const std::string &message,
+            bool not_found = false);
+
+    unsigned long hits();
+
+protected:
+    struct Entry {
+        std::string message;
+
+        bool not_found;
+
+        std::chrono::steady_clock::time_point stored;
+
+        std::list<std::string>::iterator position;
+    };
+
+    std::chrono::seconds ttl_;
+
+    std::size_t max_entries_;
+
+    std::map<std::string, Entry> entries_;
+
+    /* Oldest first */
+    std::list<std::string> order_;
+
+    unsigned long hits_ = 0;
+
+    std::mutex mutex_;
+};
+
+}
+}
+
+#endif // YOUTUBE_API_FAILURE_CACHE_H_
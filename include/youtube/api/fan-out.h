@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_API_FAN_OUT_H_
+#define YOUTUBE_API_FAN_OUT_H_
+
+#include <youtube/api/reactor.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <stdexcept>
+
+namespace youtube {
+namespace api {
+
+/**
+ * Runs a set of independent requests with a bounded number in flight.
+ *
+ * Each branch is started lazily, so no more than max_in_flight requests are
+ * outstanding at any time. A branch that takes longer than branch_timeout
+ * fails with a timeout, and once total_timeout has passed every branch that
+ * hasn't completed yet fails too. Branches given up on like this, or when
+ * a failure is rethrown, have their abort flag set.
+ *
+ * Results are handed over in completion order, along with the index the
+ * branch was added with.
+ */
+template<typename T>
+class FanOut {
+public:
+    typedef std::function<std::future<T>()> Branch;
+
+    /* Shared with the branch's requests, see Client::Abort */
+    typedef std::shared_ptr<std::atomic<bool>> Abort;
+
+    typedef std::function<void(std::size_t index, T &result)> ResultHandler;
+
+    typedef std::function<void(std::size_t index, std::exception_ptr error)> ErrorHandler;
+
+    struct Options {
+        std::size_t max_in_flight;
+
+        std::chrono::milliseconds branch_timeout;
+
+        std::chrono::milliseconds total_timeout;
+    };
+
+    static Options default_options() {
+        return Options { 8, std::chrono::seconds(10), std::chrono::seconds(20) };
+    }
+
+    FanOut(const Options &options = default_options()) :
+            options_(options) {
+        if (options_.max_in_flight == 0) {
+            options_.max_in_flight = 1;
+        }
+    }
+
+    /**
+     * Adds a branch, with a flag to set if we give up on it.
+     */
+    void add(const Branch &branch, const Abort &abort = Abort()) {
+        pending_.emplace_back(Pending { added_++, branch, abort });
+    }
+
+    std::size_t size() const {
+        return pending_.size() + in_flight_.size();
+    }
+
+    /**
+     * Runs every branch, calling on_result as each one completes.
+     *
+     * If on_error is not set, the first failure is rethrown and the
+     * remaining branches are abandoned.
+     */
+    void run(const ResultHandler &on_result,
+            const ErrorHandler &on_error = ErrorHandler()) {
+        typedef std::chrono::steady_clock clock;
+        auto deadline = clock::now() + options_.total_timeout;
+
+        while (!pending_.empty() || !in_flight_.empty()) {
+            while (!pending_.empty()
+                    && in_flight_.size() < options_.max_in_flight) {
+                Pending next = pending_.front();
+                pending_.pop_front();
+
+                InFlight started { next.index, std::future<T>(), clock::now(),
+                        next.abort };
+                std::exception_ptr error;
+                try {
+                    started.future = next.branch();
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                // Outside the handler, so on_error may wait for requests
+                if (error) {
+                    fail(next.index, error, on_error);
+                    continue;
+                }
+                in_flight_.emplace_back(std::move(started));
+            }
+
+            bool progressed = false;
+            auto now = clock::now();
+            for (auto it = in_flight_.begin(); it != in_flight_.end();) {
+                if (it->future.wait_for(std::chrono::seconds(0))
+                        == std::future_status::ready) {
+                    std::size_t index = it->index;
+                    std::future<T> future = std::move(it->future);
+                    it = in_flight_.erase(it);
+                    progressed = true;
+
+                    T result;
+                    std::exception_ptr error;
+                    try {
+                        result = future.get();
+                    } catch (...) {
+                        error = std::current_exception();
+                    }
+                    if (error) {
+                        fail(index, error, on_error);
+                        continue;
+                    }
+                    on_result(index, result);
+                } else if (now - it->started >= options_.branch_timeout
+                        || now >= deadline) {
+                    std::size_t index = it->index;
+                    abandon(*it);
+                    it = in_flight_.erase(it);
+                    progressed = true;
+                    fail(index, timeout(), on_error);
+                } else {
+                    ++it;
+                }
+            }
+
+            if (now >= deadline) {
+                while (!pending_.empty()) {
+                    std::size_t index = pending_.front().index;
+                    pending_.pop_front();
+                    fail(index, timeout(), on_error);
+                }
+            }
+
+            if (!progressed && !in_flight_.empty()) {
+                wait(deadline);
+            }
+        }
+    }
+
+protected:
+    struct Pending {
+        std::size_t index;
+
+        Branch branch;
+
+        Abort abort;
+    };
+
+    struct InFlight {
+        std::size_t index;
+
+        std::future<T> future;
+
+        std::chrono::steady_clock::time_point started;
+
+        Abort abort;
+    };
+
+    static void abandon(InFlight &branch) {
+        if (branch.abort) {
+            *branch.abort = true;
+        }
+    }
+
+    void wait(std::chrono::steady_clock::time_point deadline) {
+        // Give up our thread until any branch completes or times out
+        for (const InFlight &branch : in_flight_) {
+            deadline = std::min(deadline,
+                    branch.started + options_.branch_timeout);
+        }
+        Reactor::wait([this]() {
+            for (const InFlight &branch : in_flight_) {
+                if (branch.future.wait_for(std::chrono::seconds(0))
+                        == std::future_status::ready) {
+                    return true;
+                }
+            }
+            return false;
+        }, deadline);
+    }
+
+    static std::exception_ptr timeout() {
+        return std::make_exception_ptr(std::domain_error("HTTP request timeout"));
+    }
+
+    void fail(std::size_t index, std::exception_ptr error,
+            const ErrorHandler &on_error) {
+        if (!on_error) {
+            pending_.clear();
+            for (InFlight &branch : in_flight_) {
+                abandon(branch);
+            }
+            in_flight_.clear();
+            std::rethrow_exception(error);
+        }
+        on_error(index, error);
+    }
+
+    Options options_;
+
+    std::size_t added_ = 0;
+
+    std::deque<Pending> pending_;
+
+    std::list<InFlight> in_flight_;
+};
+
+}
+}
+
+#endif // YOUTUBE_API_FAN_OUT_H_
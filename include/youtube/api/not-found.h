@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_API_NOT_FOUND_H_
+#define YOUTUBE_API_NOT_FOUND_H_
+
+#include <exception>
+#include <stdexcept>
+
+namespace youtube {
+namespace api {
+
+/**
+ * Raised when YouTube says what was asked for doesn't exist, such as a
+ * playlist that has been deleted. Unlike other failures, asking again won't
+ * help.
+ */
+class NotFound: public std::domain_error {
+public:
+    using std::domain_error::domain_error;
+
+    /**
+     * Whether a failure handed over as an exception_ptr is a NotFound.
+     */
+    static bool raised_by(std::exception_ptr error) {
+        try {
+            std::rethrow_exception(error);
+        } catch (NotFound &) {
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+};
+
+}
+}
+
+#endif // YOUTUBE_API_NOT_FOUND_H_
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_API_QUOTA_BUDGET_H_
+#define YOUTUBE_API_QUOTA_BUDGET_H_
+
+#include <youtube/api/scheduler.h>
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace youtube {
+namespace api {
+
+/**
+ * Keeps track of the Data API quota units spent by the whole process over
+ * the last day, and how careful we need to be with the rest.
+ *
+ * As the budget runs low we first stop prefetching, then serve browse
+ * content from whatever we have cached, and finally stop making requests
+ * and serve stale results. Once YouTube tells us the quota is exceeded we
+ * stay at that last level until the quota resets.
+ */
+class QuotaBudget {
+public:
+    typedef std::shared_ptr<QuotaBudget> Ptr;
+
+    typedef std::chrono::system_clock Clock;
+
+    enum class Level {
+        normal,
+        /* No background requests */
+        shed_background,
+        /* Browse content is served from cache however old it is */
+        cache_only,
+        /* No requests at all, only stale results */
+        exhausted
+    };
+
+    struct Thresholds {
+        /* Fractions of the daily limit */
+        double shed_background;
+
+        double cache_only;
+
+        double exhausted;
+    };
+
+    struct Stats {
+        unsigned long spent = 0;
+
+        unsigned long refused = 0;
+
+        unsigned long quota_exceeded = 0;
+
+        unsigned long queries = 0;
+
+        /* Units spent by the queries counted above */
+        unsigned long query_units = 0;
+
+        unsigned long peak_query_units = 0;
+    };
+
+    static Ptr instance();
+
+    /**
+     * Drops the shared instance, so the next call to instance() starts
+     * afresh. For tests; clients made before keep the old one.
+     */
+    static void reset_instance();
+
+    QuotaBudget(unsigned long daily_limit = 10000,
+            const Thresholds &thresholds = Thresholds { 0.7, 0.85, 0.95 });
+
+    /**
+     * Quota units charged for a request to a resource, such as "search".
+     */
+    static unsigned int cost(const std::string &resource, bool write);
+
+    void set_daily_limit(unsigned long daily_limit);
+
+    /**
+     * Records units spent on a request that is going out.
+     */
+    void charge(unsigned int units);
+
+    /**
+     * Whether a request of the given priority may go out now. Refusals
+     * are counted.
+     */
+    bool admit(Scheduler::Priority priority);
+
+    /**
+     * Records what one query spent, for the per query statistics.
+     */
+    void record_query(unsigned long units);
+
+    /**
+     * YouTube says the quota is gone, so stop until it resets.
+     */
+    void quota_exceeded();
+
+    Level level();
+
+    /**
+     * Units spent over the last day.
+     */
+    unsigned long spent();
+
+    Stats stats();
+
+    void dump_stats(std::ostream &out);
+
+protected:
+    struct Bucket {
+        Clock::time_point start;
+
+        unsigned long units;
+    };
+
+    /**
+     * The next time the quota resets, at midnight Pacific time.
+     */
+    static Clock::time_point next_reset(Clock::time_point now);
+
+    void expire(Clock::time_point now);
+
+    Level level_locked(Clock::time_point now);
+
+    unsigned long daily_limit_;
+
+    Thresholds thresholds_;
+
+    std::deque<Bucket> buckets_;
+
+    unsigned long spent_ = 0;
+
+    Clock::time_point blocked_until_;
+
+    Stats stats_;
+
+    std::mutex mutex_;
+};
+
+}
+}
+
+#endif // YOUTUBE_API_QUOTA_BUDGET_H_
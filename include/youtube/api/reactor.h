@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_API_REACTOR_H_
+#define YOUTUBE_API_REACTOR_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace youtube {
+namespace api {
+
+/**
+ * Runs tasks as fibers on a small, fixed set of threads.
+ *
+ * A task that waits for a request with await() is suspended until the
+ * response arrives, instead of holding on to a thread, so any number of slow
+ * requests can be outstanding at once. The client wakes the reactor up
+ * whenever a request completes.
+ *
+ * A task stays on the thread it started on. Anything else that blocks, such
+ * as pushing results to the shell, only holds up the tasks of that thread,
+ * and work that may block for long, such as a D-Bus call, should be handed
+ * to offload(), which runs it on a few threads of the reactor's own.
+ *
+ * Outside of a task, await() simply blocks, so code can be shared between
+ * tasks and ordinary threads.
+ */
+class Reactor {
+public:
+    typedef std::shared_ptr<Reactor> Ptr;
+
+    typedef std::function<void()> Task;
+
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    struct Stats {
+        unsigned long spawned = 0;
+
+        unsigned long completed = 0;
+
+        std::size_t active = 0;
+
+        std::size_t peak_active = 0;
+
+        unsigned long offloaded = 0;
+    };
+
+    Reactor(std::size_t threads = 4, std::size_t stack_size = 512 * 1024,
+            std::size_t offload_threads = 2);
+
+    ~Reactor();
+
+    void start();
+
+    /**
+     * Wakes every suspended task with an error, and waits for all of them to
+     * finish. Offloaded work that hasn't started is dropped, and work that
+     * has is waited for.
+     */
+    void stop();
+
+    /**
+     * Runs the task on one of the reactor threads.
+     *
+     * Returns false if the reactor isn't running, in which case the task
+     * hasn't been run.
+     */
+    bool spawn(const Task &task);
+
+    Stats stats();
+
+    /**
+     * True when called from a task.
+     */
+    static bool in_task();
+
+    /**
+     * Suspends the calling task until ready() returns true or the deadline
+     * passes, and returns the last value of ready().
+     *
+     * Must only be called from a task, and never from inside a catch block.
+     * Throws if the reactor is stopped while we are waiting.
+     */
+    static bool suspend(const std::function<bool()> &ready,
+            TimePoint deadline);
+
+    /**
+     * Like suspend(), but outside of a task it blocks the thread instead,
+     * checking ready() again whenever notify_all() is called.
+     */
+    static bool wait(const std::function<bool()> &ready, TimePoint deadline);
+
+    /**
+     * Waits for the future, suspending the calling task if there is one.
+     */
+    template<typename T>
+    static std::future_status await(std::future<T> &future,
+            std::chrono::steady_clock::duration timeout) {
+        if (!in_task()) {
+            return future.wait_for(timeout);
+        }
+
+        bool ready = suspend([&future]() {
+            return future.wait_for(std::chrono::seconds(0))
+                    == std::future_status::ready;
+        }, std::chrono::steady_clock::now() + timeout);
+        return ready ? std::future_status::ready : std::future_status::timeout;
+    }
+
+    /**
+     * Runs blocking work on one of the offload threads of the task's
+     * reactor, suspending only the calling task until it is done. Work
+     * queues up while every offload thread is busy. Outside of a task the
+     * work is simply run.
+     *
+     * The task may give up waiting if the reactor stops, so the work must
+     * not refer to anything the caller owns.
+     */
+    template<typename T>
+    static T offload(const std::function<T()> &work) {
+        if (!in_task()) {
+            return work();
+        }
+
+        auto result = std::make_shared<std::promise<T>>();
+        std::future<T> future = result->get_future();
+        queue_offload([work, result]() {
+            try {
+                result->set_value(work());
+            } catch (...) {
+                result->set_exception(std::current_exception());
+            }
+        });
+
+        suspend([&future]() {
+            return future.wait_for(std::chrono::seconds(0))
+                    == std::future_status::ready;
+        }, TimePoint::max());
+        return future.get();
+    }
+
+    /**
+     * Lets every reactor, and every thread in wait(), know something may
+     * have become ready.
+     */
+    static void notify_all();
+
+protected:
+    class Fiber;
+
+    /* The fibers that started on one thread */
+    struct Worker {
+        std::list<std::unique_ptr<Fiber>> fibers;
+
+        std::thread thread;
+    };
+
+    void run(Worker &worker);
+
+    /**
+     * Hands work to the offload threads of the calling task's reactor.
+     */
+    static void queue_offload(const Task &work);
+
+    void run_offloaded();
+
+    void notify();
+
+    std::size_t threads_;
+
+    std::size_t stack_size_;
+
+    std::size_t offload_threads_;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::vector<std::thread> offloaders_;
+
+    std::list<Task> spawned_;
+
+    std::list<Task> offloaded_;
+
+    Stats stats_;
+
+    unsigned long notifications_ = 0;
+
+    bool running_ = false;
+
+    bool stopping_ = false;
+
+    std::mutex mutex_;
+
+    std::condition_variable wakeup_;
+
+    std::condition_variable offload_wakeup_;
+
+    static thread_local Fiber *current_;
+};
+
+}
+}
+
+#endif // YOUTUBE_API_REACTOR_H_
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_API_SCHEDULER_H_
+#define YOUTUBE_API_SCHEDULER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+
+namespace youtube {
+namespace api {
+
+/**
+ * Decides when the requests of every client in the process go out.
+ *
+ * Only a limited number of requests are in flight at once. Waiting requests
+ * are started in priority order, a few slots are kept free for interactive
+ * requests, and background requests only ever get a small share, so a burst
+ * of prefetching can't hold up anything the user is waiting for.
+ */
+class Scheduler: public std::enable_shared_from_this<Scheduler> {
+public:
+    typedef std::shared_ptr<Scheduler> Ptr;
+
+    enum class Priority {
+        /* Activations and previews */
+        interactive,
+        /* Searches and surfacing */
+        foreground,
+        /* Prefetching and refreshing caches */
+        background
+    };
+
+    struct Limits {
+        /* Requests in flight across the whole process */
+        std::size_t max_in_flight;
+
+        /* Slots only interactive requests may use */
+        std::size_t reserved_interactive;
+
+        /* Most slots background requests may use at once */
+        std::size_t max_background;
+    };
+
+    struct Stats {
+        unsigned long started = 0;
+
+        std::size_t queued = 0;
+
+        std::size_t peak_queued = 0;
+    };
+
+    /**
+     * Called when the request may go out, with a function it must call once
+     * the request has completed.
+     */
+    typedef std::function<void(const std::function<void()> &finished)> Job;
+
+    static Ptr instance();
+
+    /**
+     * Drops the shared instance, so the next call to instance() starts
+     * afresh. For tests; clients made before keep the old one.
+     */
+    static void reset_instance();
+
+    Scheduler(const Limits &limits = Limits { 12, 2, 4 });
+
+    void set_limits(const Limits &limits);
+
+    Limits limits();
+
+    Stats stats(Priority priority);
+
+    std::size_t in_flight();
+
+    /**
+     * Queues a request on behalf of owner, starting it straight away if
+     * there is a free slot.
+     */
+    void submit(const void *owner, Priority priority, const Job &job);
+
+    /**
+     * Drops the queued requests of owner and releases the slots of its
+     * requests in flight. Waits for any of its requests that are being
+     * started right now.
+     */
+    void forget(const void *owner);
+
+protected:
+    struct Queued {
+        unsigned long ticket;
+
+        const void *owner;
+
+        Job job;
+    };
+
+    std::size_t capacity(Priority priority) const;
+
+    void finished(unsigned long ticket);
+
+    void dispatch();
+
+    Limits limits_;
+
+    std::map<Priority, std::deque<Queued>> queued_;
+
+    std::map<Priority, Stats> stats_;
+
+    std::map<unsigned long, const void *> in_flight_;
+
+    std::multiset<const void *> starting_;
+
+    unsigned long next_ticket_ = 0;
+
+    std::mutex mutex_;
+
+    std::condition_variable started_;
+};
+
+}
+}
+
+#endif // YOUTUBE_API_SCHEDULER_H_
@@ -21,6 +21,7 @@
 
 #include <youtube/api/resource.h>
 
+#include <cstdint>
 #include <memory>
 
 namespace Json {
@@ -52,6 +53,11 @@ public:
 
     const std::string & video_id() const ;
 
+    /**
+     * Seconds since the epoch, or 0 if YouTube didn't say.
+     */
+    std::int64_t published_at() const;
+
     Kind kind() const override;
 
     std::string kind_str() const override;
@@ -70,6 +76,8 @@ protected:
     std::string picture_;
 
     std::string description_;
+
+    std::int64_t published_at_ = 0;
 };
 
 }
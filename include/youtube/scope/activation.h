@@ -21,6 +21,9 @@
 #define SCOPE_ACTIVATIOIN_H_
 
 #include <youtube/api/client.h>
+#include <youtube/scope/browse-cache.h>
+#include <youtube/scope/department-cache.h>
+#include <youtube/scope/result-cache.h>
 
 #include <unity/scopes/ActivationQueryBase.h>
 
@@ -45,7 +48,10 @@ public:
     Activation(const unity::scopes::Result &result,
            const unity::scopes::ActionMetadata & metadata,
            std::string const& action_id,
-           std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client);
+           std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client,
+           DepartmentCache::Ptr department_cache,
+           ResultCache::Ptr result_cache,
+           BrowseCache::Ptr browse_cache);
 
     ~Activation() = default;
 
@@ -55,9 +61,17 @@ public:
      virtual unity::scopes::ActivationResponse activate() override;
 
 private:
+    void results_changed();
+
     std::string const action_id_;
     
     youtube::api::Client client_;
+
+    DepartmentCache::Ptr department_cache_;
+
+    ResultCache::Ptr result_cache_;
+
+    BrowseCache::Ptr browse_cache_;
 };
 
 }
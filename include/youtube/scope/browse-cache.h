@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_SCOPE_BROWSE_CACHE_H_
+#define YOUTUBE_SCOPE_BROWSE_CACHE_H_
+
+#include <youtube/api/client.h>
+#include <youtube/api/quota-budget.h>
+#include <youtube/scope/partial-reply.h>
+
+#include <unity/scopes/OnlineAccountClient.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * Stale-while-revalidate cache for browse content.
+ *
+ * An entry younger than the soft TTL of its department type is served as is.
+ * Between the soft and hard TTLs it is still served, but a refresh is queued
+ * so the next query gets fresh data. Past the hard TTL it is fetched again
+ * before returning, unless the quota budget is running low.
+ *
+ * Lists that are missing branches, because some of their requests failed,
+ * are served but never stored. The least recently used entries are dropped
+ * once there are more than max_entries.
+ *
+ * The policies can be set with YOUTUBE_SCOPE_BROWSE_POLICY, for example
+ * "playlist=300:3600,guideCategory-videos=900:7200", with the soft and hard
+ * TTLs in seconds.
+ */
+class BrowseCache {
+public:
+    typedef std::shared_ptr<BrowseCache> Ptr;
+
+    enum class Type {
+        category_videos, category_playlists, category_channels, playlist
+    };
+
+    struct Policy {
+        std::chrono::seconds soft_ttl;
+
+        std::chrono::seconds hard_ttl;
+    };
+
+    struct Stats {
+        unsigned long fresh = 0;
+
+        unsigned long stale = 0;
+
+        unsigned long misses = 0;
+
+        unsigned long refreshes = 0;
+
+        unsigned long failed_refreshes = 0;
+
+        /* Fetched lists that were missing branches, so weren't stored */
+        unsigned long degraded = 0;
+    };
+
+    template<typename T>
+    using Fetch = std::function<T(youtube::api::Client &, const PartialReply::Ptr &)>;
+
+    BrowseCache(std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client,
+            std::size_t max_entries = 500);
+
+    ~BrowseCache();
+
+    void set_policy(Type type, const Policy &policy);
+
+    Policy policy(Type type);
+
+    /**
+     * Reads policies in the YOUTUBE_SCOPE_BROWSE_POLICY format, leaving
+     * the types it doesn't mention alone.
+     */
+    void configure(const std::string &policies);
+
+    Stats stats(Type type);
+
+    /**
+     * Prints the serving statistics of every department type.
+     */
+    void dump_stats(std::ostream &out);
+
+    /**
+     * Cancels outstanding refreshes and stops the refresh thread.
+     */
+    void stop();
+
+    std::size_t size();
+
+    /**
+     * Drops the entries of one type fetched for an account, because the
+     * account has changed them, for example by adding to Watch Later.
+     */
+    void invalidate(Type type, const std::string &account);
+
+    /**
+     * Returns the cached value for the key, calling fetch with the given
+     * client when there is no usable entry. Branches the fetch had to skip
+     * are recorded in partial.
+     */
+    template<typename T>
+    T get(Type type, const std::string &key, youtube::api::Client &client,
+            const PartialReply::Ptr &partial, const Fetch<T> &fetch) {
+        std::string full_key = make_key(type, key);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(full_key);
+            if (it != entries_.end()) {
+                recently_used_.splice(recently_used_.begin(), recently_used_,
+                        it->second.position);
+                auto age = std::chrono::steady_clock::now() - it->second.stored;
+                const Policy &policy = policies_[type];
+                std::shared_ptr<const T> value = std::static_pointer_cast<
+                        const T>(it->second.value);
+
+                if (age < policy.soft_ttl) {
+                    ++stats_[type].fresh;
+                    return *value;
+                }
+
+                // Save what quota we have left for searches
+                if (youtube::api::QuotaBudget::instance()->level()
+                        >= youtube::api::QuotaBudget::Level::cache_only) {
+                    ++stats_[type].stale;
+                    return *value;
+                }
+
+                if (age < policy.hard_ttl) {
+                    ++stats_[type].stale;
+                    if (!it->second.refreshing) {
+                        it->second.refreshing = true;
+                        queue_refresh(type, full_key,
+                                [fetch](youtube::api::Client &client) {
+                                    auto fetched = std::make_shared<PartialReply>();
+                                    auto value = std::make_shared<const T>(
+                                            fetch(client, fetched));
+                                    // Better the old list than one with holes
+                                    return fetched->degraded() ?
+                                            std::shared_ptr<const void>() :
+                                            std::shared_ptr<const void>(value);
+                                });
+                    }
+                    return *value;
+                }
+
+                erase(it);
+            }
+            ++stats_[type].misses;
+        }
+
+        auto fetched = std::make_shared<PartialReply>();
+        T value = fetch(client, fetched);
+        if (fetched->degraded()) {
+            if (partial) {
+                partial->merge(fetched->skipped());
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_[type].degraded;
+        } else {
+            store(full_key, std::make_shared<const T>(value), false);
+        }
+        return value;
+    }
+
+protected:
+    typedef std::function<std::shared_ptr<const void>(youtube::api::Client &)> Fetcher;
+
+    struct Refresh {
+        Type type;
+
+        std::string key;
+
+        Fetcher fetch;
+    };
+
+    struct Entry {
+        std::shared_ptr<const void> value;
+
+        std::chrono::steady_clock::time_point stored;
+
+        bool refreshing = false;
+
+        std::list<std::string>::iterator position;
+    };
+
+    static std::string make_key(Type type, const std::string &key);
+
+    /**
+     * A refresh only replaces an entry that is still waiting for it, so one
+     * that was dropped in the meantime doesn't come back.
+     */
+    void store(const std::string &full_key, std::shared_ptr<const void> value,
+            bool refresh);
+
+    void erase(std::map<std::string, Entry>::iterator it);
+
+    void queue_refresh(Type type, const std::string &full_key,
+            const Fetcher &fetch);
+
+    void run();
+
+    std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client_;
+
+    std::size_t max_entries_;
+
+    std::map<Type, Policy> policies_;
+
+    std::map<Type, Stats> stats_;
+
+    std::map<std::string, Entry> entries_;
+
+    std::list<std::string> recently_used_;
+
+    std::deque<Refresh> refreshes_;
+
+    std::shared_ptr<youtube::api::Client> client_;
+
+    bool running_ = false;
+
+    bool stopped_ = false;
+
+    std::mutex mutex_;
+
+    std::condition_variable wakeup_;
+
+    std::thread worker_;
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_BROWSE_CACHE_H_
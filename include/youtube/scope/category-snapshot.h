@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_SCOPE_CATEGORY_SNAPSHOT_H_
+#define YOUTUBE_SCOPE_CATEGORY_SNAPSHOT_H_
+
+#include <youtube/api/client.h>
+#include <youtube/scope/featured-playlist-cache.h>
+#include <youtube/scope/result-budget.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * Everything needed to render a guide category surface: the category's
+ * chart, and the featured playlist of each of its channels.
+ */
+struct CategorySnapshot {
+    typedef std::shared_ptr<const CategorySnapshot> SCPtr;
+
+    struct Section {
+        youtube::api::Channel::Ptr channel;
+
+        youtube::api::Client::PlaylistItemList items;
+    };
+
+    std::string category_id;
+
+    /* Most popular videos of the category, when browsing by chart */
+    youtube::api::Client::VideoList chart;
+
+    std::deque<Section> sections;
+
+    /* Channels left out because fetching them failed */
+    std::vector<std::string> skipped;
+
+    /**
+     * Fetches the surface of a guide category. Channels whose featured
+     * playlist is cached go straight to fetching the playlist. Channels
+     * that fail are left out, unless every one of them does. With a
+     * limited budget, only enough channels to fill it are fetched.
+     */
+    static SCPtr fetch(youtube::api::Client &client,
+            const std::string &category_id,
+            FeaturedPlaylistCache::Ptr featured_playlists =
+                    FeaturedPlaylistCache::Ptr(),
+            const ResultBudget &budget = ResultBudget());
+
+    /**
+     * Fetches the surface of a guide category from its chart in a single
+     * request, and only goes to the channels for the videos the chart
+     * couldn't supply. Categories without a matching video category are
+     * fetched channel by channel.
+     */
+    static SCPtr fetch_by_chart(youtube::api::Client &client,
+            const std::string &category_id, const std::string &country_code,
+            FeaturedPlaylistCache::Ptr featured_playlists =
+                    FeaturedPlaylistCache::Ptr(),
+            const ResultBudget &budget = ResultBudget());
+
+    /**
+     * Returns the video category matching a guide category, or an empty
+     * string if there isn't one.
+     */
+    static std::string video_category(const std::string &category_id);
+
+    /**
+     * Compares the channels and videos of two snapshots.
+     */
+    bool same_content(const CategorySnapshot &other) const;
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_CATEGORY_SNAPSHOT_H_
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_SCOPE_CHANNEL_VIDEOS_H_
+#define YOUTUBE_SCOPE_CHANNEL_VIDEOS_H_
+
+#include <youtube/api/client.h>
+#include <youtube/scope/partial-reply.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * Lists the most viewed videos of a set of channels.
+ */
+class ChannelVideos {
+public:
+    enum class Strategy {
+        /* search.list ordered by view count, at 100 quota units a channel */
+        search,
+
+        /* The uploads playlist of each channel, then a batched videos.list
+         * for the view counts, at a unit or two a channel */
+        uploads
+    };
+
+    /**
+     * Returns the videos of each channel, in the order of channel_ids.
+     * Channels without an uploads playlist fall back to search, but only
+     * while the quota budget is at its normal level and search isn't
+     * failing. Given a partial reply, channels that still fail or that
+     * weren't searched are recorded there and left empty, rather than
+     * failing the whole call.
+     */
+    static std::vector<youtube::api::Client::VideoList> fetch(
+            youtube::api::Client &client,
+            const std::vector<std::string> &channel_ids, Strategy strategy,
+            std::size_t per_channel = 5,
+            PartialReply::Ptr partial = PartialReply::Ptr());
+
+protected:
+    static void fetch_by_search(youtube::api::Client &client,
+            const std::vector<std::string> &channel_ids,
+            const std::vector<std::size_t> &indexes, std::size_t per_channel,
+            std::vector<youtube::api::Client::VideoList> &result,
+            PartialReply::Ptr partial);
+
+    /**
+     * Returns the indexes of the channels that need to fall back to search.
+     * Channels whose uploads or statistics couldn't be fetched are recorded
+     * in the partial reply instead.
+     */
+    static std::vector<std::size_t> fetch_by_uploads(
+            youtube::api::Client &client,
+            const std::vector<std::string> &channel_ids,
+            std::size_t per_channel,
+            std::vector<youtube::api::Client::VideoList> &result,
+            PartialReply::Ptr partial);
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_CHANNEL_VIDEOS_H_
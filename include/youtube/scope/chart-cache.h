@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_SCOPE_CHART_CACHE_H_
+#define YOUTUBE_SCOPE_CHART_CACHE_H_
+
+#include <youtube/api/client.h>
+
+#include <unity/scopes/OnlineAccountClient.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * Shares chart results, such as the most popular videos, between every
+ * query for the same region.
+ *
+ * Charts are the same for all users, so they are kept for a long time and
+ * refreshed in the background for the regions that are actually being asked
+ * for. Once a chart has been fetched, queries for it don't wait on the
+ * network again.
+ */
+class ChartCache {
+public:
+    typedef std::shared_ptr<ChartCache> Ptr;
+
+    typedef std::shared_ptr<const youtube::api::Client::VideoList> VideosPtr;
+
+    struct Key {
+        std::string chart;
+
+        std::string country_code;
+
+        std::string category_id;
+
+        /* 0 for the API's default page size */
+        unsigned int max_results;
+    };
+
+    struct Stats {
+        unsigned long hits = 0;
+
+        unsigned long misses = 0;
+
+        unsigned long refreshes = 0;
+
+        unsigned long failed_refreshes = 0;
+    };
+
+    ChartCache(std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client,
+            std::chrono::seconds interval = std::chrono::minutes(20),
+            std::chrono::seconds jitter = std::chrono::minutes(4),
+            std::chrono::seconds max_age = std::chrono::hours(6));
+
+    ~ChartCache();
+
+    void start();
+
+    void stop();
+
+    /**
+     * Returns the chart, or nullptr if we don't have a recent enough copy.
+     */
+    VideosPtr get(const Key &key);
+
+    /**
+     * Stores a chart fetched by a query, and keeps it refreshed from now on.
+     */
+    void put(const Key &key, const youtube::api::Client::VideoList &videos);
+
+    void set_online(bool online);
+
+    Stats stats();
+
+    void dump_stats(std::ostream &out);
+
+protected:
+    struct Slot {
+        Key key;
+
+        VideosPtr videos;
+
+        std::chrono::steady_clock::time_point fetched;
+
+        std::chrono::steady_clock::time_point last_used;
+    };
+
+    static std::string make_key(const Key &key);
+
+    std::chrono::steady_clock::duration next_interval();
+
+    void run();
+
+    void refresh();
+
+    std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client_;
+
+    std::chrono::seconds interval_;
+
+    std::chrono::seconds jitter_;
+
+    std::chrono::seconds max_age_;
+
+    std::mt19937 random_;
+
+    std::map<std::string, Slot> slots_;
+
+    std::atomic<bool> online_;
+
+    bool running_ = false;
+
+    Stats stats_;
+
+    std::shared_ptr<youtube::api::Client> client_;
+
+    std::mutex mutex_;
+
+    std::condition_variable wakeup_;
+
+    std::thread worker_;
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_CHART_CACHE_H_
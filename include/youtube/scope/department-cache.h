@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_SCOPE_DEPARTMENT_CACHE_H_
+#define YOUTUBE_SCOPE_DEPARTMENT_CACHE_H_
+
+#include <youtube/api/channel.h>
+
+#include <unity/scopes/Department.h>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * Keeps the department tree built during surfacing, so that navigating
+ * between departments doesn't have to re-fetch the guide categories and
+ * the user's subscriptions every time.
+ *
+ * Entries are keyed by locale, country code and account.
+ */
+class DepartmentCache {
+public:
+    typedef std::shared_ptr<DepartmentCache> Ptr;
+
+    struct Entry {
+        typedef std::shared_ptr<const Entry> SCPtr;
+
+        /*
+         * The root department, with all of its sub-departments
+         */
+        unity::scopes::Department::SCPtr departments;
+
+        /*
+         * The id of the guide category shown on the initial surfacing screen
+         */
+        std::string home_category;
+
+        /*
+         * The authenticated user's channel, if any
+         */
+        youtube::api::Channel::Ptr user;
+
+        /*
+         * The user's own playlists, keyed by their translated name
+         */
+        std::map<std::string, std::string> playlists;
+    };
+
+    DepartmentCache(std::chrono::seconds ttl = std::chrono::minutes(10));
+
+    ~DepartmentCache() = default;
+
+    static std::string make_key(const std::string &locale,
+            const std::string &country_code, const std::string &account);
+
+    /**
+     * Returns nullptr if there is no entry, or the entry has expired.
+     */
+    Entry::SCPtr get(const std::string &key);
+
+    void put(const std::string &key, const std::string &account,
+            Entry::SCPtr entry);
+
+    /**
+     * Drops every entry belonging to the given account, e.g. after the user
+     * subscribed to or unsubscribed from a channel.
+     */
+    void invalidate(const std::string &account);
+
+    void clear();
+
+protected:
+    struct Slot {
+        Entry::SCPtr entry;
+
+        std::string account;
+
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    std::chrono::seconds ttl_;
+
+    std::map<std::string, Slot> slots_;
+
+    std::mutex mutex_;
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_DEPARTMENT_CACHE_H_
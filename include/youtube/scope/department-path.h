@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef YOUTUBE_SCOPE_DEPARTMENT_PATH_H_
+#define YOUTUBE_SCOPE_DEPARTMENT_PATH_H_
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <sstream>
+#include <string>
+
+namespace youtube {
+namespace scope {
+
+enum class DepartmentType {
+    guide_category, channel, playlist, aggregated, subscriptions, subscription,
+    subscription_feed
+};
+
+enum class SectionType {
+    none, videos, playlists, channels
+};
+
+/**
+ * This class helps to encode/decode the department identity to/from string form
+ */
+struct DepartmentPath {
+    DepartmentType department_type;
+    std::string department;
+    SectionType section_type = SectionType::none;
+
+    DepartmentPath(DepartmentType department_type_, const std::string &department_,
+            SectionType section_type_ = SectionType::none) :
+            department_type(department_type_), department(department_), section_type(
+                    section_type_) {
+    }
+
+    DepartmentPath(const std::string &s) {
+        if (boost::algorithm::starts_with(s, "guideCategory:")) {
+            department_type = DepartmentType::guide_category;
+        } else if (boost::algorithm::starts_with(s,"guideCategory-videos:")) {
+            department_type = DepartmentType::guide_category;
+            section_type = SectionType::videos;
+        } else if (boost::algorithm::starts_with(s, "guideCategory-playlists:")) {
+            department_type = DepartmentType::guide_category;
+            section_type = SectionType::playlists;
+        } else if (boost::algorithm::starts_with(s, "guideCategory-channels:")) {
+            department_type = DepartmentType::guide_category;
+            section_type = SectionType::channels;
+        } else if (boost::algorithm::starts_with(s, "channel:")) {
+            department_type = DepartmentType::channel;
+        } else if (boost::algorithm::starts_with(s, "playlist:")) {
+            department_type = DepartmentType::playlist;
+        } else if (boost::algorithm::starts_with(s, "aggregated:")) {
+            department_type = DepartmentType::aggregated;
+        } else if (boost::algorithm::starts_with(s, "subscriptions:")) {
+            department_type = DepartmentType::subscriptions;
+        } else if (boost::algorithm::starts_with(s, "subscription:")) {
+            department_type = DepartmentType::subscription;
+        } else if (boost::algorithm::starts_with(s, "subscription-feed:")) {
+            department_type = DepartmentType::subscription_feed;
+        }
+
+        department = s.substr(s.find(':') + 1);
+    }
+
+    std::string to_string() const {
+        std::ostringstream result;
+        switch (department_type) {
+        case DepartmentType::guide_category: {
+            switch (section_type) {
+            case SectionType::none:
+                result << "guideCategory:";
+                break;
+            case SectionType::videos:
+                result << "guideCategory-videos:";
+                break;
+            case SectionType::playlists:
+                result << "guideCategory-playlists:";
+                break;
+            case SectionType::channels:
+                result << "guideCategory-channels:";
+                break;
+            }
+            break;
+        }
+        case DepartmentType::playlist:
+            result << "playlist:";
+            break;
+        case DepartmentType::channel:
+            result << "channel:";
+            break;
+        case DepartmentType::aggregated:
+            result << "aggregated:";
+            break;
+        case DepartmentType::subscriptions:
+            result << "subscriptions:";
+            break;
+        case DepartmentType::subscription:
+            result << "subscription:";
+            break;
+        case DepartmentType::subscription_feed:
+            result << "subscription-feed:";
+            break;
+        }
+
+        result << department;
+        return result.str();
+    }
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_DEPARTMENT_PATH_H_
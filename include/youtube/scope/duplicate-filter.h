@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_SCOPE_DUPLICATE_FILTER_H_
+#define YOUTUBE_SCOPE_DUPLICATE_FILTER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <unordered_set>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * Drops items we have already seen while merging lists from several
+ * sources, such as the uploads of every channel in a category.
+ */
+class DuplicateFilter {
+public:
+    DuplicateFilter(std::size_t expected) {
+        seen_.reserve(expected);
+    }
+
+    ~DuplicateFilter() {
+        total() += suppressed_;
+    }
+
+    /**
+     * Returns true the first time an id is seen.
+     */
+    bool first(const std::string &id) {
+        if (seen_.insert(id).second) {
+            return true;
+        }
+        ++suppressed_;
+        return false;
+    }
+
+    std::size_t suppressed() const {
+        return suppressed_;
+    }
+
+    /**
+     * Duplicates suppressed by every filter since the scope started.
+     */
+    static unsigned long total_suppressed() {
+        return total();
+    }
+
+protected:
+    static std::atomic<unsigned long> & total() {
+        static std::atomic<unsigned long> total(0);
+        return total;
+    }
+
+    std::unordered_set<std::string> seen_;
+
+    std::size_t suppressed_ = 0;
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_DUPLICATE_FILTER_H_
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_SCOPE_FEATURED_PLAYLIST_CACHE_H_
+#define YOUTUBE_SCOPE_FEATURED_PLAYLIST_CACHE_H_
+
+#include <youtube/api/client.h>
+
+#include <unity/scopes/OnlineAccountClient.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * Remembers the playlist of the first section of each channel, which is
+ * what a guide category surface shows for it.
+ *
+ * These hardly ever change, so the mappings are kept on disk and served
+ * for a long time. Once an entry is older than the TTL it is still served,
+ * but the channel's sections are looked up again in the background.
+ */
+class FeaturedPlaylistCache {
+public:
+    typedef std::shared_ptr<FeaturedPlaylistCache> Ptr;
+
+    struct Stats {
+        unsigned long fresh = 0;
+
+        unsigned long stale = 0;
+
+        unsigned long misses = 0;
+
+        unsigned long revalidations = 0;
+
+        unsigned long changed = 0;
+    };
+
+    /**
+     * With an empty path the mappings are only kept in memory.
+     */
+    FeaturedPlaylistCache(
+            std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client,
+            const std::string &path = std::string(),
+            std::chrono::seconds ttl = std::chrono::hours(7 * 24));
+
+    ~FeaturedPlaylistCache();
+
+    void load();
+
+    /**
+     * Writes the mappings out, if anything has changed.
+     */
+    void save();
+
+    /**
+     * Cancels outstanding revalidations and stops the revalidation thread.
+     */
+    void stop();
+
+    /**
+     * Looks up the featured playlist of a channel, which may be empty if the
+     * channel has none. Returns false if we don't know.
+     */
+    bool get(const std::string &channel_id, std::string &playlist_id);
+
+    void put(const std::string &channel_id, const std::string &playlist_id);
+
+    /**
+     * Forgets a channel, for example because its playlist has gone away.
+     */
+    void invalidate(const std::string &channel_id);
+
+    /**
+     * The playlist of the first section that has one.
+     */
+    static std::string featured_playlist(
+            const youtube::api::Client::ChannelSectionList &sections);
+
+    Stats stats();
+
+    void dump_stats(std::ostream &out);
+
+protected:
+    struct Entry {
+        std::string playlist_id;
+
+        /* Seconds since the epoch */
+        std::int64_t verified;
+
+        bool revalidating = false;
+    };
+
+    void run();
+
+    std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client_;
+
+    std::string path_;
+
+    std::chrono::seconds ttl_;
+
+    std::map<std::string, Entry> entries_;
+
+    std::deque<std::string> revalidations_;
+
+    Stats stats_;
+
+    bool dirty_ = false;
+
+    std::shared_ptr<youtube::api::Client> client_;
+
+    bool running_ = false;
+
+    bool stopped_ = false;
+
+    std::mutex mutex_;
+
+    std::condition_variable wakeup_;
+
+    std::thread worker_;
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_FEATURED_PLAYLIST_CACHE_H_
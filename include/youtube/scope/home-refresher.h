@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_SCOPE_HOME_REFRESHER_H_
+#define YOUTUBE_SCOPE_HOME_REFRESHER_H_
+
+#include <youtube/scope/category-snapshot.h>
+
+#include <unity/scopes/OnlineAccountClient.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * Keeps a ready-to-push snapshot of the initial surfacing screen for each
+ * locale and region that has recently been asked for.
+ *
+ * Snapshots are refreshed in the background on a jittered schedule, and
+ * refreshing is paused while the shell reports there is no internet
+ * connection. A snapshot that hasn't been refreshed for max_age is no
+ * longer served, unless the quota has run out.
+ */
+class HomeRefresher {
+public:
+    typedef std::shared_ptr<HomeRefresher> Ptr;
+
+    HomeRefresher(std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client,
+            FeaturedPlaylistCache::Ptr featured_playlists,
+            std::chrono::seconds interval = std::chrono::minutes(15),
+            std::chrono::seconds jitter = std::chrono::minutes(3),
+            std::chrono::seconds max_age = std::chrono::hours(2));
+
+    ~HomeRefresher();
+
+    void start();
+
+    void stop();
+
+    /**
+     * Returns the current snapshot, or nullptr if we don't have a recent
+     * enough one.
+     */
+    CategorySnapshot::SCPtr snapshot(const std::string &locale,
+            const std::string &country_code, const std::string &category_id);
+
+    /**
+     * Stores a snapshot fetched by a query, and keeps it refreshed from now on.
+     * The stored snapshot is only replaced if its content has changed, and a
+     * snapshot that is missing channels is never stored, so later queries
+     * don't report its failures again.
+     */
+    void update(const std::string &locale, const std::string &country_code,
+            CategorySnapshot::SCPtr snapshot);
+
+    void set_online(bool online);
+
+protected:
+    struct Slot {
+        CategorySnapshot::SCPtr snapshot;
+
+        /* When the content was last known to be current */
+        std::chrono::steady_clock::time_point fetched;
+
+        std::chrono::steady_clock::time_point last_used;
+    };
+
+    static std::string make_key(const std::string &locale,
+            const std::string &country_code, const std::string &category_id);
+
+    std::chrono::steady_clock::duration next_interval();
+
+    void run();
+
+    void refresh();
+
+    std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client_;
+
+    FeaturedPlaylistCache::Ptr featured_playlists_;
+
+    std::chrono::seconds interval_;
+
+    std::chrono::seconds jitter_;
+
+    std::chrono::seconds max_age_;
+
+    std::mt19937 random_;
+
+    std::map<std::string, Slot> slots_;
+
+    std::atomic<bool> online_;
+
+    bool running_ = false;
+
+    std::shared_ptr<youtube::api::Client> client_;
+
+    std::mutex mutex_;
+
+    std::condition_variable wakeup_;
+
+    std::thread worker_;
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_HOME_REFRESHER_H_
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_SCOPE_OFFLINE_INDEX_H_
+#define YOUTUBE_SCOPE_OFFLINE_INDEX_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * A local inverted index of everything we have shown, so searches can still
+ * be answered without an internet connection.
+ *
+ * The index lives in two files. The main file is a compact, read-only
+ * image that is mmapped when the scope starts. Documents seen since it was
+ * written are appended to a journal, and merged into a new main file once
+ * there are enough of them, keeping only the most recently seen documents.
+ *
+ * Once started, a background thread does the merging and writes the journal
+ * out every few seconds, so adding documents never waits for the disk.
+ */
+class OfflineIndex {
+public:
+    typedef std::shared_ptr<OfflineIndex> Ptr;
+
+    struct Document {
+        std::string id;
+
+        std::string kind;
+
+        std::string uri;
+
+        std::string title;
+
+        std::string channel;
+
+        std::string description;
+
+        std::string art;
+
+        std::string link;
+
+        /* Seconds since the epoch */
+        std::int64_t last_seen = 0;
+    };
+
+    OfflineIndex(const std::string &directory,
+            std::size_t max_documents = 5000, std::size_t max_journal = 500);
+
+    ~OfflineIndex();
+
+    /**
+     * Maps the main file and replays the journal.
+     */
+    void load();
+
+    void start();
+
+    /**
+     * Stops the background thread, writing out the journal first.
+     */
+    void stop();
+
+    /**
+     * Records a document, replacing any older copy of it.
+     */
+    void add(const Document &document);
+
+    /**
+     * Records several documents at once, taking the lock only once.
+     */
+    void add(std::vector<Document> documents);
+
+    /**
+     * Writes any buffered journal records to disk.
+     */
+    void flush();
+
+    /**
+     * Merges the journal into a new main file. Searches and additions carry
+     * on while the file is written; whatever is added meanwhile stays in the
+     * journal.
+     */
+    void compact();
+
+    /**
+     * Returns up to max_results documents matching the query, best first.
+     */
+    std::vector<Document> search(const std::string &query,
+            std::size_t max_results);
+
+    std::size_t size();
+
+    /**
+     * Splits text into lower-case search terms.
+     */
+    static std::vector<std::string> tokenize(const std::string &text);
+
+protected:
+    struct Header;
+
+    struct DocumentRecord;
+
+    struct TermRecord;
+
+    struct PostingRecord;
+
+    struct Match;
+
+    /**
+     * Returns false if there is a main file from another version.
+     */
+    bool map_file();
+
+    void unmap_file();
+
+    void replay_journal();
+
+    void append_to_journal(const Document &document);
+
+    bool write_file(std::vector<Document> documents,
+            const std::string &path) const;
+
+    void run();
+
+    const DocumentRecord * find_mapped(const std::string &id) const;
+
+    Document mapped_document(const DocumentRecord &record) const;
+
+    std::string mapped_string(std::uint32_t offset, std::uint32_t length) const;
+
+    std::string directory_;
+
+    std::string index_path_;
+
+    std::string journal_path_;
+
+    std::size_t max_documents_;
+
+    std::size_t max_journal_;
+
+    const char *mapped_ = nullptr;
+
+    std::size_t mapped_size_ = 0;
+
+    const Header *header_ = nullptr;
+
+    const DocumentRecord *documents_ = nullptr;
+
+    const TermRecord *terms_ = nullptr;
+
+    const PostingRecord *postings_ = nullptr;
+
+    const char *strings_ = nullptr;
+
+    std::map<std::string, Document> journal_documents_;
+
+    std::ofstream journal_;
+
+    bool running_ = false;
+
+    bool compaction_wanted_ = false;
+
+    bool dirty_ = false;
+
+    std::mutex mutex_;
+
+    /* Held for the whole of a compaction, so only one runs at a time */
+    std::mutex compact_mutex_;
+
+    std::condition_variable wakeup_;
+
+    std::thread worker_;
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_OFFLINE_INDEX_H_
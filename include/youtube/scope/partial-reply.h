@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef YOUTUBE_SCOPE_PARTIAL_REPLY_H_
+#define YOUTUBE_SCOPE_PARTIAL_REPLY_H_
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * Keeps track of the branches of a query that failed, so the rest of the
+ * reply can still be shown without them.
+ */
+class PartialReply {
+public:
+    typedef std::shared_ptr<PartialReply> Ptr;
+
+    struct Stats {
+        unsigned long replies = 0;
+
+        unsigned long degraded = 0;
+
+        unsigned long skipped_branches = 0;
+    };
+
+    /**
+     * Records a branch that failed, such as the playlists of one channel.
+     */
+    void skip(const std::string &branch, const std::string &reason);
+
+    void skip(const std::string &branch, std::exception_ptr error);
+
+    /**
+     * Records branches that were skipped, and logged, elsewhere.
+     */
+    void merge(const std::vector<std::string> &skipped);
+
+    std::vector<std::string> skipped();
+
+    bool degraded();
+
+    /**
+     * Counts the reply towards the totals, once it is complete.
+     */
+    void finish();
+
+    static Stats totals();
+
+    static void dump_stats(std::ostream &out);
+
+protected:
+    static Stats & totals_locked();
+
+    static std::mutex & totals_mutex();
+
+    std::vector<std::string> skipped_;
+
+    bool finished_ = false;
+
+    std::mutex mutex_;
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_PARTIAL_REPLY_H_
@@ -22,10 +22,28 @@
 #define YOUTUBE_SCOPE_QUERY_H_
 
 #include <youtube/api/client.h>
+#include <youtube/api/deadline.h>
+#include <youtube/api/reactor.h>
+#include <youtube/scope/browse-cache.h>
+#include <youtube/scope/category-snapshot.h>
+#include <youtube/scope/chart-cache.h>
+#include <youtube/scope/department-cache.h>
+#include <youtube/scope/home-refresher.h>
+#include <youtube/scope/offline-index.h>
+#include <youtube/scope/partial-reply.h>
+#include <youtube/scope/renderer-registry.h>
+#include <youtube/scope/result-budget.h>
+#include <youtube/scope/result-cache.h>
+#include <youtube/scope/result-emitter.h>
+#include <youtube/scope/search-cache.h>
+#include <youtube/scope/subscription-feed.h>
+#include <youtube/scope/uploads-playlist-cache.h>
 
 #include <unity/scopes/SearchQueryBase.h>
 #include <unity/scopes/ReplyProxyFwd.h>
 
+#include <atomic>
+
 namespace youtube {
 namespace scope {
 
@@ -33,25 +51,59 @@ class Query: public unity::scopes::SearchQueryBase {
 public:
     Query(const unity::scopes::CannedQuery &query,
           const unity::scopes::SearchMetadata &metadata,
-          std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client);
-
-    ~Query() = default;
+          std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client,
+          DepartmentCache::Ptr department_cache,
+          HomeRefresher::Ptr home_refresher,
+          BrowseCache::Ptr browse_cache,
+          youtube::api::Reactor::Ptr reactor,
+          SearchCache::Ptr search_cache,
+          OfflineIndex::Ptr offline_index,
+          SubscriptionFeed::Ptr subscription_feed,
+          UploadsPlaylistCache::Ptr uploads_playlists,
+          FeaturedPlaylistCache::Ptr featured_playlists,
+          ChartCache::Ptr chart_cache,
+          ResultCache::Ptr result_cache,
+          RendererRegistry::SCPtr renderers);
+
+    ~Query();
 
     void cancelled() override;
 
+    /**
+     * Starts the query on the reactor and returns straight away.
+     */
     void run(const unity::scopes::SearchReplyProxy &reply) override;
 
 protected:
+    void execute(const unity::scopes::SearchReplyProxy &reply);
+
+    /**
+     * Stops fetching once the reply won't take any more results, cancelling
+     * every request still outstanding.
+     */
+    void abandon();
+
     void add_login_nag(const unity::scopes::SearchReplyProxy &reply);
 
     void guide_category(const unity::scopes::SearchReplyProxy &reply,
             const std::string &department_id);
 
+    void home(const unity::scopes::SearchReplyProxy &reply,
+            const std::string &category_id);
+
+    void push_category_snapshot(const unity::scopes::SearchReplyProxy &reply,
+            const CategorySnapshot &snapshot);
+
     void subscriptions(const unity::scopes::SearchReplyProxy &reply);
 
     void subscription_videos(const unity::scopes::SearchReplyProxy &reply,
             const std::string &department_id);
 
+    /**
+     * The latest uploads of all subscriptions together.
+     */
+    void subscription_feed(const unity::scopes::SearchReplyProxy &reply);
+
     void guide_category_videos(const unity::scopes::SearchReplyProxy &reply,
             const std::string &department_id);
 
@@ -69,15 +121,89 @@ protected:
 
     void popular_videos(const unity::scopes::SearchReplyProxy &reply, const std::string &category_id="");
 
+    /**
+     * Answers another scope aggregating us, without any account or
+     * department work.
+     */
+    void aggregated(const unity::scopes::SearchReplyProxy &reply,
+            const std::string &department);
+
+    DepartmentCache::Entry::SCPtr build_departments(bool authenticated);
+
     void surfacing(const unity::scopes::SearchReplyProxy &reply);
 
+    /**
+     * Shows the department tree and the department asked for.
+     */
+    void departments(const unity::scopes::SearchReplyProxy &reply,
+            bool authenticated, const std::string &account);
+
     void search(const unity::scopes::SearchReplyProxy &reply,
             const std::string &query_string);
 
+    /**
+     * Answers a search from the offline index.
+     */
+    void offline_search(const unity::scopes::SearchReplyProxy &reply,
+            const std::string &query_string);
+
+    /**
+     * Whether there is still enough of the deadline left for a stage that
+     * needs a request. Skipped stages are recorded in the partial reply.
+     */
+    bool start_stage(const std::string &stage);
+
     std::string country_code() const;
 
+    template<typename T>
+    T browse(BrowseCache::Type type, const std::string &key,
+            const BrowseCache::Fetch<T> &fetch);
+
+    /* Shared with the rest of the scope, so the login nag needs no D-Bus
+     * connection of its own */
+    std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client_;
+
     youtube::api::Client client_;
 
+    DepartmentCache::Ptr department_cache_;
+
+    HomeRefresher::Ptr home_refresher_;
+
+    BrowseCache::Ptr browse_cache_;
+
+    youtube::api::Reactor::Ptr reactor_;
+
+    SearchCache::Ptr search_cache_;
+
+    OfflineIndex::Ptr offline_index_;
+
+    SubscriptionFeed::Ptr subscription_feed_;
+
+    UploadsPlaylistCache::Ptr uploads_playlists_;
+
+    FeaturedPlaylistCache::Ptr featured_playlists_;
+
+    ChartCache::Ptr chart_cache_;
+
+    ResultCache::Ptr result_cache_;
+
+    /* What this query has sent, if it may be replayed later */
+    ResultCache::Recording::Ptr recording_;
+
+    RendererRegistry::SCPtr renderers_;
+
+    ResultEmitter emitter_;
+
+    PartialReply::Ptr partial_;
+
+    youtube::api::Deadline deadline_;
+
+    ResultBudget budget_;
+
+    std::atomic<bool> stopped_ { false };
+
+    std::future<void> finished_;
+
     std::map<std::string, std::string> my_playlist_;
 };
 
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef YOUTUBE_SCOPE_RENDERER_REGISTRY_H_
+#define YOUTUBE_SCOPE_RENDERER_REGISTRY_H_
+
+#include <unity/scopes/CategoryRenderer.h>
+
+#include <map>
+#include <memory>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * The category renderers of every kind of card we show, parsed once when
+ * the scope starts and shared by every query.
+ */
+class RendererRegistry {
+public:
+    typedef std::shared_ptr<const RendererRegistry> SCPtr;
+
+    enum class Template {
+        browse, search, subscriptions, popular, login_nag, channel_info,
+        empty_tips
+    };
+
+    /**
+     * Parses every template, throwing if one of them is invalid.
+     */
+    RendererRegistry();
+
+    const unity::scopes::CategoryRenderer & get(Template name) const;
+
+protected:
+    std::map<Template, unity::scopes::CategoryRenderer> renderers_;
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_RENDERER_REGISTRY_H_
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef YOUTUBE_SCOPE_RESULT_BUDGET_H_
+#define YOUTUBE_SCOPE_RESULT_BUDGET_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * How many results the requester wants, taken from the cardinality of the
+ * search metadata. Requests and fan-outs are sized from it, so an
+ * aggregator asking for five videos doesn't make us fetch fifty.
+ *
+ * A budget of zero means there is no limit.
+ */
+class ResultBudget {
+public:
+    /* The most items the Data API returns in a single page */
+    static constexpr unsigned int MAX_PAGE_SIZE = 50;
+
+    explicit ResultBudget(int cardinality = 0) :
+            wanted_(cardinality > 0 ? cardinality : 0) {
+    }
+
+    bool unlimited() const {
+        return wanted_ == 0;
+    }
+
+    unsigned int wanted() const {
+        return wanted_;
+    }
+
+    /**
+     * The maxResults to ask for, or 0 to leave the API's default.
+     */
+    unsigned int page_size() const {
+        if (unlimited()) {
+            return 0;
+        }
+        return wanted_ < MAX_PAGE_SIZE ? wanted_ : MAX_PAGE_SIZE;
+    }
+
+    /**
+     * Like page_size(), but a whole page when there is no limit, for lists
+     * that would otherwise come back cut short.
+     */
+    unsigned int full_page_size() const {
+        return unlimited() ? MAX_PAGE_SIZE : page_size();
+    }
+
+    /**
+     * The maxResults to ask for in each branch of a fan-out, where the API
+     * returns default_size items unless asked otherwise. Branches never get
+     * bigger than the default, only smaller when fewer results are wanted.
+     */
+    unsigned int branch_page_size(unsigned int default_size) const {
+        return wanted_ < default_size ? wanted_ : 0;
+    }
+
+    /**
+     * How many of the available branches to fan out to, when each gives
+     * about per_branch results. One spare covers a branch that fails or
+     * turns out to be short.
+     */
+    std::size_t branches(std::size_t available, std::size_t per_branch) const {
+        if (unlimited() || per_branch == 0) {
+            return available;
+        }
+        std::size_t needed = (wanted_ + per_branch - 1) / per_branch + 1;
+        return std::min(available, needed);
+    }
+
+    /**
+     * Distinguishes cache entries fetched for different budgets.
+     */
+    std::string key() const {
+        return std::to_string(wanted_);
+    }
+
+protected:
+    unsigned int wanted_;
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_RESULT_BUDGET_H_
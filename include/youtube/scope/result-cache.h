@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef YOUTUBE_SCOPE_RESULT_CACHE_H_
+#define YOUTUBE_SCOPE_RESULT_CACHE_H_
+
+#include <unity/scopes/CategorisedResult.h>
+#include <unity/scopes/Department.h>
+#include <unity/scopes/SearchReplyProxyFwd.h>
+#include <unity/scopes/Variant.h>
+
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * Remembers what recent surfacing queries sent to the shell, so going back
+ * to a department, or opening it again, replays the reply without fetching
+ * or decoding anything.
+ *
+ * Entries are keyed by the canned query and the metadata that changes what
+ * it shows: locale, country code, cardinality and account. Write actions
+ * drop every entry of the account that made them.
+ */
+class ResultCache {
+public:
+    typedef std::shared_ptr<ResultCache> Ptr;
+
+    /**
+     * The departments and results of a reply, in the order they were sent.
+     */
+    class Recording {
+    public:
+        typedef std::shared_ptr<Recording> Ptr;
+
+        typedef std::shared_ptr<const Recording> SCPtr;
+
+        void departments(const unity::scopes::Department::SCPtr &departments);
+
+        void result(const unity::scopes::CategorisedResult &result);
+
+        /**
+         * Sends everything again, registering each category before its
+         * first result. Returns false if the shell stopped listening.
+         */
+        bool replay(const unity::scopes::SearchReplyProxy &reply) const;
+
+        std::size_t size() const;
+
+    protected:
+        struct Step {
+            /* Only set for department trees */
+            unity::scopes::Department::SCPtr departments;
+
+            unity::scopes::Category::SCPtr category;
+
+            unity::scopes::VariantMap attributes;
+        };
+
+        std::vector<Step> steps_;
+    };
+
+    struct Stats {
+        unsigned long hits = 0;
+
+        unsigned long misses = 0;
+
+        unsigned long invalidated = 0;
+    };
+
+    ResultCache(std::chrono::seconds ttl = std::chrono::minutes(5),
+            std::size_t max_entries = 100);
+
+    /**
+     * The variant covers anything else the reply depends on, such as the
+     * browse strategy.
+     */
+    static std::string make_key(const std::string &uri,
+            const std::string &locale, const std::string &country_code,
+            int cardinality, const std::string &account,
+            const std::string &variant = std::string());
+
+    /**
+     * Returns nullptr if there is no entry, or the entry has expired.
+     */
+    Recording::SCPtr get(const std::string &key);
+
+    void put(const std::string &key, const std::string &account,
+            Recording::SCPtr recording);
+
+    /**
+     * Drops every entry of the account, after it has changed something.
+     */
+    void invalidate(const std::string &account);
+
+    Stats stats();
+
+    void dump_stats(std::ostream &out);
+
+protected:
+    struct Entry {
+        Recording::SCPtr recording;
+
+        std::string account;
+
+        std::chrono::steady_clock::time_point stored;
+
+        std::list<std::string>::iterator position;
+    };
+
+    std::chrono::seconds ttl_;
+
+    std::size_t max_entries_;
+
+    std::map<std::string, Entry> entries_;
+
+    std::list<std::string> recently_used_;
+
+    Stats stats_;
+
+    std::mutex mutex_;
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_RESULT_CACHE_H_
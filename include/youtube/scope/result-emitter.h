@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef YOUTUBE_SCOPE_RESULT_EMITTER_H_
+#define YOUTUBE_SCOPE_RESULT_EMITTER_H_
+
+#include <youtube/api/resource.h>
+#include <youtube/scope/offline-index.h>
+
+#include <unity/scopes/CannedQuery.h>
+#include <unity/scopes/CategorisedResult.h>
+#include <unity/scopes/Variant.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * Turns resources into results for one query.
+ *
+ * Whatever is the same for every result of the query, such as the user's
+ * playlists, is worked out once. Documents for the offline index are kept
+ * for the results that were pushed until index() is called, and then added
+ * all at once.
+ */
+class ResultEmitter {
+public:
+    /* Hands a result on, returning false if no more are wanted */
+    typedef std::function<bool(const unity::scopes::CategorisedResult &)> Push;
+
+    ResultEmitter(OfflineIndex::Ptr offline_index = OfflineIndex::Ptr());
+
+    /**
+     * The user's own playlists, keyed by their translated name.
+     */
+    void set_playlists(const std::map<std::string, std::string> &playlists);
+
+    /**
+     * Builds the result of a resource and pushes it, keeping its document
+     * for the index only if push took it.
+     */
+    bool emit(const unity::scopes::Category::SCPtr &category,
+            const youtube::api::Resource &resource, const Push &push);
+
+    /**
+     * Builds and pushes the results of a whole list in one pass, until push
+     * stops taking them, and indexes the ones it took.
+     */
+    template<typename T>
+    bool emit_all(const unity::scopes::Category::SCPtr &category,
+            const T &resources, const Push &push) {
+        bool taken = true;
+        for (const auto &resource : resources) {
+            if (!emit(category, *resource, push)) {
+                taken = false;
+                break;
+            }
+        }
+        index();
+        return taken;
+    }
+
+    /**
+     * Adds the documents of the results built so far to the offline index.
+     */
+    void index();
+
+protected:
+    unity::scopes::CategorisedResult result(
+            const unity::scopes::Category::SCPtr &category,
+            const youtube::api::Resource &resource);
+
+    std::string department_uri(const std::string &department_id);
+
+    OfflineIndex::Ptr offline_index_;
+
+    std::vector<OfflineIndex::Document> documents_;
+
+    bool has_playlists_ = false;
+
+    unity::scopes::Variant favorites_;
+
+    unity::scopes::Variant watch_later_;
+
+    unity::scopes::CannedQuery query_;
+
+    std::string scope_uri_;
+
+    unity::scopes::Variant music_aggregation_;
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_RESULT_EMITTER_H_
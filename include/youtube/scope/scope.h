@@ -19,12 +19,27 @@
 #ifndef YOUTUBE_SCOPE_SCOPE_H_
 #define YOUTUBE_SCOPE_SCOPE_H_
 
+#include <youtube/api/reactor.h>
+#include <youtube/scope/browse-cache.h>
+#include <youtube/scope/chart-cache.h>
+#include <youtube/scope/department-cache.h>
+#include <youtube/scope/featured-playlist-cache.h>
+#include <youtube/scope/home-refresher.h>
+#include <youtube/scope/offline-index.h>
+#include <youtube/scope/renderer-registry.h>
+#include <youtube/scope/result-cache.h>
+#include <youtube/scope/search-cache.h>
+#include <youtube/scope/subscription-feed.h>
+#include <youtube/scope/uploads-playlist-cache.h>
+
 #include <unity/scopes/OnlineAccountClient.h>
 #include <unity/scopes/PreviewQueryBase.h>
 #include <unity/scopes/QueryBase.h>
 #include <unity/scopes/ReplyProxyFwd.h>
 #include <unity/scopes/ScopeBase.h>
 
+#include <ostream>
+
 namespace youtube {
 
 namespace scope {
@@ -47,8 +62,39 @@ public:
             const unity::scopes::ActionMetadata &metadata,
             std::string const& widget_id,
             std::string const& action_id) override;
+
+    /**
+     * Writes the statistics of every cache and circuit, one line each.
+     * stop() does this when YOUTUBE_SCOPE_STATS is set.
+     */
+    void dump_stats(std::ostream &out);
+
 protected:
     std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client_;
+
+    DepartmentCache::Ptr department_cache_;
+
+    HomeRefresher::Ptr home_refresher_;
+
+    BrowseCache::Ptr browse_cache_;
+
+    ChartCache::Ptr chart_cache_;
+
+    youtube::api::Reactor::Ptr reactor_;
+
+    SearchCache::Ptr search_cache_;
+
+    OfflineIndex::Ptr offline_index_;
+
+    SubscriptionFeed::Ptr subscription_feed_;
+
+    UploadsPlaylistCache::Ptr uploads_playlists_;
+
+    FeaturedPlaylistCache::Ptr featured_playlists_;
+
+    ResultCache::Ptr result_cache_;
+
+    RendererRegistry::SCPtr renderers_;
 };
 
 }
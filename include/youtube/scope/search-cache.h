@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_SCOPE_SEARCH_CACHE_H_
+#define YOUTUBE_SCOPE_SEARCH_CACHE_H_
+
+#include <youtube/api/search-list-response.h>
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * Remembers recent search results, so typing and deleting characters, or
+ * coming back to a search, doesn't go to YouTube each time.
+ *
+ * Entries are keyed by the normalized query string, category, cardinality
+ * and region. It also keeps track of the search in flight for each shell
+ * session, so a search can be cancelled as soon as the user has typed
+ * something newer.
+ */
+class SearchCache {
+public:
+    typedef std::shared_ptr<SearchCache> Ptr;
+
+    struct Key {
+        std::string query;
+
+        std::string category_id;
+
+        unsigned int cardinality;
+
+        std::string country_code;
+    };
+
+    struct Stats {
+        unsigned long hits = 0;
+
+        unsigned long provisional = 0;
+
+        unsigned long misses = 0;
+
+        unsigned long superseded = 0;
+
+        unsigned long wasted_requests = 0;
+    };
+
+    /**
+     * Registers a search request as the current one for its session, for
+     * as long as this object is alive. Starting it cancels the previous
+     * search of the session.
+     */
+    class InFlight {
+    public:
+        InFlight(Ptr cache, const std::string &session,
+                const std::function<void()> &cancel);
+
+        ~InFlight();
+
+        /**
+         * Call once the response has been used, otherwise the request is
+         * counted as wasted.
+         */
+        void completed();
+
+    protected:
+        Ptr cache_;
+
+        std::string session_;
+
+        unsigned long id_ = 0;
+
+        bool completed_ = false;
+    };
+
+    SearchCache(std::chrono::seconds ttl = std::chrono::minutes(10),
+            std::size_t max_entries = 200);
+
+    static std::string normalize(const std::string &query);
+
+    /**
+     * Returns the results of exactly this search, or nullptr.
+     */
+    youtube::api::SearchListResponse::Ptr get(const Key &key);
+
+    /**
+     * Returns results cached for the longest prefix of the query that still
+     * match every word of it, to show while the real search is in flight.
+     */
+    youtube::api::SearchListResponse::ResourceList provisional(const Key &key);
+
+    void put(const Key &key, youtube::api::SearchListResponse::Ptr response);
+
+    Stats stats();
+
+    void dump_stats(std::ostream &out);
+
+protected:
+    struct Entry {
+        youtube::api::SearchListResponse::Ptr response;
+
+        std::chrono::steady_clock::time_point stored;
+
+        std::list<std::string>::iterator position;
+    };
+
+    struct Session {
+        unsigned long id;
+
+        std::function<void()> cancel;
+    };
+
+    static std::string make_key(const Key &key, const std::string &query);
+
+    Entry * find(const std::string &full_key);
+
+    unsigned long begin(const std::string &session,
+            const std::function<void()> &cancel);
+
+    void end(const std::string &session, unsigned long id, bool completed);
+
+    std::chrono::seconds ttl_;
+
+    std::size_t max_entries_;
+
+    std::map<std::string, Entry> entries_;
+
+    std::list<std::string> recently_used_;
+
+    std::map<std::string, Session> sessions_;
+
+    unsigned long next_id_ = 1;
+
+    Stats stats_;
+
+    std::mutex mutex_;
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_SEARCH_CACHE_H_
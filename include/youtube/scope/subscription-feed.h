@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_SCOPE_SUBSCRIPTION_FEED_H_
+#define YOUTUBE_SCOPE_SUBSCRIPTION_FEED_H_
+
+#include <youtube/api/client.h>
+#include <youtube/scope/uploads-playlist-cache.h>
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * The latest uploads of every subscribed channel, merged into one list.
+ *
+ * The uploads of each channel are cached separately, so refreshing the feed
+ * only goes back to YouTube for the channels whose uploads are older than
+ * the TTL. At most max_channels channels are kept, dropping the ones fetched
+ * longest ago.
+ */
+class SubscriptionFeed {
+public:
+    typedef std::shared_ptr<SubscriptionFeed> Ptr;
+
+    struct Stats {
+        unsigned long channels_fetched = 0;
+
+        unsigned long channels_cached = 0;
+    };
+
+    SubscriptionFeed(
+            UploadsPlaylistCache::Ptr uploads_playlists =
+                    UploadsPlaylistCache::Ptr(),
+            std::chrono::seconds ttl = std::chrono::minutes(15),
+            std::size_t max_in_flight = 6,
+            std::size_t max_channels = 1000);
+
+    /**
+     * Returns the newest max_items uploads of the subscriptions, newest first.
+     */
+    youtube::api::Client::SubscriptionItemList latest(
+            youtube::api::Client &client,
+            const youtube::api::Client::SubscriptionList &subscriptions,
+            std::size_t max_items);
+
+    Stats stats();
+
+    void dump_stats(std::ostream &out);
+
+protected:
+    typedef std::vector<youtube::api::SubscriptionItem::Ptr> Uploads;
+
+    struct Channel {
+        /* Newest first */
+        std::shared_ptr<const Uploads> uploads;
+
+        std::chrono::steady_clock::time_point fetched;
+    };
+
+    void refresh(youtube::api::Client &client,
+            const std::vector<std::string> &channel_ids);
+
+    /**
+     * Drops the channels fetched longest ago, down to max_channels.
+     * Call with the mutex held.
+     */
+    void trim();
+
+    /**
+     * Fetches the uploads of the channels, returning those whose derived
+     * uploads playlist failed.
+     */
+    std::vector<std::string> fetch_uploads(youtube::api::Client &client,
+            const std::vector<std::string> &channel_ids, bool lookup);
+
+    UploadsPlaylistCache::Ptr uploads_playlists_;
+
+    std::chrono::seconds ttl_;
+
+    std::size_t max_in_flight_;
+
+    std::size_t max_channels_;
+
+    std::map<std::string, Channel> channels_;
+
+    Stats stats_;
+
+    std::mutex mutex_;
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_SUBSCRIPTION_FEED_H_
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef YOUTUBE_SCOPE_UPLOADS_PLAYLIST_CACHE_H_
+#define YOUTUBE_SCOPE_UPLOADS_PLAYLIST_CACHE_H_
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace youtube {
+namespace scope {
+
+/**
+ * Remembers the uploads playlist of each channel we have fetched uploads
+ * for. A channel's uploads playlist never changes, so the mappings are kept
+ * on disk between runs.
+ */
+class UploadsPlaylistCache {
+public:
+    typedef std::shared_ptr<UploadsPlaylistCache> Ptr;
+
+    /**
+     * With an empty path the mappings are only kept in memory.
+     */
+    UploadsPlaylistCache(const std::string &path = std::string());
+
+    void load();
+
+    /**
+     * Writes the mappings out, if anything has changed.
+     */
+    void save();
+
+    /**
+     * Returns the known uploads playlist of a channel, or an empty string.
+     */
+    std::string get(const std::string &channel_id);
+
+    void put(const std::string &channel_id, const std::string &playlist_id);
+
+    std::size_t size();
+
+protected:
+    std::string path_;
+
+    std::map<std::string, std::string> playlists_;
+
+    bool dirty_ = false;
+
+    std::mutex mutex_;
+};
+
+}
+}
+
+#endif // YOUTUBE_SCOPE_UPLOADS_PLAYLIST_CACHE_H_
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/circuit-breaker.h>
+
+#include <iostream>
+
+using namespace std;
+using namespace youtube::api;
+
+namespace {
+
+mutex instance_mutex;
+CircuitBreaker::Ptr shared_instance;
+
+}
+
+CircuitBreaker::Ptr CircuitBreaker::instance() {
+    lock_guard<mutex> lock(instance_mutex);
+    if (!shared_instance) {
+        shared_instance = make_shared<CircuitBreaker>();
+    }
+    return shared_instance;
+}
+
+void CircuitBreaker::reset_instance() {
+    lock_guard<mutex> lock(instance_mutex);
+    shared_instance.reset();
+}
+
+CircuitBreaker::CircuitBreaker(const Options &options) :
+        options_(options) {
+}
+
+bool CircuitBreaker::allow(const string &endpoint) {
+    lock_guard<mutex> lock(mutex_);
+
+    Circuit &circuit = circuits_[endpoint];
+    auto now = Clock::now();
+
+    switch (circuit.state) {
+    case State::closed:
+        return true;
+    case State::open:
+        if (now - circuit.opened < options_.open_for) {
+            ++stats_.rejected;
+            return false;
+        }
+        circuit.state = State::half_open;
+        circuit.probing = false;
+        break;
+    case State::half_open:
+        break;
+    }
+
+    // Only one probe at a time, unless the last one never came back
+    if (circuit.probing && now - circuit.probe_started < options_.open_for) {
+        ++stats_.rejected;
+        return false;
+    }
+    circuit.probing = true;
+    circuit.probe_started = now;
+    return true;
+}
+
+void CircuitBreaker::record(const string &endpoint, bool success) {
+    lock_guard<mutex> lock(mutex_);
+
+    Circuit &circuit = circuits_[endpoint];
+
+    if (circuit.state == State::half_open) {
+        circuit.probing = false;
+        if (success) {
+            circuit.state = State::closed;
+            circuit.outcomes.clear();
+            circuit.failures = 0;
+        } else {
+            open(circuit, endpoint);
+        }
+        return;
+    }
+
+    if (circuit.state == State::open) {
+        return;
+    }
+
+    circuit.outcomes.emplace_back(success);
+    if (!success) {
+        ++circuit.failures;
+    }
+    if (circuit.outcomes.size() > options_.window) {
+        if (!circuit.outcomes.front()) {
+            --circuit.failures;
+        }
+        circuit.outcomes.pop_front();
+    }
+
+    if (circuit.outcomes.size() >= options_.min_requests
+            && circuit.failures
+                    >= options_.failure_rate * circuit.outcomes.size()) {
+        open(circuit, endpoint);
+    }
+}
+
+void CircuitBreaker::release(const string &endpoint) {
+    lock_guard<mutex> lock(mutex_);
+
+    Circuit &circuit = circuits_[endpoint];
+    if (circuit.state == State::half_open) {
+        circuit.probing = false;
+    }
+}
+
+CircuitBreaker::State CircuitBreaker::state(const string &endpoint) {
+    lock_guard<mutex> lock(mutex_);
+    auto it = circuits_.find(endpoint);
+    if (it == circuits_.end()) {
+        return State::closed;
+    }
+    return it->second.state;
+}
+
+CircuitBreaker::Stats CircuitBreaker::stats() {
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+void CircuitBreaker::dump_stats(ostream &out) {
+    Stats stats = this->stats();
+    out << "Circuit breaker: opened " << stats.opened << " times, "
+            << stats.rejected << " requests failed fast" << endl;
+}
+
+void CircuitBreaker::open(Circuit &circuit, const string &endpoint) {
+    cerr << "Too many failures, pausing requests to " << endpoint << endl;
+    circuit.state = State::open;
+    circuit.opened = Clock::now();
+    circuit.outcomes.clear();
+    circuit.failures = 0;
+    ++stats_.opened;
+}
@@ -18,8 +18,14 @@
  */
 
 #include <youtube/api/channel.h>
+#include <youtube/api/circuit-breaker.h>
 #include <youtube/api/client.h>
+#include <youtube/api/failure-cache.h>
+#include <youtube/api/not-found.h>
 #include <youtube/api/playlist.h>
+#include <youtube/api/quota-budget.h>
+#include <youtube/api/reactor.h>
+#include <youtube/api/scheduler.h>
 
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
@@ -32,7 +38,9 @@
 #include <core/net/http/response.h>
 #include <json/json.h>
 
+#include <atomic>
 #include <iostream>
+#include <mutex>
 
 namespace http = core::net::http;
 namespace json = Json;
@@ -64,6 +72,177 @@ static deque<shared_ptr<T>> get_typed_list(const string &filter,
     return results;
 }
 
+// A response slower than this counts against the endpoint's circuit
+static const chrono::seconds SLOW_RESPONSE(10);
+
+static string endpoint(const net::Uri::Path &path) {
+    return path.size() > 2 ? path[2] : string();
+}
+
+/**
+ * Identifies a GET request for the failure cache, without the API key or
+ * access token. Who it was made as is part of it, as a request that fails
+ * for one account may well work for another.
+ */
+static string request_key(const Config &config, const net::Uri::Path &path,
+        const net::Uri::QueryParameters &parameters) {
+    string key = config.authenticated ?
+            "account " + to_string(config.account_id) + " " : "key ";
+    for (const string &element : path) {
+        key += "/" + element;
+    }
+    char separator = '?';
+    for (const auto &parameter : parameters) {
+        key += separator + parameter.first + "=" + parameter.second;
+        separator = '&';
+    }
+    return key;
+}
+
+/**
+ * Asking again won't change the answer to these.
+ */
+static bool is_deterministic_failure(http::Status status) {
+    return status == http::Status::bad_request
+            || status == http::Status::not_found;
+}
+
+static string error_message(const json::Value &root) {
+    const json::Value &error = root["error"];
+    if (error.isObject()) {
+        return error["message"].asString();
+    }
+    return error.isString() ? error.asString() : string();
+}
+
+/**
+ * Whether an error response says what was asked for doesn't exist.
+ */
+static bool is_not_found(http::Status status, const json::Value &root) {
+    if (status == http::Status::not_found) {
+        return true;
+    }
+    const json::Value &error = root["error"];
+    if (!error.isObject()) {
+        return false;
+    }
+    const json::Value &errors = error["errors"];
+    for (json::ArrayIndex index = 0; errors.isArray() && index < errors.size();
+            ++index) {
+        if (errors[index]["reason"].asString() == "playlistNotFound") {
+            return true;
+        }
+    }
+    return false;
+}
+
+static exception_ptr request_failure(const string &message, bool not_found) {
+    if (not_found) {
+        return make_exception_ptr(NotFound(message));
+    }
+    return make_exception_ptr(domain_error(message));
+}
+
+/**
+ * Whether an error response says the daily quota has run out.
+ */
+static bool is_quota_exceeded(const json::Value &root) {
+    const json::Value &error = root["error"];
+    if (!error.isObject()) {
+        return false;
+    }
+    const json::Value &errors = error["errors"];
+    for (json::ArrayIndex index = 0; errors.isArray() && index < errors.size();
+            ++index) {
+        string reason = errors[index]["reason"].asString();
+        if (reason == "quotaExceeded" || reason == "dailyLimitExceeded") {
+            return true;
+        }
+    }
+    return false;
+}
+
+// How long a signed in account is trusted for before looking again
+static const chrono::seconds ACCOUNT_TTL(30);
+
+// The last signed in account, shared by every client
+mutex account_mutex;
+Config account;
+chrono::steady_clock::time_point account_looked_up;
+bool account_known = false;
+
+/**
+ * Asks online accounts over D-Bus which account is signed in.
+ */
+static Config lookup_account() {
+    Config config;
+
+    /// TODO: Keep a single OnlineAccountClient and refresh it as soon as
+    /// OnlineAccountClient::refresh_service_statuses() is fixed (Bug #1398813).
+    /// For now we have to re-instantiate a new OnlineAccountClient each time.
+    unity::scopes::OnlineAccountClient oa_client(SCOPE_INSTALL_NAME,
+            "sharing", "google");
+
+    for (auto const& status : oa_client.get_service_statuses()) {
+        if (status.service_authenticated) {
+            config.authenticated = true;
+            config.account_id = status.account_id;
+            config.access_token = status.access_token;
+            config.client_id = status.client_id;
+            config.client_secret = status.client_secret;
+            break;
+        }
+    }
+
+    if (!config.authenticated) {
+        std::cerr << "YouTube scope is unauthenticated" << std::endl;
+    } else {
+        std::cerr << "YouTube scope is authenticated" << std::endl;
+    }
+    return config;
+}
+
+/**
+ * The account to make requests as. A signed in account is looked up again
+ * at most every ACCOUNT_TTL, but being signed out isn't remembered, so a
+ * log-in shows up straight away. The lookup is handed off the reactor, so
+ * the other tasks carry on while it happens.
+ */
+static Config current_config() {
+    Config config;
+    if (getenv("YOUTUBE_SCOPE_APIROOT")) {
+        config.apiroot = getenv("YOUTUBE_SCOPE_APIROOT");
+    }
+
+    if (getenv("YOUTUBE_SCOPE_IGNORE_ACCOUNTS") != nullptr) {
+        return config;
+    }
+
+    Config found;
+    bool fresh;
+    {
+        lock_guard<mutex> lock(account_mutex);
+        fresh = account_known
+                && chrono::steady_clock::now() - account_looked_up < ACCOUNT_TTL;
+        found = account;
+    }
+    if (!fresh) {
+        found = Reactor::offload<Config>(&lookup_account);
+
+        lock_guard<mutex> lock(account_mutex);
+        account = found;
+        account_looked_up = chrono::steady_clock::now();
+        account_known = found.authenticated;
+    }
+
+    config.authenticated = found.authenticated;
+    config.account_id = found.account_id;
+    config.access_token = found.access_token;
+    config.client_id = found.client_id;
+    config.client_secret = found.client_secret;
+    return config;
+}
+
 template<typename T>
 static T is_successful(const json::Value &root) {
     //for rating, server gives no-content back with 204 http status code
@@ -79,12 +258,18 @@ static T is_successful(const json::Value &root) {
 
 class Client::Priv {
 public:
-    Priv(std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client) :
+    Priv(std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client,
+            Scheduler::Priority priority) :
             client_(http::make_client()), worker_ { [this]() {client_->run();} },
-            oa_client_(oa_client), cancelled_(false) {
+            oa_client_(oa_client), scheduler_(Scheduler::instance()),
+            budget_(QuotaBudget::instance()),
+            breaker_(CircuitBreaker::instance()),
+            failures_(FailureCache::instance()), priority_(priority),
+            cancelled_(false), quota_used_(0) {
     }
 
     ~Priv() {
+        scheduler_->forget(this);
         client_->stop();
         if (worker_.joinable()) {
             worker_.join();
@@ -100,52 +285,119 @@ public:
 
     std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client_;
 
+    Scheduler::Ptr scheduler_;
+
+    QuotaBudget::Ptr budget_;
+
+    CircuitBreaker::Ptr breaker_;
+
+    FailureCache::Ptr failures_;
+
+    Scheduler::Priority priority_;
+
     std::atomic<bool> cancelled_;
 
-    void get(const net::Uri::Path &path,
-            const net::Uri::QueryParameters &parameters,
-            http::Request::Handler &handler) {
+    std::atomic<unsigned long> quota_used_;
+
+    Deadline deadline_;
+    std::mutex deadline_mutex_;
+
+    Deadline deadline() {
+        std::lock_guard<std::mutex> lock(deadline_mutex_);
+        return deadline_;
+    }
+
+    /**
+     * Decides whether a request may go out, charging the quota budget if it
+     * does. Requests after a cancellation or past the deadline, known to
+     * fail, to an endpoint that is failing, or that the budget can't spare
+     * fail straight away.
+     */
+    template<typename T>
+    bool admit(const shared_ptr<promise<T>> &prom, const net::Uri::Path &path,
+            const string &request, bool write) {
+        if (cancelled_) {
+            prom->set_exception(make_exception_ptr(domain_error("Request cancelled")));
+            return false;
+        }
+
+        if (deadline().expired()) {
+            prom->set_exception(make_exception_ptr(domain_error("Query deadline exceeded")));
+            return false;
+        }
+
+        string message;
+        bool not_found;
+        if (!request.empty() && failures_->get(request, message, not_found)) {
+            prom->set_exception(request_failure(message, not_found));
+            return false;
+        }
+
+        if (!budget_->admit(priority_)) {
+            prom->set_exception(make_exception_ptr(domain_error("YouTube quota budget exhausted")));
+            return false;
+        }
+
+        if (!breaker_->allow(endpoint(path))) {
+            prom->set_exception(make_exception_ptr(domain_error("YouTube " + endpoint(path) + " unavailable")));
+            return false;
+        }
+
+        unsigned int units = QuotaBudget::cost(endpoint(path), write);
+        budget_->charge(units);
+        quota_used_ += units;
+        return true;
+    }
+
+    void check_quota(const http::Response &response, const json::Value &root) {
+        if (response.status == http::Status::forbidden
+                && is_quota_exceeded(root)) {
+            budget_->quota_exceeded();
+        }
+    }
+
+    shared_ptr<http::Request> get(const Config &config,
+            const net::Uri::Path &path,
+            const net::Uri::QueryParameters &parameters) {
         std::lock_guard<std::mutex> lock(config_mutex_);
+        config_ = config;
         auto configuration = net_config(path, parameters);
 
         configuration.header.add("Accept", config_.accept);
         configuration.header.add("User-Agent", config_.user_agent + " (gzip)");
         configuration.header.add("Accept-Encoding", "gzip");
 
-        auto request = client_->head(configuration);
-        request->async_execute(handler);
+        return client_->head(configuration);
     }
 
-    void post(const net::Uri::Path &path,
+    shared_ptr<http::Request> post(const net::Uri::Path &path,
             const net::Uri::QueryParameters &parameters,
             const std::string &postmsg,
-            const std::string &content_type,
-            http::Request::Handler &handler) {
+            const std::string &content_type) {
+        Config config = current_config();
         std::lock_guard<std::mutex> lock(config_mutex_);
+        config_ = config;
         http::Request::Configuration configuration = net_config(path, parameters);
         configuration.header.add("User-Agent", config_.user_agent);
         configuration.header.add("Content-Type", content_type);
 
-        auto request = client_->post(configuration, postmsg, content_type);
-        request->async_execute(handler);
+        return client_->post(configuration, postmsg, content_type);
     }
 
-    void del(const net::Uri::Path &path,
-            const net::Uri::QueryParameters &parameters,
-            http::Request::Handler &handler) {
+    shared_ptr<http::Request> del(const net::Uri::Path &path,
+            const net::Uri::QueryParameters &parameters) {
+        Config config = current_config();
         std::lock_guard<std::mutex> lock(config_mutex_);
+        config_ = config;
         http::Request::Configuration configuration = net_config(path, parameters);
         configuration.header.add("User-Agent", config_.user_agent);
         configuration.header.add("X-HTTP-Method-Override", "DELETE");
 
-        auto request = client_->post(configuration, "", "");
-        request->async_execute(handler);
+        return client_->post(configuration, "", "");
     }
 
     http::Request::Configuration net_config(const net::Uri::Path &path,
                                             const net::Uri::QueryParameters &parameters) {
-        update_config();
-
         http::Request::Configuration configuration;
         net::Uri::QueryParameters complete_parameters(parameters);
         if (config_.authenticated) {
@@ -162,28 +414,90 @@ public:
         return configuration;
     }
 
-    http::Request::Progress::Next progress_report(
-            const http::Request::Progress&) {
-        return cancelled_ ?
+    bool given_up(const Client::Abort &abort) {
+        return cancelled_ || (abort && *abort);
+    }
+
+    http::Request::Progress::Next progress_report(const Client::Abort &abort) {
+        return given_up(abort) ?
                 http::Request::Progress::Next::abort_operation :
                 http::Request::Progress::Next::continue_operation;
     }
 
+    /**
+     * Sends the request once the scheduler lets us, and lets the scheduler
+     * and any waiting reactor tasks know when it has completed.
+     */
+    template<typename T>
+    void schedule(shared_ptr<promise<T>> prom, const string &resource,
+            shared_ptr<http::Request> request,
+            const function<void(const http::Response&)> &on_response,
+            const Client::Abort &abort = Client::Abort()) {
+        scheduler_->submit(this, priority_,
+                [this, prom, resource, request, on_response, abort](const function<void()> &finished)
+                {
+                    Deadline deadline = this->deadline();
+                    if (given_up(abort) || deadline.expired()) {
+                        breaker_->release(resource);
+                        prom->set_exception(make_exception_ptr(domain_error(
+                                given_up(abort) ? "Request cancelled" : "Query deadline exceeded")));
+                        finished();
+                        Reactor::notify_all();
+                        return;
+                    }
+                    if (!deadline.unlimited()) {
+                        request->set_timeout(deadline.remaining());
+                    }
+
+                    http::Request::Handler handler;
+                    handler.on_progress([this, abort](const http::Request::Progress&) {
+                        return progress_report(abort);
+                    });
+                    auto started = chrono::steady_clock::now();
+                    handler.on_error([this, prom, resource, deadline, finished, abort](const net::Error& e)
+                    {
+                        // Running out of our own time says nothing about the endpoint
+                        if (given_up(abort) || deadline.expired()) {
+                            breaker_->release(resource);
+                        } else {
+                            breaker_->record(resource, false);
+                        }
+                        prom->set_exception(make_exception_ptr(e));
+                        finished();
+                        Reactor::notify_all();
+                    });
+                    handler.on_response([this, prom, resource, started, on_response, finished](const http::Response& response)
+                    {
+                        breaker_->record(resource,
+                                static_cast<int>(response.status) < 500
+                                        && chrono::steady_clock::now() - started < SLOW_RESPONSE);
+                        try {
+                            on_response(response);
+                        } catch (...) {
+                            // Don't leave anyone waiting on a response we couldn't parse
+                            prom->set_exception(current_exception());
+                        }
+                        finished();
+                        Reactor::notify_all();
+                    });
+
+                    request->async_execute(handler);
+                });
+    }
+
     template<typename T>
-    future<T> async_get(const net::Uri::Path &path,
+    future<T> async_get(const Client::Abort &abort, const net::Uri::Path &path,
             const net::Uri::QueryParameters &parameters,
             const function<T(const json::Value &root)> &func) {
         auto prom = make_shared<promise<T>>();
 
-        http::Request::Handler handler;
-        handler.on_progress(
-                bind(&Client::Priv::progress_report, this, placeholders::_1));
-        handler.on_error([prom](const net::Error& e)
-        {
-            prom->set_exception(make_exception_ptr(e));
-        });
-        handler.on_response(
-                [prom,func](const http::Response& response)
+        Config config = current_config();
+        string request = request_key(config, path, parameters);
+        if (!admit(prom, path, request, false)) {
+            return prom->get_future();
+        }
+        schedule<T>(prom, endpoint(path), get(config, path, parameters),
+                [this,prom,func,request](const http::Response& response)
                 {
                     string decompressed;
 
@@ -205,13 +519,17 @@ public:
                     reader.parse(decompressed, root);
 
                     if (response.status != http::Status::ok) {
-                        prom->set_exception(make_exception_ptr(domain_error(root["error"].asString())));
+                        check_quota(response, root);
+                        bool not_found = is_not_found(response.status, root);
+                        if (is_deterministic_failure(response.status)) {
+                            failures_->put(request, error_message(root),
+                                    not_found);
+                        }
+                        prom->set_exception(request_failure(error_message(root), not_found));
                     } else {
                         prom->set_value(func(root));
                     }
-                });
-
-        get(path, parameters, handler);
+                }, abort);
 
         return prom->get_future();
     }
@@ -224,15 +542,11 @@ public:
             const function<T(const json::Value &root)> &func) {
         auto prom = make_shared<promise<T>>();
 
-        http::Request::Handler handler;
-        handler.on_progress(
-                bind(&Client::Priv::progress_report, this, placeholders::_1));
-        handler.on_error([prom](const net::Error& e)
-        {
-            prom->set_exception(make_exception_ptr(e));
-        });
-        handler.on_response(
-                [prom,func](const http::Response& response)
+        if (!admit(prom, path, string(), true)) {
+            return prom->get_future();
+        }
+        schedule<T>(prom, endpoint(path), post(path, parameters, postmsg, content_type),
+                [this,prom,func](const http::Response& response)
                 {
                     json::Value root;
                     json::Reader reader;
@@ -241,14 +555,13 @@ public:
                     if (response.status != http::Status::created &&
                             response.status != http::Status::ok &&
                             response.status != http::Status::no_content) {
-                        prom->set_exception(make_exception_ptr(domain_error(root["error"].asString())));
+                        check_quota(response, root);
+                        prom->set_exception(make_exception_ptr(domain_error(error_message(root))));
                     } else {
                         prom->set_value(func(root));
                     }
                 });
 
-        post(path, parameters, postmsg, content_type, handler);
-
         return prom->get_future();
     }
 
@@ -258,15 +571,11 @@ public:
             const function<T(const json::Value &root)> &func) {
         auto prom = make_shared<promise<T>>();
 
-        http::Request::Handler handler;
-        handler.on_progress(
-                bind(&Client::Priv::progress_report, this, placeholders::_1));
-        handler.on_error([prom](const net::Error& e)
-        {
-            prom->set_exception(make_exception_ptr(e));
-        });
-        handler.on_response(
-                [prom,func](const http::Response& response)
+        if (!admit(prom, path, string(), true)) {
+            return prom->get_future();
+        }
+        schedule<T>(prom, endpoint(path), del(path, parameters),
+                [this,prom,func](const http::Response& response)
                 {
                     json::Value root;
                     json::Reader reader;
@@ -275,66 +584,40 @@ public:
                     if (response.status != http::Status::created &&
                             response.status != http::Status::ok &&
                             response.status != http::Status::no_content) {
-                        prom->set_exception(make_exception_ptr(domain_error(root["error"].asString())));
+                        check_quota(response, root);
+                        prom->set_exception(make_exception_ptr(domain_error(error_message(root))));
                     } else {
                         prom->set_value(func(root));
                     }
                 });
 
-        del(path, parameters, handler);
-
         return prom->get_future();
     }
 
     bool authenticated() {
+        Config config = current_config();
         std::lock_guard<std::mutex> lock(config_mutex_);
-        update_config();
+        config_ = config;
         return config_.authenticated;
     }
 
-    void update_config() {
-        config_ = Config();
-
-        if (getenv("YOUTUBE_SCOPE_APIROOT")) {
-            config_.apiroot = getenv("YOUTUBE_SCOPE_APIROOT");
-        }
-
-        if (getenv("YOUTUBE_SCOPE_IGNORE_ACCOUNTS") != nullptr) {
-            return;
-        }
-
-        /// TODO: The code commented out below should be uncommented as soon as
-        /// OnlineAccountClient::refresh_service_statuses() is fixed (Bug #1398813).
-        /// For now we have to re-instantiate a new OnlineAccountClient each time.
-
-        ///if (oa_client_ == nullptr) {
-            oa_client_.reset(
-                    new unity::scopes::OnlineAccountClient(SCOPE_INSTALL_NAME,
-                            "sharing", "google"));
-        ///} else {
-        ///    oa_client_->refresh_service_statuses();
-        ///}
-
-        for (auto const& status : oa_client_->get_service_statuses()) {
-            if (status.service_authenticated) {
-                config_.authenticated = true;
-                config_.access_token = status.access_token;
-                config_.client_id = status.client_id;
-                config_.client_secret = status.client_secret;
-                break;
-            }
-        }
-
-        if (!config_.authenticated) {
-            std::cerr << "YouTube scope is unauthenticated" << std::endl;
-        } else {
-            std::cerr << "YouTube scope is authenticated" << std::endl;
-        }
+    unsigned int account_id() {
+        std::lock_guard<std::mutex> lock(config_mutex_);
+        return config_.account_id;
     }
 };
 
-Client::Client(std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client) :
-        p(new Priv(oa_client)) {
+Client::Client(std::shared_ptr<unity::scopes::OnlineAccountClient> oa_client,
+        Scheduler::Priority priority) :
+        p(new Priv(oa_client, priority)) {
+}
+
+Client::Client(const Client &client, const Abort &abort) :
+        p(client.p), abort_(abort) {
+}
+
+Client::Ptr Client::abortable(const Abort &abort) {
+    return Ptr(new Client(*this, abort));
 }
 
 future<SearchListResponse::Ptr> Client::search(const string &query,
@@ -348,7 +631,7 @@ future<SearchListResponse::Ptr> Client::search(const string &query,
     {
         parameters.emplace_back(make_pair("videoCategoryId", category_id));
     }
-    return p->async_get<SearchListResponse::Ptr>( { "youtube", "v3", "search" },
+    return p->async_get<SearchListResponse::Ptr>(abort_, { "youtube", "v3", "search" },
             parameters,
             [](const json::Value &root) {
                 return make_shared<SearchListResponse>(root);
@@ -357,7 +640,7 @@ future<SearchListResponse::Ptr> Client::search(const string &query,
 
 future<Client::GuideCategoryList> Client::guide_categories(
         const string &region_code, const string &locale) {
-    return p->async_get<GuideCategoryList>(
+    return p->async_get<GuideCategoryList>(abort_,
             { "youtube", "v3", "guideCategories" }, { { "part", "snippet" }, {
                     "regionCode", region_code }, { "hl", locale } },
             [](const json::Value &root) {
@@ -365,49 +648,92 @@ future<Client::GuideCategoryList> Client::guide_categories(
             });
 }
 
-future<Client::SubscriptionList> Client::subscription_channels() {
-    return p->async_get<SubscriptionList>( { "youtube", "v3", "subscriptions" }, { {
-            "part", "snippet" }, { "mine", "true" }, {"maxResults", "50"} },
+future<Client::SubscriptionList> Client::subscription_channels(
+        unsigned int max_results) {
+    return p->async_get<SubscriptionList>(abort_, { "youtube", "v3", "subscriptions" }, { {
+            "part", "snippet" }, { "mine", "true" }, {"maxResults", to_string(max_results)} },
             [](const json::Value &root) {
                 return get_typed_list<Subscription>("youtube#subscription", root);
     });
 }
 
+future<Client::SubscriptionPage> Client::subscription_page(
+        const string &page_token, unsigned int max_results) {
+    net::Uri::QueryParameters parameters { { "part", "snippet" }, { "mine",
+            "true" }, { "maxResults", to_string(max_results) } };
+    if (!page_token.empty()) {
+        parameters.emplace_back(make_pair("pageToken", page_token));
+    }
+    return p->async_get<SubscriptionPage>(abort_, { "youtube", "v3", "subscriptions" },
+            parameters,
+            [](const json::Value &root) {
+                return SubscriptionPage {
+                        get_typed_list<Subscription>("youtube#subscription", root),
+                        root["nextPageToken"].asString() };
+            });
+}
+
 future<Client::ChannelList> Client::auth_user_info() {
-    return p->async_get<ChannelList>( { "youtube", "v3", "channels" }, { {
+    return p->async_get<ChannelList>(abort_, { "youtube", "v3", "channels" }, { {
             "part", "snippet,contentDetails,statistics" }, { "mine", "true" } },
             [](const json::Value &root) {
                 return get_typed_list<Channel>("youtube#channel", root);
             });
 }
 
-future<std::string> Client::subscription_channel_uploads(std::string const &department_id) {
-    std::string id = department_id.substr(13);
-    return p->async_get<std::string>( { "youtube", "v3", "channels" }, { {
-            "part", "snippet,contentDetails" }, { "id", department_id } },
+future<std::string> Client::subscription_channel_uploads(std::string const &channel_id) {
+    string derived = derive_uploads_playlist(channel_id);
+    if (derived.empty()) {
+        return lookup_channel_uploads(channel_id);
+    }
+
+    promise<string> prom;
+    prom.set_value(derived);
+    return prom.get_future();
+}
+
+future<std::string> Client::lookup_channel_uploads(std::string const &channel_id) {
+    return p->async_get<std::string>(abort_, { "youtube", "v3", "channels" }, { {
+            "part", "contentDetails" }, { "id", channel_id } },
             [](const json::Value &root) {
                 Json::Value items = root["items"];
                 Json::Value item = items[0];
                 Json::Value contentDetails = item["contentDetails"];
                 Json::Value relatedPlaylists = contentDetails["relatedPlaylists"];
-                Json::Value uploads = relatedPlaylists["uploads"];;
+                Json::Value uploads = relatedPlaylists["uploads"];
+                if (uploads.asString().empty()) {
+                    throw domain_error("No uploads playlist for channel");
+                }
                 return uploads.asString();
         });
 }
 
+string Client::derive_uploads_playlist(const string &channel_id) {
+    // Standard channel ids are "UC" followed by 22 characters, and the
+    // uploads playlist is the same id with a "UU" prefix
+    if (channel_id.size() != 24 || channel_id.compare(0, 2, "UC") != 0) {
+        return string();
+    }
+    return "UU" + channel_id.substr(2);
+}
+
 future<Client::SubscriptionItemList> Client::subscription_items(
-        const string &playlistId) {
-    return p->async_get<SubscriptionItemList>( { "youtube", "v3", "playlistItems" },
-            { { "part", "snippet" }, { "playlistId", playlistId }, {"maxResults", "50"}  },
+        const string &playlistId, unsigned int max_results) {
+    return p->async_get<SubscriptionItemList>(abort_, { "youtube", "v3", "playlistItems" },
+            { { "part", "snippet" }, { "playlistId", playlistId }, {"maxResults", to_string(max_results)}  },
             [](const json::Value &root) {
                 return get_typed_list<SubscriptionItem>("youtube#playlistItem", root);
             });
 }
 
 future<Client::ChannelList> Client::category_channels(
-        const string &categoryId) {
-    return p->async_get<ChannelList>( { "youtube", "v3", "channels" }, { {
-            "part", "snippet,statistics" }, { "categoryId", categoryId } },
+        const string &categoryId, unsigned int max_results) {
+    net::Uri::QueryParameters params = { { "part", "snippet,statistics" },
+            { "categoryId", categoryId } };
+    if (max_results > 0) {
+        params.emplace_back("maxResults", to_string(max_results));
+    }
+    return p->async_get<ChannelList>(abort_, { "youtube", "v3", "channels" }, params,
             [](const json::Value &root) {
                 return get_typed_list<Channel>("youtube#channel", root);
             });
@@ -415,7 +741,7 @@ future<Client::ChannelList> Client::category_channels(
 
 future<Client::ChannelList> Client::channels_statistics(
         const string &channelId) {
-    return p->async_get<ChannelList>( { "youtube", "v3", "channels" }, { {
+    return p->async_get<ChannelList>(abort_, { "youtube", "v3", "channels" }, { {
             "part", "statistics,snippet" }, { "id", channelId } },
             [](const json::Value &root) {
                 return get_typed_list<Channel>("youtube#channel", root);
@@ -424,7 +750,7 @@ future<Client::ChannelList> Client::channels_statistics(
 
 future<Client::ChannelSectionList> Client::channel_sections(
         const string &channelId, int maxResults) {
-    return p->async_get<ChannelSectionList>( { "youtube", "v3",
+    return p->async_get<ChannelSectionList>(abort_, { "youtube", "v3",
             "channelSections" }, { { "part", "contentDetails" }, { "channelId",
             channelId }, { "maxResults", to_string(maxResults) } },
             [](const json::Value &root) {
@@ -432,29 +758,39 @@ future<Client::ChannelSectionList> Client::channel_sections(
             });
 }
 
-future<Client::VideoList> Client::channel_videos(const string &channelId) {
-    return p->async_get<VideoList>( { "youtube", "v3", "search" }, { { "part",
-            "snippet" }, { "type", "video" }, { "order", "viewCount" }, {
-            "channelId", channelId } }, [](const json::Value &root) {
-        return get_typed_list<Video>("youtube#video", root);
-    });
+future<Client::VideoList> Client::channel_videos(const string &channelId,
+        unsigned int max_results) {
+    net::Uri::QueryParameters params = { { "part", "snippet" },
+            { "type", "video" }, { "order", "viewCount" },
+            { "channelId", channelId } };
+    if (max_results > 0) {
+        params.emplace_back("maxResults", to_string(max_results));
+    }
+    return p->async_get<VideoList>(abort_, { "youtube", "v3", "search" }, params,
+            [](const json::Value &root) {
+                return get_typed_list<Video>("youtube#video", root);
+            });
 }
 
 future<Client::VideoList> Client::chart_videos(const string &chart_name,
-        const string &region_code, const std::string &category_id) {
+        const string &region_code, const std::string &category_id,
+        unsigned int max_results) {
     net::Uri::QueryParameters params = { { "part", "snippet" }, { "regionCode", region_code }, { "chart", chart_name } };
 
     if (!category_id.empty()) {
         params.emplace_back(make_pair("videoCategoryId", category_id));
     }
-    return p->async_get<VideoList>( { "youtube", "v3", "videos" },
+    if (max_results > 0) {
+        params.emplace_back("maxResults", to_string(max_results));
+    }
+    return p->async_get<VideoList>(abort_, { "youtube", "v3", "videos" },
             params, [](const json::Value &root) {
                 return get_typed_list<Video>("youtube#video", root);
             });
 }
 
 future<Client::VideoList> Client::videos(const string &video_id) {
-    return p->async_get<VideoList>( { "youtube", "v3", "videos" }, { { "part",
+    return p->async_get<VideoList>(abort_, { "youtube", "v3", "videos" }, { { "part",
             "snippet,statistics" }, { "id", video_id } },
             [](const json::Value &root) {
                 return get_typed_list<Video>("youtube#video", root);
@@ -462,25 +798,34 @@ future<Client::VideoList> Client::videos(const string &video_id) {
 }
 
 future<Client::PlaylistList> Client::channel_playlists(
-        const string &channelId) {
-    return p->async_get<PlaylistList>( { "youtube", "v3", "playlists" }, { {
-            "part", "snippet,contentDetails" }, { "channelId", channelId } },
+        const string &channelId, unsigned int max_results) {
+    net::Uri::QueryParameters params = { { "part", "snippet,contentDetails" },
+            { "channelId", channelId } };
+    if (max_results > 0) {
+        params.emplace_back("maxResults", to_string(max_results));
+    }
+    return p->async_get<PlaylistList>(abort_, { "youtube", "v3", "playlists" }, params,
             [](const json::Value &root) {
                 return get_typed_list<Playlist>("youtube#playlist", root);
             });
 }
 
 future<Client::PlaylistItemList> Client::playlist_items(
-        const string &playlistId) {
-    return p->async_get<PlaylistItemList>( { "youtube", "v3", "playlistItems" },
-            { { "part", "snippet,contentDetails" }, { "playlistId", playlistId } },
+        const string &playlistId, unsigned int max_results) {
+    net::Uri::QueryParameters params = { { "part", "snippet,contentDetails" },
+            { "playlistId", playlistId } };
+    if (max_results > 0) {
+        params.emplace_back("maxResults", to_string(max_results));
+    }
+    return p->async_get<PlaylistItemList>(abort_, { "youtube", "v3", "playlistItems" },
+            params,
             [](const json::Value &root) {
                 return get_typed_list<PlaylistItem>("youtube#playlistItem", root);
             });
 }
 
 future<Client::CommentList> Client::video_comments(const std::string &videoId) {
-    return p->async_get<CommentList>( { "youtube", "v3", "commentThreads" },
+    return p->async_get<CommentList>(abort_, { "youtube", "v3", "commentThreads" },
             { { "part", "snippet" }, {"order", "time"}, { "videoId", videoId },
               { "textFormat", "plainText"}, {"maxResults","15"}},
             [](const json::Value &root) {
@@ -514,7 +859,7 @@ future<bool> Client::rate(const string &videoId, bool likes) {
 }
 
 future<Client::SubscriptionList> Client::subscribeId(const string &channelId) {
-    return p->async_get<SubscriptionList>( { "youtube", "v3", "subscriptions" }, { {
+    return p->async_get<SubscriptionList>(abort_, { "youtube", "v3", "subscriptions" }, { {
             "part", "snippet" }, { "mine", "true" }, {"forChannelId", channelId} },
             [](const json::Value &root) {
                 return get_typed_list<Subscription>("youtube#subscription", root);
@@ -566,6 +911,31 @@ void Client::cancel() {
     p->cancelled_ = true;
 }
 
+bool Client::cancelled() {
+    return p->cancelled_;
+}
+
 bool Client::authenticated() {
     return p->authenticated();
 }
+
+unsigned int Client::account_id() {
+    return p->account_id();
+}
+
+void Client::set_deadline(const Deadline &deadline) {
+    lock_guard<mutex> lock(p->deadline_mutex_);
+    p->deadline_ = deadline;
+}
+
+Deadline Client::deadline() {
+    return p->deadline();
+}
+
+unsigned long Client::quota_used() {
+    return p->quota_used_;
+}
+
+unsigned long Client::total_quota_used() {
+    return QuotaBudget::instance()->stats().spent;
+}
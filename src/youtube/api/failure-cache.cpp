@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/failure-cache.h>
+
+using namespace std;
+using namespace youtube::api;
+
+namespace {
+
+mutex instance_mutex;
+FailureCache::Ptr shared_instance;
+
+}
+
+FailureCache::Ptr FailureCache::instance() {
+    lock_guard<mutex> lock(instance_mutex);
+    if (!shared_instance) {
+        shared_instance = make_shared<FailureCache>();
+    }
+    return shared_instance;
+}
+
+void FailureCache::reset_instance() {
+    lock_guard<mutex> lock(instance_mutex);
+    shared_instance.reset();
+}
+
+FailureCache::FailureCache(chrono::seconds ttl, size_t max_entries) :
+        ttl_(ttl), max_entries_(max_entries) {
+}
+
+bool FailureCache::get(const string &request, string &message) {
+    bool not_found;
+    return get(request, message, not_found);
+}
+
+bool FailureCache::get(const string &request, string &message,
+        bool &not_found) {
+    lock_guard<mutex> lock(mutex_);
+
+    auto it = entries_.find(request);
+    if (it == entries_.end()) {
+        return false;
+    }
+
+    if (chrono::steady_clock::now() - it->second.stored > ttl_) {
+        order_.erase(it->second.position);
+        entries_.erase(it);
+        return false;
+    }
+
+    message = it->second.message;
+    not_found = it->second.not_found;
+    ++hits_;
+    return true;
+}
+
+void FailureCache::put(const string &request, const string &message,
+        bool not_found) {
+    lock_guard<mutex> lock(mutex_);
+
+    auto it = entries_.find(request);
+    if (it != entries_.end()) {
+        order_.erase(it->second.position);
+        entries_.erase(it);
+    }
+
+    order_.emplace_back(request);
+    entries_[request] = Entry { message, not_found, chrono::steady_clock::now(),
+            prev(order_.end()) };
+
+    while (entries_.size() > max_entries_) {
+        entries_.erase(order_.front());
+        order_.pop_front();
+    }
+}
+
+unsigned long FailureCache::hits() {
+    lock_guard<mutex> lock(mutex_);
+    return hits_;
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/quota-budget.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+using namespace youtube::api;
+
+namespace {
+
+static const chrono::hours DAY(24);
+
+// Spending is recorded in buckets of this size
+static const chrono::minutes BUCKET(15);
+
+// Pacific Standard Time. During daylight saving time this makes us wait
+// an hour longer than we need to, which is the safe side.
+static const chrono::hours PACIFIC_OFFSET(-8);
+
+mutex instance_mutex;
+QuotaBudget::Ptr shared_instance;
+
+static const char * level_name(QuotaBudget::Level level) {
+    switch (level) {
+    case QuotaBudget::Level::normal:
+        return "normal";
+    case QuotaBudget::Level::shed_background:
+        return "shedding background requests";
+    case QuotaBudget::Level::cache_only:
+        return "cache only";
+    case QuotaBudget::Level::exhausted:
+        return "exhausted";
+    }
+    return "";
+}
+
+}
+
+QuotaBudget::Ptr QuotaBudget::instance() {
+    lock_guard<mutex> lock(instance_mutex);
+    if (!shared_instance) {
+        unsigned long daily_limit = 10000;
+        if (getenv("YOUTUBE_SCOPE_DAILY_QUOTA")) {
+            daily_limit = strtoul(getenv("YOUTUBE_SCOPE_DAILY_QUOTA"), nullptr, 10);
+        }
+        shared_instance = make_shared<QuotaBudget>(daily_limit);
+    }
+    return shared_instance;
+}
+
+void QuotaBudget::reset_instance() {
+    lock_guard<mutex> lock(instance_mutex);
+    shared_instance.reset();
+}
+
+QuotaBudget::QuotaBudget(unsigned long daily_limit,
+        const Thresholds &thresholds) :
+        daily_limit_(daily_limit), thresholds_(thresholds) {
+}
+
+unsigned int QuotaBudget::cost(const string &resource, bool write) {
+    if (write) {
+        return 50;
+    }
+    if (resource == "search") {
+        return 100;
+    }
+    return 1;
+}
+
+void QuotaBudget::set_daily_limit(unsigned long daily_limit) {
+    lock_guard<mutex> lock(mutex_);
+    daily_limit_ = daily_limit;
+}
+
+void QuotaBudget::charge(unsigned int units) {
+    auto now = Clock::now();
+
+    lock_guard<mutex> lock(mutex_);
+    expire(now);
+    if (buckets_.empty() || now - buckets_.back().start >= BUCKET) {
+        buckets_.emplace_back(Bucket { now, 0 });
+    }
+    buckets_.back().units += units;
+    spent_ += units;
+    stats_.spent += units;
+}
+
+bool QuotaBudget::admit(Scheduler::Priority priority) {
+    auto now = Clock::now();
+
+    lock_guard<mutex> lock(mutex_);
+    Level level = level_locked(now);
+
+    bool admitted;
+    if (priority == Scheduler::Priority::background) {
+        admitted = level == Level::normal;
+    } else {
+        admitted = level != Level::exhausted;
+    }
+
+    if (!admitted) {
+        ++stats_.refused;
+    }
+    return admitted;
+}
+
+void QuotaBudget::quota_exceeded() {
+    auto now = Clock::now();
+
+    lock_guard<mutex> lock(mutex_);
+    ++stats_.quota_exceeded;
+    if (blocked_until_ <= now) {
+        blocked_until_ = next_reset(now);
+        cerr << "YouTube quota exceeded, no more requests for "
+                << chrono::duration_cast<chrono::minutes>(blocked_until_ - now).count()
+                << " minutes" << endl;
+    }
+}
+
+QuotaBudget::Level QuotaBudget::level() {
+    lock_guard<mutex> lock(mutex_);
+    return level_locked(Clock::now());
+}
+
+unsigned long QuotaBudget::spent() {
+    lock_guard<mutex> lock(mutex_);
+    expire(Clock::now());
+    return spent_;
+}
+
+void QuotaBudget::record_query(unsigned long units) {
+    lock_guard<mutex> lock(mutex_);
+    ++stats_.queries;
+    stats_.query_units += units;
+    stats_.peak_query_units = max(stats_.peak_query_units, units);
+}
+
+QuotaBudget::Stats QuotaBudget::stats() {
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+void QuotaBudget::dump_stats(ostream &out) {
+    auto now = Clock::now();
+
+    lock_guard<mutex> lock(mutex_);
+    Level level = level_locked(now);
+    out << "Quota: " << spent_ << "/" << daily_limit_ << " units in the last day ("
+            << level_name(level) << "), " << stats_.spent
+            << " units since start, " << stats_.refused
+            << " requests refused, " << stats_.quota_exceeded
+            << " quota exceeded responses" << endl;
+    if (stats_.queries > 0) {
+        out << "Quota per query: " << stats_.query_units / stats_.queries
+                << " units on average, at most " << stats_.peak_query_units
+                << ", over " << stats_.queries << " queries" << endl;
+    }
+}
+
+QuotaBudget::Clock::time_point QuotaBudget::next_reset(Clock::time_point now) {
+    // Days since the epoch, in Pacific time
+    auto pacific = now.time_since_epoch() + PACIFIC_OFFSET;
+    auto days = chrono::duration_cast<chrono::hours>(pacific).count() / 24;
+    return Clock::time_point(
+            chrono::duration_cast<Clock::duration>(
+                    chrono::hours((days + 1) * 24) - PACIFIC_OFFSET));
+}
+
+void QuotaBudget::expire(Clock::time_point now) {
+    while (!buckets_.empty() && now - buckets_.front().start >= DAY) {
+        spent_ -= buckets_.front().units;
+        buckets_.pop_front();
+    }
+}
+
+QuotaBudget::Level QuotaBudget::level_locked(Clock::time_point now) {
+    if (blocked_until_ > now) {
+        return Level::exhausted;
+    }
+
+    expire(now);
+    if (daily_limit_ == 0) {
+        return Level::normal;
+    }
+
+    double used = double(spent_) / daily_limit_;
+    if (used >= thresholds_.exhausted) {
+        return Level::exhausted;
+    }
+    if (used >= thresholds_.cache_only) {
+        return Level::cache_only;
+    }
+    if (used >= thresholds_.shed_background) {
+        return Level::shed_background;
+    }
+    return Level::normal;
+}
@@ -0,0 +1,426 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/reactor.h>
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace youtube::api;
+
+namespace {
+
+// Every running reactor, so completed requests can wake them all up
+mutex registry_mutex;
+set<Reactor*> registry;
+
+// For threads waiting outside of a task
+mutex waiting_mutex;
+condition_variable waiting;
+
+}
+
+/**
+ * A task together with its own stack, which it can switch away from while
+ * waiting for something.
+ */
+class Reactor::Fiber {
+public:
+    Fiber(Reactor &reactor, const Task &task, size_t stack_size) :
+            reactor_(reactor), task_(task) {
+        page_size_ = sysconf(_SC_PAGESIZE);
+        mapped_size_ = stack_size + page_size_;
+        mapped_ = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+        if (mapped_ == MAP_FAILED) {
+            throw bad_alloc();
+        }
+        // Overflowing the stack should crash, not corrupt the heap
+        mprotect(mapped_, page_size_, PROT_NONE);
+
+        getcontext(&context_);
+        context_.uc_stack.ss_sp = static_cast<char *>(mapped_) + page_size_;
+        context_.uc_stack.ss_size = stack_size;
+        context_.uc_link = nullptr;
+
+        // makecontext only passes int arguments
+        uint64_t address = reinterpret_cast<uintptr_t>(this);
+        makecontext(&context_, reinterpret_cast<void (*)()>(&Fiber::entry), 2,
+                static_cast<unsigned int>(address >> 32),
+                static_cast<unsigned int>(address & 0xffffffff));
+    }
+
+    ~Fiber() {
+        munmap(mapped_, mapped_size_);
+    }
+
+    void resume() {
+        Fiber *previous = current_;
+        current_ = this;
+        swapcontext(&caller_, &context_);
+        current_ = previous;
+    }
+
+    void yield() {
+        swapcontext(&context_, &caller_);
+    }
+
+    Reactor &reactor_;
+
+    Task task_;
+
+    const function<bool()> *ready_ = nullptr;
+
+    TimePoint deadline_;
+
+    bool waiting_ = false;
+
+    bool ready_result_ = false;
+
+    bool finished_ = false;
+
+protected:
+    static void entry(unsigned int high, unsigned int low) {
+        uint64_t address = (static_cast<uint64_t>(high) << 32) | low;
+        Fiber *fiber = reinterpret_cast<Fiber *>(static_cast<uintptr_t>(address));
+
+        try {
+            fiber->task_();
+        } catch (exception &e) {
+            cerr << "Reactor task failed: " << e.what() << endl;
+        } catch (...) {
+            cerr << "Reactor task failed" << endl;
+        }
+
+        // Let go of anything the task captured straight away
+        fiber->task_ = Task();
+        fiber->finished_ = true;
+        fiber->yield();
+    }
+
+    ucontext_t context_;
+
+    ucontext_t caller_;
+
+    void *mapped_;
+
+    size_t mapped_size_;
+
+    size_t page_size_;
+};
+
+thread_local Reactor::Fiber *Reactor::current_ = nullptr;
+
+Reactor::Reactor(size_t threads, size_t stack_size, size_t offload_threads) :
+        threads_(max<size_t>(threads, 1)), stack_size_(stack_size),
+        offload_threads_(max<size_t>(offload_threads, 1)) {
+}
+
+Reactor::~Reactor() {
+    stop();
+}
+
+void Reactor::start() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (running_) {
+            return;
+        }
+        running_ = true;
+        stopping_ = false;
+        workers_.clear();
+        for (size_t i = 0; i < threads_; ++i) {
+            workers_.emplace_back(new Worker);
+            Worker &worker = *workers_.back();
+            worker.thread = thread([this, &worker]() {run(worker);});
+        }
+        offloaders_.clear();
+        for (size_t i = 0; i < offload_threads_; ++i) {
+            offloaders_.emplace_back([this]() {run_offloaded();});
+        }
+    }
+
+    lock_guard<mutex> lock(registry_mutex);
+    registry.insert(this);
+}
+
+void Reactor::stop() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        stopping_ = true;
+    }
+    {
+        lock_guard<mutex> lock(registry_mutex);
+        registry.erase(this);
+    }
+
+    wakeup_.notify_all();
+    offload_wakeup_.notify_all();
+    for (auto &worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+    for (thread &offloader : offloaders_) {
+        if (offloader.joinable()) {
+            offloader.join();
+        }
+    }
+
+    // Nobody is waiting for what didn't get started
+    lock_guard<mutex> lock(mutex_);
+    offloaded_.clear();
+}
+
+bool Reactor::spawn(const Task &task) {
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!running_) {
+            return false;
+        }
+        spawned_.emplace_back(task);
+        ++stats_.spawned;
+    }
+    wakeup_.notify_one();
+    return true;
+}
+
+Reactor::Stats Reactor::stats() {
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+bool Reactor::in_task() {
+    return current_ != nullptr;
+}
+
+bool Reactor::suspend(const function<bool()> &ready, TimePoint deadline) {
+    Fiber *fiber = current_;
+    if (!fiber) {
+        throw logic_error("Reactor::suspend called outside of a task");
+    }
+    // The exceptions being handled belong to the thread, not the task, so
+    // any other task we switched to would see ours and could end it
+    if (current_exception() || uncaught_exception()) {
+        throw logic_error("Reactor::suspend called while handling an exception");
+    }
+    Reactor &reactor = fiber->reactor_;
+
+    if (ready()) {
+        return true;
+    }
+
+    {
+        lock_guard<mutex> lock(reactor.mutex_);
+        if (reactor.stopping_) {
+            throw domain_error("Reactor stopped");
+        }
+        fiber->ready_ = &ready;
+        fiber->deadline_ = deadline;
+        fiber->waiting_ = true;
+    }
+
+    fiber->yield();
+
+    lock_guard<mutex> lock(reactor.mutex_);
+    fiber->ready_ = nullptr;
+    if (reactor.stopping_) {
+        throw domain_error("Reactor stopped");
+    }
+    return fiber->ready_result_;
+}
+
+bool Reactor::wait(const function<bool()> &ready, TimePoint deadline) {
+    if (in_task()) {
+        return suspend(ready, deadline);
+    }
+
+    // ready() is checked with the lock held, so a notification can't slip
+    // in between checking and waiting
+    unique_lock<mutex> lock(waiting_mutex);
+    while (!ready()) {
+        if (deadline == TimePoint::max()) {
+            waiting.wait(lock);
+        } else if (waiting.wait_until(lock, deadline) == cv_status::timeout) {
+            return ready();
+        }
+    }
+    return true;
+}
+
+void Reactor::queue_offload(const Task &work) {
+    Fiber *fiber = current_;
+    if (!fiber) {
+        throw logic_error("Reactor::offload called outside of a task");
+    }
+    Reactor &reactor = fiber->reactor_;
+
+    {
+        lock_guard<mutex> lock(reactor.mutex_);
+        if (reactor.stopping_) {
+            throw domain_error("Reactor stopped");
+        }
+        reactor.offloaded_.emplace_back(work);
+        ++reactor.stats_.offloaded;
+    }
+    reactor.offload_wakeup_.notify_one();
+}
+
+void Reactor::run_offloaded() {
+    unique_lock<mutex> lock(mutex_);
+    while (true) {
+        offload_wakeup_.wait(lock, [this]() {
+            return !offloaded_.empty() || stopping_;
+        });
+        if (stopping_) {
+            break;
+        }
+
+        Task work = offloaded_.front();
+        offloaded_.pop_front();
+        lock.unlock();
+        work();
+        // Whoever offloaded it is waiting to hear
+        notify_all();
+        lock.lock();
+    }
+}
+
+void Reactor::notify_all() {
+    {
+        lock_guard<mutex> lock(registry_mutex);
+        for (Reactor *reactor : registry) {
+            reactor->notify();
+        }
+    }
+
+    lock_guard<mutex> lock(waiting_mutex);
+    waiting.notify_all();
+}
+
+void Reactor::notify() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        ++notifications_;
+    }
+    // Any of the threads may have a task waiting for this
+    wakeup_.notify_all();
+}
+
+void Reactor::run(Worker &worker) {
+    unique_lock<mutex> lock(mutex_);
+    while (true) {
+        unsigned long seen = notifications_;
+
+        // Take one new task per pass, so they spread over the threads
+        if (!spawned_.empty()) {
+            Task task = spawned_.front();
+            spawned_.pop_front();
+            if (!spawned_.empty()) {
+                wakeup_.notify_one();
+            }
+
+            bool allocated = true;
+            try {
+                worker.fibers.emplace_back(new Fiber(*this, task, stack_size_));
+            } catch (bad_alloc &e) {
+                allocated = false;
+            }
+            if (!allocated) {
+                // No room for another stack, so run it the old fashioned way
+                cerr << "Reactor could not allocate a stack" << endl;
+                lock.unlock();
+                try {
+                    task();
+                } catch (exception &e) {
+                    cerr << "Reactor task failed: " << e.what() << endl;
+                } catch (...) {
+                    cerr << "Reactor task failed" << endl;
+                }
+                lock.lock();
+                ++stats_.completed;
+                continue;
+            }
+            ++stats_.active;
+            stats_.peak_active = max(stats_.peak_active, stats_.active);
+        }
+
+        vector<Fiber*> runnable;
+        auto now = chrono::steady_clock::now();
+        TimePoint next_deadline = TimePoint::max();
+        for (auto &fiber : worker.fibers) {
+            if (!fiber->waiting_) {
+                // Not started yet
+                runnable.emplace_back(fiber.get());
+                continue;
+            }
+
+            bool ready = (*fiber->ready_)();
+            if (ready || stopping_ || now >= fiber->deadline_) {
+                fiber->ready_result_ = ready;
+                fiber->waiting_ = false;
+                runnable.emplace_back(fiber.get());
+            } else {
+                next_deadline = min(next_deadline, fiber->deadline_);
+            }
+        }
+
+        if (runnable.empty()) {
+            if (stopping_ && worker.fibers.empty() && spawned_.empty()) {
+                break;
+            }
+
+            auto woken = [this, seen]() {
+                return notifications_ != seen || !spawned_.empty() || stopping_;
+            };
+            if (next_deadline == TimePoint::max()) {
+                wakeup_.wait(lock, woken);
+            } else {
+                wakeup_.wait_until(lock, next_deadline, woken);
+            }
+            continue;
+        }
+
+        lock.unlock();
+        for (Fiber *fiber : runnable) {
+            fiber->resume();
+        }
+        lock.lock();
+
+        for (auto it = worker.fibers.begin(); it != worker.fibers.end();) {
+            if ((*it)->finished_) {
+                it = worker.fibers.erase(it);
+                ++stats_.completed;
+                --stats_.active;
+            } else {
+                ++it;
+            }
+        }
+    }
+}
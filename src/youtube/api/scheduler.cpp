@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/scheduler.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace youtube::api;
+
+namespace {
+
+static const Scheduler::Priority PRIORITIES[] = {
+        Scheduler::Priority::interactive, Scheduler::Priority::foreground,
+        Scheduler::Priority::background };
+
+mutex instance_mutex;
+Scheduler::Ptr shared_instance;
+
+}
+
+Scheduler::Ptr Scheduler::instance() {
+    lock_guard<mutex> lock(instance_mutex);
+    if (!shared_instance) {
+        shared_instance = make_shared<Scheduler>();
+    }
+    return shared_instance;
+}
+
+void Scheduler::reset_instance() {
+    lock_guard<mutex> lock(instance_mutex);
+    shared_instance.reset();
+}
+
+Scheduler::Scheduler(const Limits &limits) :
+        limits_(limits) {
+}
+
+void Scheduler::set_limits(const Limits &limits) {
+    {
+        lock_guard<mutex> lock(mutex_);
+        limits_ = limits;
+    }
+    dispatch();
+}
+
+Scheduler::Limits Scheduler::limits() {
+    lock_guard<mutex> lock(mutex_);
+    return limits_;
+}
+
+Scheduler::Stats Scheduler::stats(Priority priority) {
+    lock_guard<mutex> lock(mutex_);
+    return stats_[priority];
+}
+
+size_t Scheduler::in_flight() {
+    lock_guard<mutex> lock(mutex_);
+    return in_flight_.size();
+}
+
+size_t Scheduler::capacity(Priority priority) const {
+    size_t foreground = max<size_t>(
+            limits_.max_in_flight > limits_.reserved_interactive ?
+                    limits_.max_in_flight - limits_.reserved_interactive : 0,
+            1);
+
+    switch (priority) {
+    case Priority::interactive:
+        return max<size_t>(limits_.max_in_flight, 1);
+    case Priority::foreground:
+        return foreground;
+    case Priority::background:
+        return max<size_t>(min(limits_.max_background, foreground), 1);
+    }
+    return 1;
+}
+
+void Scheduler::submit(const void *owner, Priority priority, const Job &job) {
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto &queue = queued_[priority];
+        queue.emplace_back(Queued { next_ticket_++, owner, job });
+
+        Stats &stats = stats_[priority];
+        stats.queued = queue.size();
+        stats.peak_queued = max(stats.peak_queued, stats.queued);
+    }
+    dispatch();
+}
+
+void Scheduler::forget(const void *owner) {
+    {
+        unique_lock<mutex> lock(mutex_);
+        for (Priority priority : PRIORITIES) {
+            auto &queue = queued_[priority];
+            queue.erase(
+                    remove_if(queue.begin(), queue.end(),
+                            [owner](const Queued &queued) {
+                                return queued.owner == owner;
+                            }), queue.end());
+            stats_[priority].queued = queue.size();
+        }
+
+        for (auto it = in_flight_.begin(); it != in_flight_.end();) {
+            if (it->second == owner) {
+                it = in_flight_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        started_.wait(lock, [this, owner]() {
+            return starting_.count(owner) == 0;
+        });
+    }
+
+    // Someone else can have the slots we just gave up
+    dispatch();
+}
+
+void Scheduler::finished(unsigned long ticket) {
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (in_flight_.erase(ticket) == 0) {
+            // Already released by forget()
+            return;
+        }
+    }
+    dispatch();
+}
+
+void Scheduler::dispatch() {
+    vector<Queued> ready;
+    {
+        lock_guard<mutex> lock(mutex_);
+        for (Priority priority : PRIORITIES) {
+            auto &queue = queued_[priority];
+            while (!queue.empty() && in_flight_.size() < capacity(priority)) {
+                ready.emplace_back(queue.front());
+                queue.pop_front();
+
+                in_flight_[ready.back().ticket] = ready.back().owner;
+                starting_.insert(ready.back().owner);
+                ++stats_[priority].started;
+            }
+            stats_[priority].queued = queue.size();
+        }
+    }
+
+    Ptr self = shared_from_this();
+    for (const Queued &queued : ready) {
+        unsigned long ticket = queued.ticket;
+        try {
+            queued.job([self, ticket]() {
+                self->finished(ticket);
+            });
+        } catch (exception &e) {
+            cerr << "Failed to start request: " << e.what() << endl;
+            finished(ticket);
+        }
+
+        {
+            lock_guard<mutex> lock(mutex_);
+            starting_.erase(starting_.find(queued.owner));
+        }
+        started_.notify_all();
+    }
+}
@@ -18,6 +18,8 @@
 
 #include <youtube/api/subscription-item.h>
 
+#include <cstdio>
+#include <ctime>
 #include <iostream>
 #include <json/json.h>
 
@@ -26,6 +28,25 @@ namespace json = Json;
 using namespace youtube::api;
 using namespace std;
 
+namespace {
+
+/**
+ * Parses an ISO 8601 UTC timestamp such as 2014-07-01T17:01:10.000Z
+ */
+static int64_t parse_timestamp(const string &timestamp) {
+    struct tm time = tm();
+    if (sscanf(timestamp.c_str(), "%d-%d-%dT%d:%d:%d", &time.tm_year,
+            &time.tm_mon, &time.tm_mday, &time.tm_hour, &time.tm_min,
+            &time.tm_sec) != 6) {
+        return 0;
+    }
+    time.tm_year -= 1900;
+    time.tm_mon -= 1;
+    return timegm(&time);
+}
+
+}
+
 SubscriptionItem::SubscriptionItem(const json::Value &data) {
     string kind = data["kind"].asString();
 
@@ -41,6 +62,7 @@ SubscriptionItem::SubscriptionItem(const json::Value &data) {
     title_ = snippet["title"].asString();
     description_ = snippet["description"].asString();
     username_ = snippet["channelTitle"].asString();
+    published_at_ = parse_timestamp(snippet["publishedAt"].asString());
 
     json::Value thumbnails = snippet["thumbnails"];
     json::Value picture = thumbnails["high"];
@@ -80,6 +102,10 @@ const std::string & SubscriptionItem::description() const {
     return description_;
 }
 
+int64_t SubscriptionItem::published_at() const {
+    return published_at_;
+}
+
 Resource::Kind SubscriptionItem::kind() const {
     return Resource::Kind::subscriptionItem;
 }
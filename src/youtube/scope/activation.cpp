@@ -43,10 +43,28 @@ static T get_or_throw(future<T> &f) {
 Activation::Activation(const sc::Result &result,
                const sc::ActionMetadata &metadata,
                std::string const& action_id,
-               std::shared_ptr<sc::OnlineAccountClient> oa_client) : 
+               std::shared_ptr<sc::OnlineAccountClient> oa_client,
+               DepartmentCache::Ptr department_cache,
+               ResultCache::Ptr result_cache,
+               BrowseCache::Ptr browse_cache) :
     sc::ActivationQueryBase(result, metadata), 
     action_id_(action_id),
-    client_(oa_client) {
+    client_(oa_client, Scheduler::Priority::interactive),
+    department_cache_(department_cache),
+    result_cache_(result_cache),
+    browse_cache_(browse_cache) {
+}
+
+void Activation::results_changed() {
+    // The reply of any query of this account may be out of date now, and
+    // so may the contents of its own playlists
+    string account = to_string(client_.account_id());
+    if (result_cache_) {
+        result_cache_->invalidate(account);
+    }
+    if (browse_cache_) {
+        browse_cache_->invalidate(BrowseCache::Type::playlist, account);
+    }
 }
 
 sc::ActivationResponse Activation::activate() {
@@ -68,24 +86,40 @@ sc::ActivationResponse Activation::activate() {
             auto status = get_or_throw(like_future);
             cout<< "auth user likes video: " << status << endl;
 
+            if (status) {
+                results_changed();
+            }
+
             return sc::ActivationResponse(sc::ActivationResponse::Status::ShowPreview);
         } else if (action_id_ == "thumb_down") {
             future<bool> ret_future = client_.rate(vid, false);
             auto status = get_or_throw(ret_future);
             cout<< "auth user dislike video: " << status << endl;
 
+            if (status) {
+                results_changed();
+            }
+
             return sc::ActivationResponse(sc::ActivationResponse::Status::ShowPreview);
         } else if (action_id_ == "add_fav_list") {
             future<bool> fav_future = client_.addVideoIntoPlayList(vid, fav_listid);
             auto status = get_or_throw(fav_future);
             cout<< "auth user add video in fav list: " << status << endl;
 
+            if (status) {
+                results_changed();
+            }
+
             return sc::ActivationResponse(sc::ActivationResponse::Status::ShowPreview);
         } else if (action_id_ == "add_watch_list") {
             future<bool> watch_future = client_.addVideoIntoPlayList(vid, watch_listid);
             auto status = get_or_throw(watch_future);
             cout<< "auth user add video in watch later list: " << status << endl;
 
+            if (status) {
+                results_changed();
+            }
+
             return sc::ActivationResponse(sc::ActivationResponse::Status::ShowPreview);
         } else if (alg::starts_with(action_id_,"subscribe:")) {
             auto cid = action_id_.substr(string("subscribe:").length());
@@ -93,6 +127,15 @@ sc::ActivationResponse Activation::activate() {
             auto status = get_or_throw(subscribe_future);
             cout<< "auth user subscribe channel: " << status << endl;
 
+            if (status) {
+                results_changed();
+            }
+
+            // The subscriptions department has changed
+            if (status && department_cache_) {
+                department_cache_->invalidate(to_string(client_.account_id()));
+            }
+
             return sc::ActivationResponse(sc::ActivationResponse::Status::ShowPreview);
         } else if (alg::starts_with(action_id_,"unsubscribe:")) {
             auto cid = action_id_.substr(string("unsubscribe:").length());
@@ -100,6 +143,15 @@ sc::ActivationResponse Activation::activate() {
             auto status = get_or_throw(unsubscribe_future);
             cout<< "auth user unsubscribe channel: " << status << endl;
 
+            if (status) {
+                results_changed();
+            }
+
+            // The subscriptions department has changed
+            if (status && department_cache_) {
+                department_cache_->invalidate(to_string(client_.account_id()));
+            }
+
             return sc::ActivationResponse(sc::ActivationResponse::Status::ShowPreview);
         }
     }catch (domain_error &e) {
@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/scope/browse-cache.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace {
+
+static const char * type_name(BrowseCache::Type type) {
+    switch (type) {
+    case BrowseCache::Type::category_videos:
+        return "guideCategory-videos";
+    case BrowseCache::Type::category_playlists:
+        return "guideCategory-playlists";
+    case BrowseCache::Type::category_channels:
+        return "guideCategory-channels";
+    case BrowseCache::Type::playlist:
+        return "playlist";
+    }
+    return "";
+}
+
+}
+
+BrowseCache::BrowseCache(
+        shared_ptr<unity::scopes::OnlineAccountClient> oa_client,
+        size_t max_entries) :
+        oa_client_(oa_client), max_entries_(max_entries) {
+    policies_[Type::category_videos] = { chrono::minutes(15), chrono::hours(2) };
+    policies_[Type::category_playlists] = { chrono::minutes(15), chrono::hours(2) };
+    policies_[Type::category_channels] = { chrono::minutes(30), chrono::hours(6) };
+    policies_[Type::playlist] = { chrono::minutes(5), chrono::hours(1) };
+
+    if (getenv("YOUTUBE_SCOPE_BROWSE_POLICY")) {
+        configure(getenv("YOUTUBE_SCOPE_BROWSE_POLICY"));
+    }
+}
+
+BrowseCache::~BrowseCache() {
+    stop();
+}
+
+void BrowseCache::set_policy(Type type, const Policy &policy) {
+    lock_guard<mutex> lock(mutex_);
+    policies_[type] = policy;
+}
+
+BrowseCache::Policy BrowseCache::policy(Type type) {
+    lock_guard<mutex> lock(mutex_);
+    return policies_[type];
+}
+
+void BrowseCache::configure(const string &policies) {
+    istringstream in(policies);
+    string policy;
+    while (getline(in, policy, ',')) {
+        size_t equals = policy.find('=');
+        size_t colon = policy.find(':', equals);
+        if (equals == string::npos || colon == string::npos) {
+            cerr << "Ignoring browse policy '" << policy << "'" << endl;
+            continue;
+        }
+
+        string name = policy.substr(0, equals);
+        long soft_ttl = strtol(policy.substr(equals + 1, colon - equals - 1).c_str(),
+                nullptr, 10);
+        long hard_ttl = strtol(policy.substr(colon + 1).c_str(), nullptr, 10);
+        bool known = false;
+        for (Type type : { Type::category_videos, Type::category_playlists,
+                Type::category_channels, Type::playlist }) {
+            if (name == type_name(type) && soft_ttl >= 0 && hard_ttl >= soft_ttl) {
+                set_policy(type, Policy { chrono::seconds(soft_ttl),
+                        chrono::seconds(hard_ttl) });
+                known = true;
+            }
+        }
+        if (!known) {
+            cerr << "Ignoring browse policy '" << policy << "'" << endl;
+        }
+    }
+}
+
+size_t BrowseCache::size() {
+    lock_guard<mutex> lock(mutex_);
+    return entries_.size();
+}
+
+void BrowseCache::invalidate(Type type, const string &account) {
+    // Keys start with the account, see Query::browse
+    string prefix = make_key(type, account + "|");
+
+    lock_guard<mutex> lock(mutex_);
+    auto it = entries_.lower_bound(prefix);
+    while (it != entries_.end()
+            && it->first.compare(0, prefix.size(), prefix) == 0) {
+        recently_used_.erase(it->second.position);
+        it = entries_.erase(it);
+    }
+}
+
+BrowseCache::Stats BrowseCache::stats(Type type) {
+    lock_guard<mutex> lock(mutex_);
+    return stats_[type];
+}
+
+void BrowseCache::dump_stats(ostream &out) {
+    lock_guard<mutex> lock(mutex_);
+    for (const auto &it : stats_) {
+        const Stats &stats = it.second;
+        unsigned long total = stats.fresh + stats.stale + stats.misses;
+        if (total == 0) {
+            continue;
+        }
+        out << "Browse cache " << type_name(it.first) << ": " << total
+                << " queries, " << stats.fresh << " fresh, " << stats.stale
+                << " stale (" << (100 * stats.stale / total) << "%), "
+                << stats.misses << " misses, " << stats.refreshes
+                << " refreshes, " << stats.failed_refreshes
+                << " failed refreshes, " << stats.degraded
+                << " degraded lists not stored" << endl;
+    }
+}
+
+void BrowseCache::stop() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopped_ = true;
+        refreshes_.clear();
+        if (client_) {
+            client_->cancel();
+        }
+    }
+    wakeup_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+string BrowseCache::make_key(Type type, const string &key) {
+    return string(type_name(type)) + ":" + key;
+}
+
+void BrowseCache::store(const string &full_key, shared_ptr<const void> value,
+        bool refresh) {
+    lock_guard<mutex> lock(mutex_);
+    auto it = entries_.find(full_key);
+    if (it == entries_.end()) {
+        if (refresh) {
+            return;
+        }
+        recently_used_.emplace_front(full_key);
+        it = entries_.emplace(full_key, Entry()).first;
+        it->second.position = recently_used_.begin();
+    } else if (refresh && !it->second.refreshing) {
+        return;
+    }
+
+    it->second.value = value;
+    it->second.stored = chrono::steady_clock::now();
+    it->second.refreshing = false;
+
+    while (entries_.size() > max_entries_) {
+        entries_.erase(recently_used_.back());
+        recently_used_.pop_back();
+    }
+}
+
+void BrowseCache::erase(map<string, Entry>::iterator it) {
+    // Called with the mutex held
+    recently_used_.erase(it->second.position);
+    entries_.erase(it);
+}
+
+void BrowseCache::queue_refresh(Type type, const string &full_key,
+        const Fetcher &fetch) {
+    // Called with the mutex held
+    if (stopped_) {
+        return;
+    }
+
+    refreshes_.emplace_back(Refresh { type, full_key, fetch });
+
+    if (!running_) {
+        running_ = true;
+        worker_ = thread([this]() {run();});
+    }
+    wakeup_.notify_one();
+}
+
+void BrowseCache::run() {
+    unique_lock<mutex> lock(mutex_);
+    while (!stopped_) {
+        wakeup_.wait(lock, [this]() {
+            return stopped_ || !refreshes_.empty();
+        });
+
+        while (!stopped_ && !refreshes_.empty()) {
+            Refresh refresh = refreshes_.front();
+            refreshes_.pop_front();
+
+            if (!client_) {
+                client_ = make_shared<Client>(oa_client_, Scheduler::Priority::background);
+            }
+            auto client = client_;
+
+            lock.unlock();
+            shared_ptr<const void> value;
+            try {
+                value = refresh.fetch(*client);
+            } catch (exception &e) {
+                cerr << "Refreshing " << refresh.key << " failed: " << e.what()
+                        << endl;
+            }
+            if (value) {
+                store(refresh.key, value, true);
+            }
+            lock.lock();
+
+            if (value) {
+                ++stats_[refresh.type].refreshes;
+            } else {
+                ++stats_[refresh.type].failed_refreshes;
+                auto it = entries_.find(refresh.key);
+                if (it != entries_.end()) {
+                    it->second.refreshing = false;
+                }
+            }
+        }
+
+        client_.reset();
+    }
+}
@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/deadline.h>
+#include <youtube/api/fan-out.h>
+#include <youtube/api/not-found.h>
+#include <youtube/api/reactor.h>
+#include <youtube/scope/category-snapshot.h>
+#include <youtube/scope/duplicate-filter.h>
+#include <youtube/scope/partial-reply.h>
+
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace {
+static constexpr bool DEBUG_MODE = false;
+
+// playlistItems.list returns this many items unless asked otherwise
+static const unsigned int SECTION_SIZE = 5;
+
+// Guide categories are named "GC" followed by their title in base64, and
+// don't tell us which video category they match. Only the ones that are the
+// same as a video category are here; the chart of a broader or narrower
+// video category would be the wrong videos, so the rest use fetch().
+static const map<string, string> VIDEO_CATEGORIES {
+    { "GCTXVzaWM", "10" }, // Music
+    { "GCQ29tZWR5", "23" }, // Comedy
+    { "GCR2FtaW5n", "20" }, // Gaming
+    { "GCQXV0b21vdGl2ZQ", "2" }, // Automotive
+    { "GCU3BvcnRz", "17" }, // Sports
+    { "GCQ2F1c2VzICYgTm9uLXByb2ZpdHM", "29" }, // Causes & Non-profits
+    { "GCTmV3cyAmIFBvbGl0aWNz", "25" }, // News & Politics
+};
+
+template<typename T>
+static T get_or_throw(future<T> &f, const Deadline &deadline) {
+    Deadline wait = deadline.within(std::chrono::seconds(10));
+    if (Reactor::await(f, wait.remaining()) != future_status::ready) {
+        throw domain_error("HTTP request timeout");
+    }
+    return f.get();
+}
+
+/**
+ * Adds a section for each of the category's channels, as far down the list
+ * as it takes to fill the budget.
+ */
+static void fetch_sections(Client &client, CategorySnapshot &snapshot,
+        FeaturedPlaylistCache::Ptr featured_playlists,
+        const ResultBudget &budget, DuplicateFilter &filter,
+        PartialReply &partial) {
+    const string &category_id = snapshot.category_id;
+
+    if (DEBUG_MODE) {
+        cerr << "Finding channels: " << category_id << endl;
+    }
+
+    auto channels_future = client.category_channels(category_id);
+    auto channels = get_or_throw(channels_future, client.deadline());
+
+    // Only go as far down the list as it takes to fill the budget
+    unsigned int section_size = budget.branch_page_size(SECTION_SIZE);
+    channels.resize(budget.branches(channels.size(),
+            section_size > 0 ? section_size : SECTION_SIZE));
+
+    // Find the featured playlist of each channel we don't already know
+    vector<string> playlist_ids(channels.size());
+    vector<bool> cached(channels.size(), false);
+    vector<size_t> lookups;
+    FanOut<Client::ChannelSectionList> sections_fan_out;
+    for (size_t channel_number = 0; channel_number < channels.size(); ++channel_number) {
+        Channel::Ptr channel = channels[channel_number];
+        if (DEBUG_MODE) {
+            cerr << "  channel: " << channel->id() << " " << channel->title()
+                    << endl;
+        }
+        if (featured_playlists
+                && featured_playlists->get(channel->id(),
+                        playlist_ids[channel_number])) {
+            cached[channel_number] = true;
+            continue;
+        }
+        lookups.emplace_back(channel_number);
+        auto abort = make_shared<atomic<bool>>(false);
+        sections_fan_out.add([&client, channel, abort]() {
+            return client.abortable(abort)->channel_sections(channel->id(), 1);
+        }, abort);
+    }
+    sections_fan_out.run(
+            [&playlist_ids, &lookups, &channels, featured_playlists](size_t index,
+                    Client::ChannelSectionList &sections) {
+                size_t channel_number = lookups[index];
+                playlist_ids[channel_number] =
+                        FeaturedPlaylistCache::featured_playlist(sections);
+                if (featured_playlists) {
+                    featured_playlists->put(channels[channel_number]->id(),
+                            playlist_ids[channel_number]);
+                }
+            },
+            [&lookups, &channels, &partial](size_t index, exception_ptr error) {
+                partial.skip(channels[lookups[index]]->id(), error);
+            });
+
+    // Then fetch the contents of those playlists
+    vector<size_t> channel_numbers;
+    FanOut<Client::PlaylistItemList> items_fan_out;
+    for (size_t channel_number = 0; channel_number < channels.size(); ++channel_number) {
+        const string &playlist_id = playlist_ids[channel_number];
+        if (playlist_id.empty()) {
+            if (DEBUG_MODE) {
+                cerr << "    empty playlist: " << channels[channel_number]->id()
+                        << endl;
+            }
+            continue;
+        }
+
+        channel_numbers.emplace_back(channel_number);
+        auto abort = make_shared<atomic<bool>>(false);
+        items_fan_out.add([&client, playlist_id, section_size, abort]() {
+            return client.abortable(abort)->playlist_items(playlist_id, section_size);
+        }, abort);
+    }
+
+    vector<Client::PlaylistItemList> items(channel_numbers.size());
+    vector<bool> fetched(channel_numbers.size(), false);
+    items_fan_out.run(
+            [&items, &fetched](size_t index, Client::PlaylistItemList &result) {
+                items[index] = result;
+                fetched[index] = true;
+            },
+            [&channels, &channel_numbers, &cached, featured_playlists, &partial](
+                    size_t index, exception_ptr error) {
+                // Only forget the playlist we remembered once YouTube says
+                // it has gone away; a slow or failing moment says nothing
+                // about it
+                size_t channel_number = channel_numbers[index];
+                if (featured_playlists && cached[channel_number]
+                        && NotFound::raised_by(error)) {
+                    featured_playlists->invalidate(channels[channel_number]->id());
+                }
+                partial.skip(channels[channel_number]->id(), error);
+            });
+
+    // Keep the channels in the order YouTube gave them to us, and only show
+    // a video under the first channel that featured it
+    for (size_t index = 0; index < channel_numbers.size(); ++index) {
+        if (!fetched[index]) {
+            continue;
+        }
+
+        Client::PlaylistItemList unique;
+        for (const PlaylistItem::Ptr &item : items[index]) {
+            if (filter.first(item->video_id())) {
+                unique.emplace_back(item);
+            }
+        }
+        if (!unique.empty()) {
+            snapshot.sections.emplace_back(
+                    CategorySnapshot::Section { channels.at(channel_numbers[index]), unique });
+        }
+    }
+}
+
+/**
+ * A surface made only of failures is no use to anyone.
+ */
+static void check_complete(CategorySnapshot &snapshot,
+        const DuplicateFilter &filter, PartialReply &partial) {
+    if (DEBUG_MODE) {
+        cerr << "  duplicates: " << filter.suppressed() << endl;
+    }
+
+    snapshot.skipped = partial.skipped();
+    if (snapshot.chart.empty() && snapshot.sections.empty()
+            && !snapshot.skipped.empty()) {
+        throw domain_error("No channel of " + snapshot.category_id
+                + " could be fetched");
+    }
+}
+
+}
+
+CategorySnapshot::SCPtr CategorySnapshot::fetch(Client &client,
+        const string &category_id,
+        FeaturedPlaylistCache::Ptr featured_playlists,
+        const ResultBudget &budget) {
+    auto snapshot = make_shared<CategorySnapshot>();
+    snapshot->category_id = category_id;
+
+    PartialReply partial;
+    DuplicateFilter filter(ResultBudget::MAX_PAGE_SIZE);
+    fetch_sections(client, *snapshot, featured_playlists, budget, filter,
+            partial);
+    check_complete(*snapshot, filter, partial);
+
+    return snapshot;
+}
+
+CategorySnapshot::SCPtr CategorySnapshot::fetch_by_chart(Client &client,
+        const string &category_id, const string &country_code,
+        FeaturedPlaylistCache::Ptr featured_playlists,
+        const ResultBudget &budget) {
+    string video_category_id = video_category(category_id);
+    if (video_category_id.empty()) {
+        return fetch(client, category_id, featured_playlists, budget);
+    }
+
+    auto snapshot = make_shared<CategorySnapshot>();
+    snapshot->category_id = category_id;
+
+    if (DEBUG_MODE) {
+        cerr << "Fetching chart: " << category_id << " ("
+                << video_category_id << ")" << endl;
+    }
+
+    PartialReply partial;
+    DuplicateFilter filter(ResultBudget::MAX_PAGE_SIZE);
+    unsigned int wanted = budget.full_page_size();
+    try {
+        auto chart_future = client.chart_videos("mostPopular", country_code,
+                video_category_id, wanted);
+        for (const Video::Ptr &video : get_or_throw(chart_future,
+                client.deadline())) {
+            if (filter.first(video->id())) {
+                snapshot->chart.emplace_back(video);
+            }
+        }
+    } catch (...) {
+        partial.skip("chart", current_exception());
+    }
+
+    // Only go to the channels for what the chart couldn't fill
+    if (snapshot->chart.size() < wanted) {
+        ResultBudget rest(static_cast<int>(wanted - snapshot->chart.size()));
+        try {
+            fetch_sections(client, *snapshot, featured_playlists, rest,
+                    filter, partial);
+        } catch (...) {
+            if (snapshot->chart.empty()) {
+                throw;
+            }
+            partial.skip("channels", current_exception());
+        }
+    }
+    check_complete(*snapshot, filter, partial);
+
+    return snapshot;
+}
+
+string CategorySnapshot::video_category(const string &category_id) {
+    auto it = VIDEO_CATEGORIES.find(category_id);
+    if (it == VIDEO_CATEGORIES.end()) {
+        return string();
+    }
+    return it->second;
+}
+
+bool CategorySnapshot::same_content(const CategorySnapshot &other) const {
+    if (category_id != other.category_id
+            || chart.size() != other.chart.size()
+            || sections.size() != other.sections.size()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < chart.size(); ++i) {
+        if (chart[i]->id() != other.chart[i]->id()
+                || chart[i]->title() != other.chart[i]->title()
+                || chart[i]->picture() != other.chart[i]->picture()) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < sections.size(); ++i) {
+        const Section &a = sections[i];
+        const Section &b = other.sections[i];
+        if (a.channel->id() != b.channel->id()
+                || a.channel->title() != b.channel->title()
+                || a.items.size() != b.items.size()) {
+            return false;
+        }
+        for (size_t j = 0; j < a.items.size(); ++j) {
+            if (a.items[j]->id() != b.items[j]->id()
+                    || a.items[j]->title() != b.items[j]->title()
+                    || a.items[j]->picture() != b.items[j]->picture()) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
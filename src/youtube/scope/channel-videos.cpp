@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/circuit-breaker.h>
+#include <youtube/api/fan-out.h>
+#include <youtube/api/not-found.h>
+#include <youtube/api/quota-budget.h>
+#include <youtube/scope/channel-videos.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <memory>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace {
+static constexpr bool DEBUG_MODE = false;
+
+// How many recent uploads to pick the most viewed from
+static const unsigned int UPLOADS_PER_CHANNEL = 50;
+
+// The most ids videos.list accepts at once
+static const size_t VIDEOS_PER_LOOKUP = 50;
+
+// The most results search.list returns at once
+static const size_t MAX_SEARCH_RESULTS = 50;
+}
+
+vector<Client::VideoList> ChannelVideos::fetch(Client &client,
+        const vector<string> &channel_ids, Strategy strategy,
+        size_t per_channel, PartialReply::Ptr partial) {
+    vector<Client::VideoList> result(channel_ids.size());
+
+    vector<size_t> by_search;
+    if (strategy == Strategy::uploads) {
+        by_search = fetch_by_uploads(client, channel_ids, per_channel, result,
+                partial);
+
+        // A fallback costs 100 units a channel, which only a healthy budget
+        // can spare, and is pointless while search is failing anyway
+        if (!by_search.empty()
+                && (QuotaBudget::instance()->level() != QuotaBudget::Level::normal
+                        || CircuitBreaker::instance()->state("search")
+                                == CircuitBreaker::State::open)) {
+            if (DEBUG_MODE) {
+                cerr << "  not searching " << by_search.size()
+                        << " channels" << endl;
+            }
+            if (partial) {
+                for (size_t index : by_search) {
+                    partial->skip(channel_ids[index],
+                            "no quota to spare for a search");
+                }
+            }
+            by_search.clear();
+        }
+    } else {
+        for (size_t index = 0; index < channel_ids.size(); ++index) {
+            by_search.emplace_back(index);
+        }
+    }
+
+    if (!by_search.empty()) {
+        fetch_by_search(client, channel_ids, by_search, per_channel, result,
+                partial);
+    }
+    return result;
+}
+
+void ChannelVideos::fetch_by_search(Client &client,
+        const vector<string> &channel_ids, const vector<size_t> &indexes,
+        size_t per_channel, vector<Client::VideoList> &result,
+        PartialReply::Ptr partial) {
+    unsigned int max_results = min<size_t>(per_channel, MAX_SEARCH_RESULTS);
+
+    FanOut<Client::VideoList> fan_out;
+    for (size_t index : indexes) {
+        const string &channel_id = channel_ids[index];
+        auto abort = make_shared<atomic<bool>>(false);
+        fan_out.add([&client, channel_id, max_results, abort]() {
+            return client.abortable(abort)->channel_videos(channel_id, max_results);
+        }, abort);
+    }
+
+    FanOut<Client::VideoList>::ErrorHandler on_error;
+    if (partial) {
+        on_error = [&channel_ids, &indexes, partial](size_t index,
+                exception_ptr error) {
+            partial->skip(channel_ids[indexes[index]], error);
+        };
+    }
+    fan_out.run([&indexes, &result](size_t index, Client::VideoList &videos) {
+        result[indexes[index]] = videos;
+    }, on_error);
+}
+
+vector<size_t> ChannelVideos::fetch_by_uploads(Client &client,
+        const vector<string> &channel_ids, size_t per_channel,
+        vector<Client::VideoList> &result, PartialReply::Ptr partial) {
+    vector<size_t> failed;
+
+    // List the recent uploads of each channel
+    vector<size_t> listed;
+    FanOut<Client::PlaylistItemList> uploads_fan_out;
+    for (size_t index = 0; index < channel_ids.size(); ++index) {
+        string playlist = Client::derive_uploads_playlist(channel_ids[index]);
+        if (playlist.empty()) {
+            failed.emplace_back(index);
+            continue;
+        }
+        listed.emplace_back(index);
+        auto abort = make_shared<atomic<bool>>(false);
+        uploads_fan_out.add([&client, playlist, abort]() {
+            return client.abortable(abort)->playlist_items(playlist,
+                    UPLOADS_PER_CHANNEL);
+        }, abort);
+    }
+
+    // Only a channel without an uploads playlist is worth a search; any
+    // other failure would most likely fail the search too
+    vector<Client::PlaylistItemList> uploads(channel_ids.size());
+    vector<bool> usable(channel_ids.size(), false);
+    vector<exception_ptr> errors(channel_ids.size());
+    uploads_fan_out.run(
+            [&listed, &uploads, &usable](size_t index,
+                    Client::PlaylistItemList &items) {
+                uploads[listed[index]] = items;
+                usable[listed[index]] = true;
+            },
+            [&channel_ids, &listed, &failed, &errors](size_t index,
+                    exception_ptr error) {
+                if (DEBUG_MODE) {
+                    cerr << "  no uploads: " << channel_ids[listed[index]]
+                            << endl;
+                }
+                if (NotFound::raised_by(error)) {
+                    failed.emplace_back(listed[index]);
+                } else {
+                    errors[listed[index]] = error;
+                }
+            });
+
+    // Then look up the statistics of every video at once, remembering which
+    // channels each batch is for
+    vector<string> batches;
+    vector<vector<size_t>> batch_channels;
+    size_t in_batch = 0;
+    for (size_t index = 0; index < uploads.size(); ++index) {
+        for (const PlaylistItem::Ptr &item : uploads[index]) {
+            if (in_batch == 0) {
+                batches.emplace_back();
+                batch_channels.emplace_back();
+            } else {
+                batches.back() += ",";
+            }
+            batches.back() += item->video_id();
+            if (batch_channels.back().empty()
+                    || batch_channels.back().back() != index) {
+                batch_channels.back().emplace_back(index);
+            }
+            in_batch = (in_batch + 1) % VIDEOS_PER_LOOKUP;
+        }
+    }
+
+    map<string, Video::Ptr> videos;
+    FanOut<Client::VideoList> videos_fan_out;
+    for (const string &batch : batches) {
+        auto abort = make_shared<atomic<bool>>(false);
+        videos_fan_out.add([&client, batch, abort]() {
+            return client.abortable(abort)->videos(batch);
+        }, abort);
+    }
+    videos_fan_out.run([&videos](size_t, Client::VideoList &found) {
+        for (const Video::Ptr &video : found) {
+            videos[video->id()] = video;
+        }
+    }, [&batch_channels, &errors](size_t batch, exception_ptr error) {
+        for (size_t index : batch_channels[batch]) {
+            errors[index] = error;
+        }
+    });
+
+    for (size_t index = 0; index < channel_ids.size(); ++index) {
+        if (errors[index]) {
+            if (partial) {
+                partial->skip(channel_ids[index], errors[index]);
+            }
+            continue;
+        }
+        if (!usable[index]) {
+            continue;
+        }
+
+        Client::VideoList channel_videos;
+        for (const PlaylistItem::Ptr &item : uploads[index]) {
+            auto it = videos.find(item->video_id());
+            if (it != videos.end()) {
+                channel_videos.emplace_back(it->second);
+            }
+        }
+        if (channel_videos.empty() && !uploads[index].empty()) {
+            failed.emplace_back(index);
+            continue;
+        }
+
+        stable_sort(channel_videos.begin(), channel_videos.end(),
+                [](const Video::Ptr &a, const Video::Ptr &b) {
+                    long a_views = a->has_statistics() ? a->statistics().view_count : 0;
+                    long b_views = b->has_statistics() ? b->statistics().view_count : 0;
+                    return a_views > b_views;
+                });
+        if (channel_videos.size() > per_channel) {
+            channel_videos.resize(per_channel);
+        }
+        result[index] = channel_videos;
+    }
+
+    sort(failed.begin(), failed.end());
+    return failed;
+}
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/quota-budget.h>
+#include <youtube/scope/chart-cache.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace {
+// Stop refreshing regions nobody has looked at for a day
+static const chrono::hours MAX_IDLE(24);
+
+static const chrono::seconds REFRESH_TIMEOUT(30);
+}
+
+ChartCache::ChartCache(shared_ptr<unity::scopes::OnlineAccountClient> oa_client,
+        chrono::seconds interval, chrono::seconds jitter,
+        chrono::seconds max_age) :
+        oa_client_(oa_client), interval_(interval), jitter_(jitter),
+        max_age_(max_age), random_(random_device()()), online_(true) {
+}
+
+ChartCache::~ChartCache() {
+    stop();
+}
+
+void ChartCache::start() {
+    lock_guard<mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    worker_ = thread([this]() {run();});
+}
+
+void ChartCache::stop() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        if (client_) {
+            client_->cancel();
+        }
+    }
+    wakeup_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+string ChartCache::make_key(const Key &key) {
+    return key.chart + "|" + key.country_code + "|" + key.category_id + "|"
+            + to_string(key.max_results);
+}
+
+ChartCache::VideosPtr ChartCache::get(const Key &key) {
+    lock_guard<mutex> lock(mutex_);
+
+    auto it = slots_.find(make_key(key));
+    if (it == slots_.end()) {
+        ++stats_.misses;
+        return VideosPtr();
+    }
+
+    auto now = chrono::steady_clock::now();
+    it->second.last_used = now;
+
+    // Once the quota has run out, an old chart is better than none
+    if (now - it->second.fetched > max_age_
+            && QuotaBudget::instance()->level() != QuotaBudget::Level::exhausted) {
+        ++stats_.misses;
+        return VideosPtr();
+    }
+
+    ++stats_.hits;
+    return it->second.videos;
+}
+
+void ChartCache::put(const Key &key, const Client::VideoList &videos) {
+    auto now = chrono::steady_clock::now();
+
+    lock_guard<mutex> lock(mutex_);
+    Slot &slot = slots_[make_key(key)];
+    slot.key = key;
+    slot.videos = make_shared<const Client::VideoList>(videos);
+    slot.fetched = now;
+    slot.last_used = now;
+}
+
+void ChartCache::set_online(bool online) {
+    // Under the lock, so run() can't miss the change between checking and
+    // waiting
+    bool was_online;
+    {
+        lock_guard<mutex> lock(mutex_);
+        was_online = online_.exchange(online);
+    }
+    if (online && !was_online) {
+        // Catch up straight away after coming back online
+        wakeup_.notify_all();
+    }
+}
+
+ChartCache::Stats ChartCache::stats() {
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+void ChartCache::dump_stats(ostream &out) {
+    Stats stats = this->stats();
+    unsigned long lookups = stats.hits + stats.misses;
+
+    out << "Chart cache: hits " << stats.hits << "/" << lookups;
+    if (lookups > 0) {
+        out << " (" << (100 * stats.hits / lookups) << "%)";
+    }
+    out << ", refreshes " << stats.refreshes << ", failed refreshes "
+            << stats.failed_refreshes << endl;
+}
+
+chrono::steady_clock::duration ChartCache::next_interval() {
+    uniform_int_distribution<long> distribution(-jitter_.count(),
+            jitter_.count());
+    return interval_ + chrono::seconds(distribution(random_));
+}
+
+void ChartCache::run() {
+    unique_lock<mutex> lock(mutex_);
+    while (running_) {
+        bool was_online = online_;
+        wakeup_.wait_for(lock, next_interval(), [this, was_online]() {
+            return !running_ || (online_ && !was_online);
+        });
+
+        if (!running_) {
+            break;
+        }
+        if (!online_
+                || QuotaBudget::instance()->level() != QuotaBudget::Level::normal) {
+            continue;
+        }
+
+        lock.unlock();
+        refresh();
+        lock.lock();
+    }
+}
+
+void ChartCache::refresh() {
+    vector<Key> keys;
+    shared_ptr<Client> client = make_shared<Client>(oa_client_,
+            Scheduler::Priority::background);
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        client_ = client;
+
+        auto now = chrono::steady_clock::now();
+        for (auto it = slots_.begin(); it != slots_.end();) {
+            if (now - it->second.last_used > MAX_IDLE) {
+                it = slots_.erase(it);
+            } else {
+                keys.emplace_back(it->second.key);
+                ++it;
+            }
+        }
+    }
+
+    for (const Key &key : keys) {
+        if (!online_) {
+            break;
+        }
+
+        try {
+            auto future = client->chart_videos(key.chart, key.country_code,
+                    key.category_id, key.max_results);
+            if (future.wait_for(REFRESH_TIMEOUT) != future_status::ready) {
+                throw domain_error("Timed out");
+            }
+            Client::VideoList videos = future.get();
+
+            lock_guard<mutex> lock(mutex_);
+            ++stats_.refreshes;
+
+            // Keep serving the old chart rather than an empty one
+            auto it = slots_.find(make_key(key));
+            if (it != slots_.end() && !videos.empty()) {
+                it->second.videos = make_shared<const Client::VideoList>(
+                        move(videos));
+                it->second.fetched = chrono::steady_clock::now();
+            }
+        } catch (exception &e) {
+            cerr << "Chart refresh failed: " << e.what() << endl;
+            lock_guard<mutex> lock(mutex_);
+            ++stats_.failed_refreshes;
+        }
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    client_.reset();
+}
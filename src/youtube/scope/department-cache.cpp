@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/scope/department-cache.h>
+
+using namespace std;
+using namespace youtube::scope;
+
+DepartmentCache::DepartmentCache(chrono::seconds ttl) :
+        ttl_(ttl) {
+}
+
+string DepartmentCache::make_key(const string &locale,
+        const string &country_code, const string &account) {
+    return locale + "|" + country_code + "|" + account;
+}
+
+DepartmentCache::Entry::SCPtr DepartmentCache::get(const string &key) {
+    lock_guard<mutex> lock(mutex_);
+
+    auto it = slots_.find(key);
+    if (it == slots_.end()) {
+        return Entry::SCPtr();
+    }
+
+    if (chrono::steady_clock::now() >= it->second.expires) {
+        slots_.erase(it);
+        return Entry::SCPtr();
+    }
+
+    return it->second.entry;
+}
+
+void DepartmentCache::put(const string &key, const string &account,
+        Entry::SCPtr entry) {
+    lock_guard<mutex> lock(mutex_);
+
+    Slot &slot = slots_[key];
+    slot.entry = entry;
+    slot.account = account;
+    slot.expires = chrono::steady_clock::now() + ttl_;
+}
+
+void DepartmentCache::invalidate(const string &account) {
+    lock_guard<mutex> lock(mutex_);
+
+    for (auto it = slots_.begin(); it != slots_.end();) {
+        if (it->second.account == account) {
+            it = slots_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void DepartmentCache::clear() {
+    lock_guard<mutex> lock(mutex_);
+    slots_.clear();
+}
@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/quota-budget.h>
+#include <youtube/api/reactor.h>
+#include <youtube/scope/featured-playlist-cache.h>
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace {
+
+// Written in place of an empty playlist id, for channels without one
+static const string NO_PLAYLIST = "-";
+
+template<typename T>
+static T get_or_throw(future<T> &f) {
+    if (Reactor::await(f, std::chrono::seconds(10)) != future_status::ready) {
+        throw domain_error("HTTP request timeout");
+    }
+    return f.get();
+}
+
+}
+
+FeaturedPlaylistCache::FeaturedPlaylistCache(
+        shared_ptr<unity::scopes::OnlineAccountClient> oa_client,
+        const string &path, chrono::seconds ttl) :
+        oa_client_(oa_client), path_(path), ttl_(ttl) {
+}
+
+FeaturedPlaylistCache::~FeaturedPlaylistCache() {
+    stop();
+}
+
+void FeaturedPlaylistCache::load() {
+    if (path_.empty()) {
+        return;
+    }
+
+    ifstream in(path_);
+    string channel_id, playlist_id;
+    int64_t verified;
+
+    lock_guard<mutex> lock(mutex_);
+    while (in >> channel_id >> playlist_id >> verified) {
+        Entry &entry = entries_[channel_id];
+        entry.playlist_id = playlist_id == NO_PLAYLIST ? "" : playlist_id;
+        entry.verified = verified;
+    }
+}
+
+void FeaturedPlaylistCache::save() {
+    lock_guard<mutex> lock(mutex_);
+    if (path_.empty() || !dirty_) {
+        return;
+    }
+
+    string temporary_path = path_ + ".tmp";
+    {
+        ofstream out(temporary_path, ios::trunc);
+        for (const auto &it : entries_) {
+            const Entry &entry = it.second;
+            out << it.first << ' '
+                    << (entry.playlist_id.empty() ?
+                            NO_PLAYLIST : entry.playlist_id) << ' '
+                    << entry.verified << '\n';
+        }
+        if (!out) {
+            cerr << "Failed to write featured playlists: " << temporary_path
+                    << endl;
+            remove(temporary_path.c_str());
+            return;
+        }
+    }
+
+    if (rename(temporary_path.c_str(), path_.c_str()) != 0) {
+        cerr << "Failed to replace featured playlists: " << path_ << endl;
+        return;
+    }
+    dirty_ = false;
+}
+
+void FeaturedPlaylistCache::stop() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        stopped_ = true;
+        revalidations_.clear();
+        if (client_) {
+            client_->cancel();
+        }
+    }
+    wakeup_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+bool FeaturedPlaylistCache::get(const string &channel_id,
+        string &playlist_id) {
+    lock_guard<mutex> lock(mutex_);
+
+    auto it = entries_.find(channel_id);
+    if (it == entries_.end()) {
+        ++stats_.misses;
+        return false;
+    }
+
+    Entry &entry = it->second;
+    playlist_id = entry.playlist_id;
+
+    if (time(nullptr) - entry.verified < ttl_.count()) {
+        ++stats_.fresh;
+        return true;
+    }
+
+    ++stats_.stale;
+    if (!entry.revalidating && !stopped_
+            && QuotaBudget::instance()->level() == QuotaBudget::Level::normal) {
+        entry.revalidating = true;
+        revalidations_.emplace_back(channel_id);
+        if (!running_) {
+            running_ = true;
+            worker_ = thread([this]() {run();});
+        }
+        wakeup_.notify_one();
+    }
+    return true;
+}
+
+void FeaturedPlaylistCache::put(const string &channel_id,
+        const string &playlist_id) {
+    lock_guard<mutex> lock(mutex_);
+
+    Entry &entry = entries_[channel_id];
+    entry.playlist_id = playlist_id;
+    entry.verified = time(nullptr);
+    entry.revalidating = false;
+    dirty_ = true;
+}
+
+void FeaturedPlaylistCache::invalidate(const string &channel_id) {
+    lock_guard<mutex> lock(mutex_);
+    if (entries_.erase(channel_id) > 0) {
+        dirty_ = true;
+    }
+}
+
+string FeaturedPlaylistCache::featured_playlist(
+        const Client::ChannelSectionList &sections) {
+    for (const ChannelSection::Ptr &section : sections) {
+        if (!section->playlist_id().empty()) {
+            return section->playlist_id();
+        }
+    }
+    return string();
+}
+
+FeaturedPlaylistCache::Stats FeaturedPlaylistCache::stats() {
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+void FeaturedPlaylistCache::dump_stats(ostream &out) {
+    Stats stats = this->stats();
+    out << "Featured playlists: " << stats.fresh << " fresh, " << stats.stale
+            << " stale, " << stats.misses << " misses, "
+            << stats.revalidations << " revalidated, " << stats.changed
+            << " changed" << endl;
+}
+
+void FeaturedPlaylistCache::run() {
+    unique_lock<mutex> lock(mutex_);
+    while (!stopped_) {
+        wakeup_.wait(lock, [this]() {
+            return stopped_ || !revalidations_.empty();
+        });
+
+        while (!stopped_ && !revalidations_.empty()) {
+            string channel_id = revalidations_.front();
+            revalidations_.pop_front();
+
+            if (!client_) {
+                client_ = make_shared<Client>(oa_client_,
+                        Scheduler::Priority::background);
+            }
+            auto client = client_;
+
+            lock.unlock();
+            bool revalidated = false;
+            string playlist_id;
+            try {
+                auto sections_future = client->channel_sections(channel_id, 1);
+                playlist_id = featured_playlist(get_or_throw(sections_future));
+                revalidated = true;
+            } catch (exception &e) {
+                cerr << "Revalidating featured playlist of " << channel_id
+                        << " failed: " << e.what() << endl;
+            }
+            lock.lock();
+
+            auto it = entries_.find(channel_id);
+            if (it == entries_.end()) {
+                continue;
+            }
+            it->second.revalidating = false;
+            if (revalidated) {
+                ++stats_.revalidations;
+                if (it->second.playlist_id != playlist_id) {
+                    ++stats_.changed;
+                }
+                it->second.playlist_id = playlist_id;
+                it->second.verified = time(nullptr);
+                dirty_ = true;
+            }
+        }
+
+        client_.reset();
+    }
+}
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/quota-budget.h>
+#include <youtube/scope/home-refresher.h>
+
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace {
+// Stop refreshing surfaces nobody has looked at for a day
+static const chrono::hours MAX_IDLE(24);
+}
+
+HomeRefresher::HomeRefresher(
+        shared_ptr<unity::scopes::OnlineAccountClient> oa_client,
+        FeaturedPlaylistCache::Ptr featured_playlists,
+        chrono::seconds interval, chrono::seconds jitter,
+        chrono::seconds max_age) :
+        oa_client_(oa_client), featured_playlists_(featured_playlists), interval_(interval), jitter_(jitter),
+        max_age_(max_age), random_(random_device()()), online_(true) {
+}
+
+HomeRefresher::~HomeRefresher() {
+    stop();
+}
+
+void HomeRefresher::start() {
+    lock_guard<mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    worker_ = thread([this]() {run();});
+}
+
+void HomeRefresher::stop() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        if (client_) {
+            client_->cancel();
+        }
+    }
+    wakeup_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+string HomeRefresher::make_key(const string &locale,
+        const string &country_code, const string &category_id) {
+    return locale + "|" + country_code + "|" + category_id;
+}
+
+CategorySnapshot::SCPtr HomeRefresher::snapshot(const string &locale,
+        const string &country_code, const string &category_id) {
+    lock_guard<mutex> lock(mutex_);
+
+    auto it = slots_.find(make_key(locale, country_code, category_id));
+    if (it == slots_.end()) {
+        return CategorySnapshot::SCPtr();
+    }
+
+    auto now = chrono::steady_clock::now();
+    it->second.last_used = now;
+
+    // Once the quota has run out, an old surface is better than none
+    if (now - it->second.fetched > max_age_
+            && QuotaBudget::instance()->level() != QuotaBudget::Level::exhausted) {
+        return CategorySnapshot::SCPtr();
+    }
+    return it->second.snapshot;
+}
+
+void HomeRefresher::update(const string &locale, const string &country_code,
+        CategorySnapshot::SCPtr snapshot) {
+    if (!snapshot->skipped.empty()) {
+        return;
+    }
+
+    lock_guard<mutex> lock(mutex_);
+
+    Slot &slot = slots_[make_key(locale, country_code, snapshot->category_id)];
+    slot.last_used = chrono::steady_clock::now();
+    slot.fetched = slot.last_used;
+    if (!slot.snapshot || !slot.snapshot->same_content(*snapshot)) {
+        slot.snapshot = snapshot;
+    }
+}
+
+void HomeRefresher::set_online(bool online) {
+    // Under the lock, so run() can't miss the change between checking and
+    // waiting
+    bool was_online;
+    {
+        lock_guard<mutex> lock(mutex_);
+        was_online = online_.exchange(online);
+    }
+    if (online && !was_online) {
+        // Catch up straight away after coming back online
+        wakeup_.notify_all();
+    }
+}
+
+chrono::steady_clock::duration HomeRefresher::next_interval() {
+    uniform_int_distribution<long> distribution(-jitter_.count(),
+            jitter_.count());
+    return interval_ + chrono::seconds(distribution(random_));
+}
+
+void HomeRefresher::run() {
+    unique_lock<mutex> lock(mutex_);
+    while (running_) {
+        bool was_online = online_;
+        wakeup_.wait_for(lock, next_interval(), [this, was_online]() {
+            return !running_ || (online_ && !was_online);
+        });
+
+        if (!running_) {
+            break;
+        }
+        if (!online_
+                || QuotaBudget::instance()->level() != QuotaBudget::Level::normal) {
+            continue;
+        }
+
+        lock.unlock();
+        refresh();
+        lock.lock();
+    }
+}
+
+void HomeRefresher::refresh() {
+    vector<pair<string, string>> keys;
+    shared_ptr<Client> client = make_shared<Client>(oa_client_, Scheduler::Priority::background);
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        client_ = client;
+
+        auto now = chrono::steady_clock::now();
+        for (auto it = slots_.begin(); it != slots_.end();) {
+            if (now - it->second.last_used > MAX_IDLE) {
+                it = slots_.erase(it);
+            } else {
+                keys.emplace_back(it->first, it->second.snapshot->category_id);
+                ++it;
+            }
+        }
+    }
+
+    for (const auto &key : keys) {
+        if (!online_) {
+            break;
+        }
+
+        try {
+            auto snapshot = CategorySnapshot::fetch(*client, key.second,
+                    featured_playlists_);
+
+            // Don't swap a surface for one that lost channels to failures
+            lock_guard<mutex> lock(mutex_);
+            auto it = slots_.find(key.first);
+            if (it != slots_.end()
+                    && snapshot->skipped.size() <= it->second.snapshot->skipped.size()) {
+                it->second.fetched = chrono::steady_clock::now();
+                if (!it->second.snapshot->same_content(*snapshot)) {
+                    it->second.snapshot = snapshot;
+                }
+            }
+        } catch (exception &e) {
+            cerr << "Home refresh failed: " << e.what() << endl;
+        }
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    client_.reset();
+}
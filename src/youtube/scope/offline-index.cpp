@@ -0,0 +1,761 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/scope/offline-index.h>
+
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <set>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace youtube::scope;
+
+namespace {
+
+static const char MAGIC[8] = { 'Y', 'T', 'O', 'F', 'F', 'I', 'D', 'X' };
+
+// Version 1 also kept the items of the user's own playlists
+static const uint32_t VERSION = 2;
+
+static const size_t FIELD_COUNT = 8;
+
+// How much a match in each field counts
+static const uint32_t TITLE_WEIGHT = 3;
+static const uint32_t CHANNEL_WEIGHT = 2;
+static const uint32_t DESCRIPTION_WEIGHT = 1;
+
+// Only write a document we already have out again once in a while
+static const int64_t RESEEN_INTERVAL = 24 * 60 * 60;
+
+static const size_t MAX_DESCRIPTION = 500;
+
+static const size_t MAX_QUERY_TERMS = 32;
+
+static const uint32_t MAX_JOURNAL_STRING = 1 << 20;
+
+// How often the background thread writes the journal out
+static const chrono::seconds FLUSH_INTERVAL(5);
+
+static vector<string> fields(const OfflineIndex::Document &document) {
+    return {document.id, document.kind, document.uri, document.title,
+        document.channel, document.description, document.art, document.link};
+}
+
+static OfflineIndex::Document from_fields(const vector<string> &fields,
+        int64_t last_seen) {
+    OfflineIndex::Document document;
+    document.id = fields[0];
+    document.kind = fields[1];
+    document.uri = fields[2];
+    document.title = fields[3];
+    document.channel = fields[4];
+    document.description = fields[5];
+    document.art = fields[6];
+    document.link = fields[7];
+    document.last_seen = last_seen;
+    return document;
+}
+
+static bool same_content(const OfflineIndex::Document &a,
+        const OfflineIndex::Document &b) {
+    return fields(a) == fields(b);
+}
+
+static map<string, uint32_t> term_weights(
+        const OfflineIndex::Document &document) {
+    map<string, uint32_t> weights;
+    auto add = [&weights](const string &text, uint32_t weight) {
+        set<string> seen;
+        for (const string &term : OfflineIndex::tokenize(text)) {
+            if (seen.insert(term).second) {
+                weights[term] += weight;
+            }
+        }
+    };
+    add(document.title, TITLE_WEIGHT);
+    add(document.channel, CHANNEL_WEIGHT);
+    add(document.description, DESCRIPTION_WEIGHT);
+    return weights;
+}
+
+static bool term_matches(const string &term, const string &query_term,
+        bool prefix) {
+    if (prefix) {
+        return term.compare(0, query_term.size(), query_term) == 0;
+    }
+    return term == query_term;
+}
+
+static void write_string(ostream &out, const string &s) {
+    uint32_t length = s.size();
+    out.write(reinterpret_cast<const char *>(&length), sizeof(length));
+    out.write(s.data(), length);
+}
+
+static bool read_string(istream &in, string &s) {
+    uint32_t length;
+    if (!in.read(reinterpret_cast<char *>(&length), sizeof(length))
+            || length > MAX_JOURNAL_STRING) {
+        return false;
+    }
+    s.resize(length);
+    return length == 0 || in.read(&s[0], length);
+}
+
+}
+
+struct OfflineIndex::Header {
+    char magic[8];
+
+    uint32_t version;
+
+    uint32_t document_count;
+
+    uint32_t term_count;
+
+    uint32_t posting_count;
+
+    uint32_t strings_size;
+
+    uint32_t reserved;
+};
+
+struct OfflineIndex::DocumentRecord {
+    uint32_t offset[FIELD_COUNT];
+
+    uint32_t length[FIELD_COUNT];
+
+    int64_t last_seen;
+};
+
+struct OfflineIndex::TermRecord {
+    uint32_t offset;
+
+    uint32_t length;
+
+    uint32_t first_posting;
+
+    uint32_t posting_count;
+};
+
+struct OfflineIndex::PostingRecord {
+    uint32_t document;
+
+    uint32_t weight;
+};
+
+struct OfflineIndex::Match {
+    /* One bit per query term */
+    uint32_t terms = 0;
+
+    uint32_t score = 0;
+};
+
+OfflineIndex::OfflineIndex(const string &directory, size_t max_documents,
+        size_t max_journal) :
+        directory_(directory), index_path_(directory + "/offline-index"),
+        journal_path_(directory + "/offline-index.journal"),
+        max_documents_(max_documents), max_journal_(max_journal) {
+}
+
+OfflineIndex::~OfflineIndex() {
+    stop();
+
+    lock_guard<mutex> lock(mutex_);
+    journal_.flush();
+    unmap_file();
+}
+
+vector<string> OfflineIndex::tokenize(const string &text) {
+    vector<string> terms;
+    string term;
+    for (char c : text) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (u >= 0x80 || isalnum(u)) {
+            // Leave multi-byte characters alone
+            term += u < 0x80 ? static_cast<char>(tolower(u)) : c;
+        } else {
+            if (term.size() >= 2) {
+                terms.emplace_back(term);
+            }
+            term.clear();
+        }
+    }
+    if (term.size() >= 2) {
+        terms.emplace_back(term);
+    }
+    return terms;
+}
+
+void OfflineIndex::load() {
+    bool full;
+    {
+        lock_guard<mutex> lock(mutex_);
+
+        unmap_file();
+        bool current = map_file();
+
+        if (journal_.is_open()) {
+            journal_.close();
+        }
+        journal_documents_.clear();
+        if (current) {
+            replay_journal();
+            journal_.open(journal_path_, ios::binary | ios::app);
+        } else {
+            // The journal belongs with the old main file
+            remove(index_path_.c_str());
+            journal_.open(journal_path_, ios::binary | ios::trunc);
+        }
+
+        full = journal_documents_.size() >= max_journal_;
+    }
+
+    if (full) {
+        compact();
+    }
+}
+
+void OfflineIndex::start() {
+    lock_guard<mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    worker_ = thread([this]() {run();});
+}
+
+void OfflineIndex::stop() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    wakeup_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    flush();
+}
+
+void OfflineIndex::run() {
+    unique_lock<mutex> lock(mutex_);
+    while (running_) {
+        wakeup_.wait_for(lock, FLUSH_INTERVAL, [this]() {
+            return !running_ || compaction_wanted_;
+        });
+        if (!running_) {
+            break;
+        }
+
+        if (compaction_wanted_) {
+            lock.unlock();
+            compact();
+            lock.lock();
+        } else if (dirty_) {
+            journal_.flush();
+            dirty_ = false;
+        }
+    }
+}
+
+void OfflineIndex::add(const Document &document) {
+    add(vector<Document> { document });
+}
+
+void OfflineIndex::add(vector<Document> documents) {
+    int64_t now = time(nullptr);
+    for (Document &document : documents) {
+        if (document.last_seen == 0) {
+            document.last_seen = now;
+        }
+        if (document.description.size() > MAX_DESCRIPTION) {
+            // Cut on a character boundary
+            size_t length = MAX_DESCRIPTION;
+            while (length > 0 && (document.description[length] & 0xC0) == 0x80) {
+                --length;
+            }
+            document.description.resize(length);
+        }
+    }
+
+    unique_lock<mutex> lock(mutex_);
+
+    for (Document &document : documents) {
+        if (document.id.empty()) {
+            continue;
+        }
+
+        auto it = journal_documents_.find(document.id);
+        if (it != journal_documents_.end()) {
+            if (same_content(it->second, document)
+                    && document.last_seen - it->second.last_seen < RESEEN_INTERVAL) {
+                continue;
+            }
+        } else if (const DocumentRecord *record = find_mapped(document.id)) {
+            if (same_content(mapped_document(*record), document)
+                    && document.last_seen - record->last_seen < RESEEN_INTERVAL) {
+                continue;
+            }
+        }
+
+        append_to_journal(document);
+        string id = document.id;
+        journal_documents_[id] = move(document);
+        dirty_ = true;
+    }
+
+    if (journal_documents_.size() < max_journal_) {
+        return;
+    }
+    if (running_) {
+        compaction_wanted_ = true;
+        lock.unlock();
+        wakeup_.notify_all();
+    } else {
+        // Nobody else will do it
+        lock.unlock();
+        compact();
+    }
+}
+
+void OfflineIndex::flush() {
+    lock_guard<mutex> lock(mutex_);
+    journal_.flush();
+    dirty_ = false;
+}
+
+void OfflineIndex::compact() {
+    lock_guard<mutex> compacting(compact_mutex_);
+
+    vector<Document> documents;
+    map<string, Document> merged;
+    {
+        lock_guard<mutex> lock(mutex_);
+        compaction_wanted_ = false;
+        if (journal_documents_.empty()) {
+            return;
+        }
+        journal_.flush();
+        dirty_ = false;
+
+        if (header_) {
+            for (uint32_t i = 0; i < header_->document_count; ++i) {
+                Document document = mapped_document(documents_[i]);
+                if (!journal_documents_.count(document.id)) {
+                    documents.emplace_back(document);
+                }
+            }
+        }
+        for (const auto &entry : journal_documents_) {
+            documents.emplace_back(entry.second);
+        }
+        merged = journal_documents_;
+    }
+
+    string temporary_path = index_path_ + ".tmp";
+    if (!write_file(move(documents), temporary_path)) {
+        cerr << "Failed to write offline index: " << temporary_path << endl;
+        remove(temporary_path.c_str());
+        return;
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    unmap_file();
+    if (rename(temporary_path.c_str(), index_path_.c_str()) != 0) {
+        cerr << "Failed to replace offline index: " << index_path_ << endl;
+    }
+    map_file();
+
+    // Only what was added while we were writing is left for the journal
+    for (const auto &entry : merged) {
+        auto it = journal_documents_.find(entry.first);
+        if (it != journal_documents_.end()
+                && it->second.last_seen == entry.second.last_seen
+                && same_content(it->second, entry.second)) {
+            journal_documents_.erase(it);
+        }
+    }
+    journal_.close();
+    journal_.open(journal_path_, ios::binary | ios::trunc);
+    for (const auto &entry : journal_documents_) {
+        append_to_journal(entry.second);
+    }
+    journal_.flush();
+}
+
+size_t OfflineIndex::size() {
+    lock_guard<mutex> lock(mutex_);
+
+    size_t size = header_ ? header_->document_count : 0;
+    for (const auto &entry : journal_documents_) {
+        if (!find_mapped(entry.first)) {
+            ++size;
+        }
+    }
+    return size;
+}
+
+vector<OfflineIndex::Document> OfflineIndex::search(const string &query,
+        size_t max_results) {
+    vector<string> terms = tokenize(query);
+    if (terms.size() > MAX_QUERY_TERMS) {
+        terms.resize(MAX_QUERY_TERMS);
+    }
+    if (terms.empty() || max_results == 0) {
+        return vector<Document>();
+    }
+
+    struct Candidate {
+        Match match;
+
+        int64_t last_seen;
+
+        const DocumentRecord *record;
+
+        const Document *document;
+    };
+
+    lock_guard<mutex> lock(mutex_);
+
+    // Look the terms up in the main file. The last one is treated as a
+    // prefix, as it may still be being typed.
+    unordered_map<uint32_t, Match> mapped_matches;
+    if (header_) {
+        auto term_at = [this](uint32_t index) {
+            return mapped_string(terms_[index].offset, terms_[index].length);
+        };
+
+        for (size_t i = 0; i < terms.size(); ++i) {
+            bool prefix = i + 1 == terms.size();
+
+            uint32_t low = 0;
+            uint32_t high = header_->term_count;
+            while (low < high) {
+                uint32_t middle = low + (high - low) / 2;
+                if (term_at(middle) < terms[i]) {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+
+            for (uint32_t t = low; t < header_->term_count
+                    && term_matches(term_at(t), terms[i], prefix); ++t) {
+                const TermRecord &term = terms_[t];
+                if (term.first_posting + term.posting_count
+                        > header_->posting_count) {
+                    continue;
+                }
+                for (uint32_t p = 0; p < term.posting_count; ++p) {
+                    const PostingRecord &posting = postings_[term.first_posting
+                            + p];
+                    if (posting.document >= header_->document_count) {
+                        continue;
+                    }
+                    Match &match = mapped_matches[posting.document];
+                    match.terms |= 1u << i;
+                    match.score += posting.weight;
+                }
+            }
+        }
+    }
+
+    vector<Candidate> candidates;
+    for (const auto &entry : mapped_matches) {
+        const DocumentRecord &record = documents_[entry.first];
+        // The journal has a newer copy of this one
+        if (journal_documents_.count(
+                mapped_string(record.offset[0], record.length[0]))) {
+            continue;
+        }
+        candidates.emplace_back(
+                Candidate { entry.second, record.last_seen, &record, nullptr });
+    }
+
+    // The journal is small, so just look through it
+    for (const auto &entry : journal_documents_) {
+        Match match;
+        for (const auto &weight : term_weights(entry.second)) {
+            for (size_t i = 0; i < terms.size(); ++i) {
+                if (term_matches(weight.first, terms[i], i + 1 == terms.size())) {
+                    match.terms |= 1u << i;
+                    match.score += weight.second;
+                }
+            }
+        }
+        if (match.terms != 0) {
+            candidates.emplace_back(
+                    Candidate { match, entry.second.last_seen, nullptr,
+                            &entry.second });
+        }
+    }
+
+    // Matching more of the terms beats a higher score, and recent wins ties
+    size_t count = min(max_results, candidates.size());
+    partial_sort(candidates.begin(), candidates.begin() + count,
+            candidates.end(), [](const Candidate &a, const Candidate &b) {
+                size_t a_terms = bitset<32>(a.match.terms).count();
+                size_t b_terms = bitset<32>(b.match.terms).count();
+                if (a_terms != b_terms) {
+                    return a_terms > b_terms;
+                }
+                if (a.match.score != b.match.score) {
+                    return a.match.score > b.match.score;
+                }
+                return a.last_seen > b.last_seen;
+            });
+
+    vector<Document> results;
+    for (size_t i = 0; i < count; ++i) {
+        const Candidate &candidate = candidates[i];
+        results.emplace_back(
+                candidate.document ?
+                        *candidate.document : mapped_document(*candidate.record));
+    }
+    return results;
+}
+
+bool OfflineIndex::map_file() {
+    int fd = open(index_path_.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return true;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0
+            || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        close(fd);
+        return true;
+    }
+
+    void *address = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        return true;
+    }
+    mapped_ = static_cast<const char *>(address);
+    mapped_size_ = st.st_size;
+
+    const Header *header = reinterpret_cast<const Header *>(mapped_);
+    uint64_t documents_offset = sizeof(Header);
+    uint64_t terms_offset = documents_offset
+            + uint64_t(header->document_count) * sizeof(DocumentRecord);
+    uint64_t postings_offset = terms_offset
+            + uint64_t(header->term_count) * sizeof(TermRecord);
+    uint64_t strings_offset = postings_offset
+            + uint64_t(header->posting_count) * sizeof(PostingRecord);
+
+    if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0
+            && header->version != VERSION) {
+        cerr << "Replacing offline index from version " << header->version
+                << ": " << index_path_ << endl;
+        unmap_file();
+        return false;
+    }
+
+    if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+            || strings_offset + header->strings_size != mapped_size_) {
+        cerr << "Ignoring unreadable offline index: " << index_path_ << endl;
+        unmap_file();
+        return true;
+    }
+
+    header_ = header;
+    documents_ = reinterpret_cast<const DocumentRecord *>(mapped_
+            + documents_offset);
+    terms_ = reinterpret_cast<const TermRecord *>(mapped_ + terms_offset);
+    postings_ = reinterpret_cast<const PostingRecord *>(mapped_
+            + postings_offset);
+    strings_ = mapped_ + strings_offset;
+    return true;
+}
+
+void OfflineIndex::unmap_file() {
+    if (mapped_) {
+        munmap(const_cast<char *>(mapped_), mapped_size_);
+    }
+    mapped_ = nullptr;
+    mapped_size_ = 0;
+    header_ = nullptr;
+    documents_ = nullptr;
+    terms_ = nullptr;
+    postings_ = nullptr;
+    strings_ = nullptr;
+}
+
+void OfflineIndex::replay_journal() {
+    ifstream in(journal_path_, ios::binary);
+    while (in) {
+        vector<string> values(FIELD_COUNT);
+        bool complete = true;
+        for (string &value : values) {
+            if (!read_string(in, value)) {
+                complete = false;
+                break;
+            }
+        }
+
+        int64_t last_seen;
+        if (!complete
+                || !in.read(reinterpret_cast<char *>(&last_seen),
+                        sizeof(last_seen))) {
+            // A record cut short by a crash, so stop here
+            break;
+        }
+
+        Document document = from_fields(values, last_seen);
+        journal_documents_[document.id] = document;
+    }
+}
+
+void OfflineIndex::append_to_journal(const Document &document) {
+    if (!journal_.is_open()) {
+        journal_.open(journal_path_, ios::binary | ios::app);
+    }
+
+    for (const string &value : fields(document)) {
+        write_string(journal_, value);
+    }
+    journal_.write(reinterpret_cast<const char *>(&document.last_seen),
+            sizeof(document.last_seen));
+}
+
+bool OfflineIndex::write_file(vector<Document> documents,
+        const string &path) const {
+    // Keep the most recently seen documents, then order them by id so they
+    // can be looked up with a binary search
+    sort(documents.begin(), documents.end(),
+            [](const Document &a, const Document &b) {
+                return a.last_seen > b.last_seen;
+            });
+    if (documents.size() > max_documents_) {
+        documents.resize(max_documents_);
+    }
+    sort(documents.begin(), documents.end(),
+            [](const Document &a, const Document &b) {
+                return a.id < b.id;
+            });
+
+    string strings;
+    auto intern = [&strings](const string &s, uint32_t &offset, uint32_t &length) {
+        offset = strings.size();
+        length = s.size();
+        strings += s;
+    };
+
+    vector<DocumentRecord> records(documents.size());
+    map<string, vector<PostingRecord>> postings;
+    for (uint32_t i = 0; i < documents.size(); ++i) {
+        vector<string> values = fields(documents[i]);
+        for (size_t field = 0; field < FIELD_COUNT; ++field) {
+            intern(values[field], records[i].offset[field],
+                    records[i].length[field]);
+        }
+        records[i].last_seen = documents[i].last_seen;
+
+        for (const auto &weight : term_weights(documents[i])) {
+            postings[weight.first].emplace_back(
+                    PostingRecord { i, weight.second });
+        }
+    }
+
+    vector<TermRecord> terms;
+    vector<PostingRecord> all_postings;
+    for (const auto &entry : postings) {
+        TermRecord term;
+        intern(entry.first, term.offset, term.length);
+        term.first_posting = all_postings.size();
+        term.posting_count = entry.second.size();
+        terms.emplace_back(term);
+        all_postings.insert(all_postings.end(), entry.second.begin(),
+                entry.second.end());
+    }
+
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.document_count = records.size();
+    header.term_count = terms.size();
+    header.posting_count = all_postings.size();
+    header.strings_size = strings.size();
+    header.reserved = 0;
+
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(records.data()),
+            records.size() * sizeof(DocumentRecord));
+    out.write(reinterpret_cast<const char *>(terms.data()),
+            terms.size() * sizeof(TermRecord));
+    out.write(reinterpret_cast<const char *>(all_postings.data()),
+            all_postings.size() * sizeof(PostingRecord));
+    out.write(strings.data(), strings.size());
+    out.close();
+    return !out.fail();
+}
+
+const OfflineIndex::DocumentRecord * OfflineIndex::find_mapped(
+        const string &id) const {
+    if (!header_) {
+        return nullptr;
+    }
+
+    uint32_t low = 0;
+    uint32_t high = header_->document_count;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        const DocumentRecord &record = documents_[middle];
+        int comparison = mapped_string(record.offset[0], record.length[0]).compare(id);
+        if (comparison == 0) {
+            return &record;
+        } else if (comparison < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return nullptr;
+}
+
+OfflineIndex::Document OfflineIndex::mapped_document(
+        const DocumentRecord &record) const {
+    vector<string> values(FIELD_COUNT);
+    for (size_t field = 0; field < FIELD_COUNT; ++field) {
+        values[field] = mapped_string(record.offset[field], record.length[field]);
+    }
+    return from_fields(values, record.last_seen);
+}
+
+string OfflineIndex::mapped_string(uint32_t offset, uint32_t length) const {
+    if (uint64_t(offset) + length > header_->strings_size) {
+        return string();
+    }
+    return string(strings_ + offset, length);
+}
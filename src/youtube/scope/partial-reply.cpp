@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <youtube/scope/partial-reply.h>
+
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+using namespace youtube::scope;
+
+void PartialReply::skip(const string &branch, const string &reason) {
+    cerr << "Skipping " << branch << ": " << reason << endl;
+
+    lock_guard<mutex> lock(mutex_);
+    skipped_.emplace_back(branch);
+}
+
+void PartialReply::skip(const string &branch, exception_ptr error) {
+    try {
+        rethrow_exception(error);
+    } catch (exception &e) {
+        skip(branch, e.what());
+    } catch (...) {
+        skip(branch, "unknown error");
+    }
+}
+
+void PartialReply::merge(const vector<string> &skipped) {
+    lock_guard<mutex> lock(mutex_);
+    skipped_.insert(skipped_.end(), skipped.begin(), skipped.end());
+}
+
+vector<string> PartialReply::skipped() {
+    lock_guard<mutex> lock(mutex_);
+    return skipped_;
+}
+
+bool PartialReply::degraded() {
+    lock_guard<mutex> lock(mutex_);
+    return !skipped_.empty();
+}
+
+void PartialReply::finish() {
+    size_t skipped;
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (finished_) {
+            return;
+        }
+        finished_ = true;
+        skipped = skipped_.size();
+    }
+
+    lock_guard<mutex> lock(totals_mutex());
+    Stats &totals = totals_locked();
+    ++totals.replies;
+    if (skipped > 0) {
+        ++totals.degraded;
+        totals.skipped_branches += skipped;
+    }
+}
+
+PartialReply::Stats & PartialReply::totals_locked() {
+    static Stats totals;
+    return totals;
+}
+
+mutex & PartialReply::totals_mutex() {
+    static mutex totals_mutex;
+    return totals_mutex;
+}
+
+PartialReply::Stats PartialReply::totals() {
+    lock_guard<mutex> lock(totals_mutex());
+    return totals_locked();
+}
+
+void PartialReply::dump_stats(ostream &out) {
+    Stats stats = totals();
+
+    out << "Degraded replies: " << stats.degraded << "/" << stats.replies;
+    if (stats.replies > 0) {
+        out << " (" << (100 * stats.degraded / stats.replies) << "%)";
+    }
+    out << ", branches skipped " << stats.skipped_branches << endl;
+}
@@ -55,7 +55,7 @@ static T get_or_throw(future<T> &f) {
 Preview::Preview(const sc::Result &result, const sc::ActionMetadata &metadata,
                  std::shared_ptr<sc::OnlineAccountClient> oa_client) :
         sc::PreviewQueryBase(result, metadata),
-        client_(oa_client) {
+        client_(oa_client, Scheduler::Priority::interactive) {
 }
 
 void Preview::cancelled() {
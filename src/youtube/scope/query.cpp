@@ -21,23 +21,34 @@
 #include <boost/algorithm/string/trim.hpp>
 
 #include <youtube/api/channel.h>
+#include <youtube/api/fan-out.h>
 #include <youtube/api/subscription.h>
 #include <youtube/api/subscription-item.h>
 #include <youtube/api/playlist.h>
+#include <youtube/api/quota-budget.h>
+#include <youtube/api/reactor.h>
 
+#include <youtube/scope/channel-videos.h>
+#include <youtube/scope/department-path.h>
+#include <youtube/scope/duplicate-filter.h>
 #include <youtube/scope/localisation.h>
+#include <youtube/scope/offline-index.h>
+#include <youtube/scope/partial-reply.h>
 #include <youtube/scope/query.h>
 
 #include <unity/scopes/Annotation.h>
 #include <unity/scopes/CategorisedResult.h>
-#include <unity/scopes/CategoryRenderer.h>
 #include <unity/scopes/OnlineAccountClient.h>
 #include <unity/scopes/QueryBase.h>
 #include <unity/scopes/SearchReply.h>
 #include <unity/scopes/SearchMetadata.h>
 #include <unity/scopes/VariantBuilder.h>
 
+#include <atomic>
+#include <cstdlib>
+#include <memory>
 #include <sstream>
+#include <vector>
 #include <json/json.h>
 
 namespace sc = unity::scopes;
@@ -58,340 +69,112 @@ extern string format_fixed(long long number) {
 namespace {
 static constexpr bool DEBUG_MODE = false;
 
-const static string BROWSE_TEMPLATE =
-        R"(
-{
-  "schema-version": 1,
-  "template": {
-    "category-layout": "grid",
-    "card-size": "medium",
-    "overlay": false,
-    "collapsed-rows": 1
-  },
-  "components": {
-    "title": "title",
-    "art" : {
-      "field": "art",
-      "aspect-ratio": 1.5
-    },
-    "subtitle": "subtitle"
-  }
-}
-)";
-
-const static string SEARCH_TEMPLATE =
-        R"(
-{
-  "schema-version": 1,
-  "template": {
-    "category-layout": "grid",
-    "card-size": "medium",
-    "card-layout": "horizontal"
-  },
-  "components": {
-    "title": "title",
-    "art" : {
-      "field": "art",
-      "aspect-ratio": 1.7
-    },
-    "subtitle": "subtitle"
-  }
-}
-)";
-
-const static string SUBSCRIPTIONS_TEMPLATE =
-        R"(
-{
-  "schema-version": 1,
-  "template": {
-    "category-layout": "grid",
-    "card-size": "medium",
-    "card-layout": "horizontal",
-    "non-interactive": "true"
-  },
-  "components": {
-    "title": "title",
-    "art" : {
-      "field": "art",
-      "aspect-ratio": 1.7
-    },
-    "subtitle": "subtitle"
-  }
-}
-)";
-
-const static string POPULAR_TEMPLATE =
-        R"(
-{
-  "schema-version": 1,
-  "template": {
-    "category-layout": "grid",
-    "card-size": "large",
-    "overlay": true
-  },
-  "components": {
-    "title": "title",
-    "art" : {
-      "field": "art",
-      "aspect-ratio": 2.0
-    },
-    "subtitle": "subtitle"
-  }
-}
-)";
-
-const static string SEARCH_CATEGORY_LOGIN_NAG =
-        R"(
-{
-  "schema-version": 1,
-  "template": {
-    "category-layout": "vertical-journal",
-    "card-size": "large",
-    "card-background": "color:///#B31217"
-  },
-  "components": {
-    "title": "title"
-  }
-}
-)";
-
-const static string CHANNEL_INFO_TEMPLATE =
-        R"(
-{
-  "schema-version": 1,
-  "template": {
-    "category-layout": "grid",
-    "card-background": "color:///#FFFFFF",
-    "card-size": "medium",
-    "card-layout": "horizontal"
-  },
-  "components": {
-    "title": "title",
-    "art" : {
-       "field": "art"
-     },
-     "subtitle": "subtitle",
-     "attributes": {
-       "field": "attributes",
-       "max-count": 3
-    }
-  }
-}
-)";
-
-const static string EMPTY_VIDEOS_TIPS =
-        R"(
-{
-  "schema-version": 1,
-  "template": {
-    "category-layout": "grid",
-    "card-size": "large",
-    "card-layout": "horizontal"
-  },
-  "components": {
-    "title": "title"
-  }
-}
-)";
-
 const static string MUSIC_CATEGORY_ID = "10";
+
+// How many videos we show for each channel of a category
+static const unsigned int VIDEOS_PER_CHANNEL = 5;
+
+// playlists.list returns this many playlists unless asked otherwise
+static const unsigned int PLAYLISTS_PER_CHANNEL = 5;
 const static string MUSIC_AGGREGATOR_DEPT = "musicaggregator";
 
+// How long a query may take, unless configured otherwise
+static const chrono::milliseconds DEFAULT_QUERY_BUDGET(15000);
+
+// Subscriptions come 50 to a page, and the feed reads at most this many
+static const unsigned int MAX_SUBSCRIPTION_PAGES = 10;
+
+// Too little time for a request to come back, so don't start a stage
+static const chrono::milliseconds MIN_STAGE_BUDGET(1000);
+
 template<typename T>
-static T get_or_throw(future<T> &f) {
-    if (f.wait_for(std::chrono::seconds(10)) != future_status::ready) {
+static T get_or_throw(future<T> &f, const Deadline &deadline) {
+    Deadline wait = deadline.within(std::chrono::seconds(10));
+    if (Reactor::await(f, wait.remaining()) != future_status::ready) {
         throw domain_error("HTTP request timeout");
     }
     return f.get();
 }
 
-enum class DepartmentType {
-    guide_category, channel, playlist, aggregated, subscriptions, subscription
-};
-
-enum class SectionType {
-    none, videos, playlists, channels
-};
-
 /**
- * This class helps to encode/decode the department identity to/from string form
+ * The search metadata can ask for a deadline with a "deadline-ms" hint,
+ * otherwise it comes from YOUTUBE_SCOPE_QUERY_DEADLINE, in milliseconds.
  */
-struct DepartmentPath {
-    DepartmentType department_type;
-    string department;
-    SectionType section_type = SectionType::none;
-
-    DepartmentPath(DepartmentType department_type_, const string &department_,
-            SectionType section_type_ = SectionType::none) :
-            department_type(department_type_), department(department_), section_type(
-                    section_type_) {
-    }
-
-    DepartmentPath(const string &s) {
-        if (alg::starts_with(s, "guideCategory:")) {
-            department_type = DepartmentType::guide_category;
-        } else if (alg::starts_with(s,"guideCategory-videos:")) {
-            department_type = DepartmentType::guide_category;
-            section_type = SectionType::videos;
-        } else if (alg::starts_with(s, "guideCategory-playlists:")) {
-            department_type = DepartmentType::guide_category;
-            section_type = SectionType::playlists;
-        } else if (alg::starts_with(s, "guideCategory-channels:")) {
-            department_type = DepartmentType::guide_category;
-            section_type = SectionType::channels;
-        } else if (alg::starts_with(s, "channel:")) {
-            department_type = DepartmentType::channel;
-        } else if (alg::starts_with(s, "playlist:")) {
-            department_type = DepartmentType::playlist;
-        } else if (alg::starts_with(s, "aggregated:")) {
-            department_type = DepartmentType::aggregated;
-        } else if (alg::starts_with(s, "subscriptions:")) {
-            department_type = DepartmentType::subscriptions;
-        } else if (alg::starts_with(s, "subscription:")) {
-            department_type = DepartmentType::subscription;
-        }
-
-        department = s.substr(s.find(':') + 1);
+static chrono::milliseconds query_budget(const sc::SearchMetadata &metadata) {
+    if (metadata.contains_hint("deadline-ms")
+            && metadata["deadline-ms"].which() == sc::Variant::Int
+            && metadata["deadline-ms"].get_int() > 0) {
+        return chrono::milliseconds(metadata["deadline-ms"].get_int());
     }
 
-    string to_string() const {
-        ostringstream result;
-        switch (department_type) {
-        case DepartmentType::guide_category: {
-            switch (section_type) {
-            case SectionType::none:
-                result << "guideCategory:";
-                break;
-            case SectionType::videos:
-                result << "guideCategory-videos:";
-                break;
-            case SectionType::playlists:
-                result << "guideCategory-playlists:";
-                break;
-            case SectionType::channels:
-                result << "guideCategory-channels:";
-                break;
-            }
-            break;
-        }
-        case DepartmentType::playlist:
-            result << "playlist:";
-            break;
-        case DepartmentType::channel:
-            result << "channel:";
-            break;
-        case DepartmentType::aggregated:
-            result << "aggregated:";
-            break;
-        case DepartmentType::subscriptions:
-            result << "subscriptions:";
-            break;
-        case DepartmentType::subscription:
-            result << "subscription:";
-            break;
+    static const chrono::milliseconds configured = []() {
+        const char *budget = getenv("YOUTUBE_SCOPE_QUERY_DEADLINE");
+        if (budget && strtoul(budget, nullptr, 10) > 0) {
+            return chrono::milliseconds(strtoul(budget, nullptr, 10));
         }
+        return DEFAULT_QUERY_BUDGET;
+    }();
+    return configured;
+}
 
-        result << department;
-        return result.str();
-    }
+enum class BrowseStrategy {
+    /* The channels of the category, then each of their featured playlists */
+    channels,
+    /* The chart of the matching video category, in a single request */
+    chart
 };
 
-void push_resource(const sc::SearchReplyProxy &reply, const sc::Category::SCPtr &category,
-                   const Resource::Ptr &resource, map<string, string> &playlist) {
-    sc::CategorisedResult res(category);
-    res.set_title(resource->title());
-    res.set_art(resource->picture());
-    res["kind"] = resource->kind_str();
-
-    //We won't pass 'likes' playlist id as youtube automatically
-    //add the videos into likes playlist when user clicks 'thumb up'
-    if (playlist.size() > 0) {
-        res["fav_playlist"] = playlist[_("Favorites")];
-        res["watch_playlist"] = playlist[_("Watch Later")];
-    }
-
-    sc::CannedQuery new_query(SCOPE_INSTALL_NAME);
-
-    switch (resource->kind()) {
-    case Resource::Kind::channel: {
-        Channel::Ptr channel(static_pointer_cast<Channel>(resource));
-        DepartmentPath path { DepartmentType::channel, channel->id() };
-        new_query.set_department_id(path.to_string());
-        res.set_uri(new_query.to_uri());
-        res["subtitle"] = _("1 subscriber", "%d subscribers", channel->subscriber_count());
-        res["description"] = channel->description();
-        break;
-    }
-    case Resource::Kind::channelSection: {
-        break;
-    }
-    case Resource::Kind::guideCategory: {
-        GuideCategory::Ptr guide_category(
-                static_pointer_cast<GuideCategory>(resource));
-        DepartmentPath path { DepartmentType::guide_category,
-                guide_category->id() };
-        new_query.set_department_id(path.to_string());
-        res.set_uri(new_query.to_uri());
-        break;
-    }
-    case Resource::Kind::subscription: {
-        Subscription::Ptr subscription(
-                static_pointer_cast<Subscription>(resource));
-        DepartmentPath path { DepartmentType::subscriptions,
-                subscription->id() };
-        res["art"] = subscription->picture();
-        res.set_uri(new_query.to_uri());
-        break;
-    }
-    case Resource::Kind::subscriptionItem: {
-        SubscriptionItem::Ptr subs_item(
-                static_pointer_cast<SubscriptionItem>(resource));
-        res["link"] = subs_item->link();
-        res["description"] = subs_item->description();
-        res["subtitle"] = subs_item->title();
-        res.set_uri(subs_item->video_id());
-        break;
-    }
-    case Resource::Kind::playlist: {
-        Playlist::Ptr playlist(static_pointer_cast<Playlist>(resource));
-        DepartmentPath path { DepartmentType::playlist, playlist->id() };
-        new_query.set_department_id(path.to_string());
-        res.set_uri(new_query.to_uri());
-        res["subtitle"] = _("1 video", "%d videos", playlist->item_count());
-        res["description"] = playlist->description();
-        break;
-    }
-    case Resource::Kind::playlistItem: {
-        PlaylistItem::Ptr playlist_item(
-                static_pointer_cast<PlaylistItem>(resource));
-        res["link"] = playlist_item->link();
-        res["description"] = playlist_item->description();
-        res["subtitle"] = playlist_item->username();
-        res.set_uri(playlist_item->video_id());
-        break;
-    }
-    case Resource::Kind::video: {
-        Video::Ptr video(static_pointer_cast<Video>(resource));
-        res["link"] = video->link();
-        res["description"] = video->description();
-        res["subtitle"] = video->username();
-        res.set_uri(video->id());
-        // add a flag that will determine if this version of the youtube scope
-        // processes the department "aggregated:musicaggregator"
-        res["musicaggregation"]=true;
-        break;
-    }
-    default:
-      break;
-    }
-
-    if (!reply->push(res)) {
-        return;
+static BrowseStrategy browse_strategy(const sc::SearchMetadata &metadata) {
+    string strategy;
+    if (metadata.contains_hint("browse-strategy")
+            && metadata["browse-strategy"].which() == sc::Variant::String) {
+        strategy = metadata["browse-strategy"].get_string();
+    } else if (getenv("YOUTUBE_SCOPE_BROWSE_STRATEGY")) {
+        strategy = getenv("YOUTUBE_SCOPE_BROWSE_STRATEGY");
     }
+    return strategy == "chart" ? BrowseStrategy::chart : BrowseStrategy::channels;
 }
 
-void push_channel_info(const sc::SearchReplyProxy &reply,
-    const sc::Category::SCPtr &category, const Channel::Ptr &channel) {
+bool push_result(const sc::SearchReplyProxy &reply,
+        const sc::CategorisedResult &res,
+        const ResultCache::Recording::Ptr &recording) {
+    if (recording) {
+        recording->result(res);
+    }
+    return reply->push(res);
+}
+
+void register_departments(const sc::SearchReplyProxy &reply,
+        const sc::Department::SCPtr &departments,
+        const ResultCache::Recording::Ptr &recording) {
+    if (recording) {
+        recording->departments(departments);
+    }
+    reply->register_departments(departments);
+}
+
+template<typename T>
+bool push_resources(const sc::SearchReplyProxy &reply,
+        const sc::Category::SCPtr &category, const T &resources,
+        ResultEmitter &emitter, const ResultCache::Recording::Ptr &recording) {
+    return emitter.emit_all(category, resources,
+            [&reply, &recording](const sc::CategorisedResult &res) {
+                return push_result(reply, res, recording);
+            });
+}
+
+bool push_resource(const sc::SearchReplyProxy &reply,
+        const sc::Category::SCPtr &category, const Resource &resource,
+        ResultEmitter &emitter, const ResultCache::Recording::Ptr &recording) {
+    return emitter.emit(category, resource,
+            [&reply, &recording](const sc::CategorisedResult &res) {
+                return push_result(reply, res, recording);
+            });
+}
+
+bool push_channel_info(const sc::SearchReplyProxy &reply,
+    const sc::Category::SCPtr &category, const Channel::Ptr &channel,
+    const ResultCache::Recording::Ptr &recording) {
 
     sc::CategorisedResult res(category);
 
@@ -419,263 +202,521 @@ void push_channel_info(const sc::SearchReplyProxy &reply,
 
     res["kind"] = "user-info";
 
-    if (!reply->push(res)) {
-        return;
-}
+    return push_result(reply, res, recording);
 }
 
 void push_tips(const sc::CannedQuery &query,
                const std::string &tips,
-               const unity::scopes::SearchReplyProxy &reply) {
+               const unity::scopes::SearchReplyProxy &reply,
+               const RendererRegistry &renderers,
+               const ResultCache::Recording::Ptr &recording) {
     //Stay on surface and avoid user to enter card view if no videos are found
-    sc::CategoryRenderer rdr(EMPTY_VIDEOS_TIPS);
-    auto cat = reply->register_category("empty_tips", "", "", rdr);
+    auto cat = reply->register_category("empty_tips", "", "",
+            renderers.get(RendererRegistry::Template::empty_tips));
 
     sc::CategorisedResult res(cat);
     res.set_uri(query.to_uri());
     res.set_title(tips);
 
-    if (!reply->push(res)) {
+    if (!push_result(reply, res, recording)) {
         return;
     }
 }
 
+Client::VideoList fetch_category_videos(Client &client,
+        const string &department_id, PartialReply::Ptr partial,
+        const ResultBudget &budget) {
+    if (DEBUG_MODE) {
+        cerr << "Finding videos: " << department_id << endl;
+    }
+
+    auto channels_future = client.category_channels(department_id);
+    auto channels = get_or_throw(channels_future, client.deadline());
+    vector<string> channel_ids;
+    for (Channel::Ptr channel : channels) {
+        if (DEBUG_MODE) {
+            cerr << "  channel: " << channel->id() << " " << channel->title()
+                    << endl;
+        }
+        channel_ids.emplace_back(channel->id());
+    }
+
+    unsigned int videos_per_channel = budget.branch_page_size(VIDEOS_PER_CHANNEL);
+    if (videos_per_channel == 0) {
+        videos_per_channel = VIDEOS_PER_CHANNEL;
+    }
+    channel_ids.resize(budget.branches(channel_ids.size(), videos_per_channel));
+
+    // A search per channel would cost 100 quota units each
+    vector<Client::VideoList> per_channel = ChannelVideos::fetch(client,
+            channel_ids, ChannelVideos::Strategy::uploads, videos_per_channel,
+            partial);
+
+    size_t expected = 0;
+    for (auto &videos : per_channel) {
+        expected += videos.size();
+    }
+
+    // Collaborations and re-uploads show up on more than one channel
+    DuplicateFilter filter(expected);
+    Client::VideoList result;
+    for (auto &videos : per_channel) {
+        for (auto &video : videos) {
+            if (!filter.first(video->id())) {
+                continue;
+            }
+            if (DEBUG_MODE) {
+                cerr << "    video: " << video->id() << " " << video->title()
+                        << endl;
+            }
+            result.emplace_back(video);
+        }
+    }
+
+    if (DEBUG_MODE) {
+        cerr << "  duplicates: " << filter.suppressed() << endl;
+    }
+    return result;
+}
+
+Client::ChannelList fetch_category_channels(Client &client,
+        const string &department_id, const ResultBudget &budget) {
+    if (DEBUG_MODE) {
+        cerr << "Finding channels: " << department_id << endl;
+    }
+
+    auto channels_future = client.category_channels(department_id,
+            budget.page_size());
+    return get_or_throw(channels_future, client.deadline());
+}
+
+Client::PlaylistList fetch_category_playlists(Client &client,
+        const string &department_id, PartialReply::Ptr partial,
+        const ResultBudget &budget) {
+    if (DEBUG_MODE) {
+        cerr << "Finding playlists: " << department_id << endl;
+    }
+
+    auto channels_future = client.category_channels(department_id);
+    auto channels = get_or_throw(channels_future, client.deadline());
+
+    unsigned int playlists_per_channel = budget.branch_page_size(
+            PLAYLISTS_PER_CHANNEL);
+    channels.resize(budget.branches(channels.size(),
+            playlists_per_channel > 0 ? playlists_per_channel : PLAYLISTS_PER_CHANNEL));
+
+    FanOut<Client::PlaylistList> fan_out;
+    for (Channel::Ptr channel : channels) {
+        if (DEBUG_MODE) {
+            cerr << "  channel: " << channel->id() << " " << channel->title()
+                << endl;
+        }
+        auto abort = make_shared<atomic<bool>>(false);
+        fan_out.add([&client, channel, playlists_per_channel, abort]() {
+            return client.abortable(abort)->channel_playlists(channel->id(),
+                    playlists_per_channel);
+        }, abort);
+    }
+
+    vector<Client::PlaylistList> per_channel(channels.size());
+    fan_out.run([&per_channel](size_t index, Client::PlaylistList &playlists) {
+        per_channel[index] = playlists;
+    }, [&channels, partial](size_t index, exception_ptr error) {
+        partial->skip(channels[index]->id(), error);
+    });
+
+    size_t expected = 0;
+    for (auto &playlists : per_channel) {
+        expected += playlists.size();
+    }
+
+    DuplicateFilter filter(expected);
+    Client::PlaylistList result;
+    for (auto &playlists : per_channel) {
+        for (auto &playlist : playlists) {
+            if (!filter.first(playlist->id())) {
+                continue;
+            }
+            if (DEBUG_MODE) {
+                cerr << "    playlist: " << playlist->id() << " "
+                        << playlist->title() << endl;
+            }
+            result.emplace_back(playlist);
+        }
+    }
+
+    if (DEBUG_MODE) {
+        cerr << "  duplicates: " << filter.suppressed() << endl;
+    }
+    return result;
+}
+
 }
 
 Query::Query(const sc::CannedQuery &query, const sc::SearchMetadata &metadata,
-             std::shared_ptr<sc::OnlineAccountClient> oa_client) :
+             std::shared_ptr<sc::OnlineAccountClient> oa_client,
+             DepartmentCache::Ptr department_cache,
+             HomeRefresher::Ptr home_refresher,
+             BrowseCache::Ptr browse_cache,
+             Reactor::Ptr reactor,
+             SearchCache::Ptr search_cache,
+             OfflineIndex::Ptr offline_index,
+             SubscriptionFeed::Ptr subscription_feed,
+             UploadsPlaylistCache::Ptr uploads_playlists,
+             FeaturedPlaylistCache::Ptr featured_playlists,
+             ChartCache::Ptr chart_cache,
+             ResultCache::Ptr result_cache,
+             RendererRegistry::SCPtr renderers) :
         sc::SearchQueryBase(query, metadata),
-        client_(oa_client) {
+        oa_client_(oa_client),
+        client_(oa_client),
+        department_cache_(department_cache),
+        home_refresher_(home_refresher),
+        browse_cache_(browse_cache),
+        reactor_(reactor),
+        search_cache_(search_cache),
+        offline_index_(offline_index),
+        subscription_feed_(subscription_feed),
+        uploads_playlists_(uploads_playlists),
+        featured_playlists_(featured_playlists),
+        chart_cache_(chart_cache),
+        result_cache_(result_cache),
+        renderers_(renderers),
+        emitter_(offline_index),
+        partial_(make_shared<PartialReply>()),
+        budget_(metadata.cardinality()) {
+}
+
+Query::~Query() {
+    // The runtime may let go of us before our task has finished with us
+    if (finished_.valid()) {
+        finished_.wait();
+    }
 }
 
 void Query::cancelled() {
+    abandon();
+}
+
+void Query::abandon() {
+    // Nobody will see anything else we fetch
+    stopped_ = true;
     client_.cancel();
 }
 
 void Query::add_login_nag(const sc::SearchReplyProxy &reply) {
-    sc::CategoryRenderer rdr(SEARCH_CATEGORY_LOGIN_NAG);
-    auto cat = reply->register_category("youtube_login_nag", "", "", rdr);
+    auto cat = reply->register_category("youtube_login_nag", "", "",
+            renderers_->get(RendererRegistry::Template::login_nag));
 
     sc::CategorisedResult res(cat);
     res.set_title(_("Log-in to YouTube"));
 
-    sc::OnlineAccountClient oa_client(SCOPE_INSTALL_NAME, "sharing", "google");
-    oa_client.register_account_login_item(res,
+    // The scope's own client is only missing when accounts are ignored.
+    // Connecting to online accounts goes over D-Bus, so keep it off the
+    // reactor.
+    auto oa_client = oa_client_;
+    if (!oa_client) {
+        oa_client = Reactor::offload<shared_ptr<sc::OnlineAccountClient>>([]() {
+            return make_shared<sc::OnlineAccountClient>(SCOPE_INSTALL_NAME,
+                    "sharing", "google");
+        });
+    }
+    oa_client->register_account_login_item(res,
                                           query(),
                                           sc::OnlineAccountClient::InvalidateResults,
                                           sc::OnlineAccountClient::DoNothing);
 
-    reply->push(res);
+    if (!push_result(reply, res, recording_)) {
+        abandon();
+    }
 }
 
 void Query::guide_category(const sc::SearchReplyProxy &reply,
         const string &department_id) {
-    auto popular = reply->register_category("youtube-popular", "", "",
-            sc::CategoryRenderer(POPULAR_TEMPLATE));
-
-    bool first = true;
-    if (DEBUG_MODE) {
-        cerr << "Finding channels: " << department_id << endl;
+    if (!start_stage("guide category")) {
+        return;
     }
 
-    auto channels_future = client_.category_channels(department_id);
-    auto channels = get_or_throw(channels_future);
-    deque<future<Client::ChannelSectionList>> channel_section_futures;
-    for (Channel::Ptr channel : channels) {
-        channel_section_futures.emplace_back(
-                client_.channel_sections(channel->id(), 1));
-        if (DEBUG_MODE) {
-            cerr << "  channel: " << channel->id() << " " << channel->title()
-                    << endl;
-        }
+    CategorySnapshot::SCPtr snapshot;
+    if (browse_strategy(search_metadata()) == BrowseStrategy::chart) {
+        snapshot = CategorySnapshot::fetch_by_chart(client_, department_id,
+                country_code(), featured_playlists_, budget_);
+    } else {
+        snapshot = CategorySnapshot::fetch(client_, department_id,
+                featured_playlists_, budget_);
     }
+    partial_->merge(snapshot->skipped);
+    push_category_snapshot(reply, *snapshot);
+}
 
-    int channel_number = 0;
-    for (future<Client::ChannelSectionList> &channel_section_future : channel_section_futures) {
-        Channel::Ptr channel = channels.at(channel_number++);
+void Query::home(const sc::SearchReplyProxy &reply,
+        const string &category_id) {
+    string locale = search_metadata().locale();
+    string country = country_code();
 
-        Client::ChannelSectionList sections = get_or_throw(
-                channel_section_future);
+    CategorySnapshot::SCPtr snapshot;
+    if (home_refresher_) {
+        snapshot = home_refresher_->snapshot(locale, country, category_id);
+    }
 
-        ChannelSection::Ptr section;
-        for (auto it : sections) {
-            if (!it->playlist_id().empty()) {
-                section = it;
-                break;
-            }
+    if (!snapshot) {
+        if (!start_stage("home")) {
+            return;
         }
-
-        if (!section) {
-            if (DEBUG_MODE) {
-                cerr << "    empty playlist" << endl;
-            }
-            continue;
+        snapshot = CategorySnapshot::fetch(client_, category_id,
+                featured_playlists_, budget_);
+        // A snapshot cut down to fit our budget would short change others
+        if (home_refresher_ && budget_.unlimited()) {
+            home_refresher_->update(locale, country, snapshot);
         }
+    }
 
-        if (DEBUG_MODE) {
-            cerr << "  section: " << section->id() << " " << section->playlist_id()
-                    << endl;
+    partial_->merge(snapshot->skipped);
+    push_category_snapshot(reply, *snapshot);
+}
+
+void Query::push_category_snapshot(const sc::SearchReplyProxy &reply,
+        const CategorySnapshot &snapshot) {
+    auto popular = reply->register_category("youtube-popular", "", "",
+            renderers_->get(RendererRegistry::Template::popular));
+
+    // The top of the chart leads, otherwise the first channel's first video
+    bool first = snapshot.chart.empty();
+    if (!first) {
+        auto video = snapshot.chart.cbegin();
+        if (!push_resource(reply, popular, **video, emitter_, recording_)) {
+            abandon();
+            return;
         }
 
-        auto playlist_future = client_.playlist_items(section->playlist_id());
-        Client::PlaylistItemList items = get_or_throw(playlist_future);
+        auto cat = reply->register_category("youtube-chart", _("Most popular"),
+                "", renderers_->get(RendererRegistry::Template::browse));
+        for (++video; video != snapshot.chart.cend(); ++video) {
+            if (!push_resource(reply, cat, **video, emitter_, recording_)) {
+                abandon();
+                return;
+            }
+        }
+    }
 
-        auto it = items.cbegin();
+    for (const CategorySnapshot::Section &section : snapshot.sections) {
+        auto it = section.items.cbegin();
 
         if (first) {
             first = false;
-            if (it != items.cend()) {
+            if (it != section.items.cend()) {
                 PlaylistItem::Ptr video(*it);
-                push_resource(reply, popular, video, my_playlist_);
+                if (!push_resource(reply, popular, *video, emitter_, recording_)) {
+                    abandon();
+                    return;
+                }
                 ++it;
             }
         }
 
-        auto cat = reply->register_category(channel->id(), channel->title(), "",
-                sc::CategoryRenderer(BROWSE_TEMPLATE));
-        for (; it != items.cend(); ++it) {
+        auto cat = reply->register_category(section.channel->id(),
+                section.channel->title(), "",
+                renderers_->get(RendererRegistry::Template::browse));
+        for (; it != section.items.cend(); ++it) {
             PlaylistItem::Ptr video(*it);
-            push_resource(reply, cat, video, my_playlist_);
+            if (!push_resource(reply, cat, *video, emitter_, recording_)) {
+                abandon();
+                return;
+            }
         }
     }
 }
 
 void Query::subscriptions(const sc::SearchReplyProxy &reply) {
+    if (!start_stage("subscriptions")) {
+        return;
+    }
+
     if (DEBUG_MODE) {
         cerr << "Finding subscriptions: " << endl;
     }
 
     auto cat = reply->register_category("subscriptions", "", "",
-            sc::CategoryRenderer(SUBSCRIPTIONS_TEMPLATE));
+            renderers_->get(RendererRegistry::Template::subscriptions));
 
-    auto subs_future = client_.subscription_channels();
-    Client::SubscriptionList items = get_or_throw(subs_future);
+    auto subs_future = client_.subscription_channels(budget_.full_page_size());
+    Client::SubscriptionList items = get_or_throw(subs_future, deadline_);
 
-    for (auto &item : items) {
-        push_resource(reply, cat, item, my_playlist_);
+    if (!push_resources(reply, cat, items, emitter_, recording_)) {
+        abandon();
+        return;
     }
 }
 
 void Query::subscription_videos(const sc::SearchReplyProxy &reply,
         const string &department_id) {
+    if (!start_stage("subscription uploads")) {
+        return;
+    }
+
     if (DEBUG_MODE) {
         cerr << "Finding subscription uploads: " << department_id << endl;
     }
 
     auto cat = reply->register_category("subscription", _("Uploads"), "",
-            sc::CategoryRenderer(BROWSE_TEMPLATE));
+            renderers_->get(RendererRegistry::Template::browse));
 
-    auto uploads_future = client_.subscription_channel_uploads(department_id);
-    auto uploads = get_or_throw(uploads_future);
+    // Known and derived playlists save a request before we can fetch the items
+    string uploads;
+    if (uploads_playlists_) {
+        uploads = uploads_playlists_->get(department_id);
+    }
+    bool verified = !uploads.empty();
+    if (uploads.empty()) {
+        auto uploads_future = client_.subscription_channel_uploads(department_id);
+        uploads = get_or_throw(uploads_future, deadline_);
+        verified = uploads != Client::derive_uploads_playlist(department_id);
+    }
+
+    Client::SubscriptionItemList items;
+    exception_ptr derived_failure;
+    try {
+        auto subscription_items_future = client_.subscription_items(uploads,
+                budget_.full_page_size());
+        items = get_or_throw(subscription_items_future, deadline_);
+    } catch (domain_error &e) {
+        if (verified) {
+            throw;
+        }
+        derived_failure = current_exception();
+    }
 
-    auto subscription_items_future = client_.subscription_items(uploads);
-    Client::SubscriptionItemList items = get_or_throw(subscription_items_future);
+    // The lookup waits for requests, so it can't be made from the handler
+    if (derived_failure) {
+        if (!start_stage("uploads lookup")) {
+            rethrow_exception(derived_failure);
+        }
+        auto uploads_future = client_.lookup_channel_uploads(department_id);
+        uploads = get_or_throw(uploads_future, deadline_);
+        auto subscription_items_future = client_.subscription_items(uploads,
+                budget_.full_page_size());
+        items = get_or_throw(subscription_items_future, deadline_);
+    }
+    if (uploads_playlists_) {
+        uploads_playlists_->put(department_id, uploads);
+    }
 
-    for (auto &subscription_item : items) {
-        push_resource(reply, cat, subscription_item, my_playlist_);
+    if (!push_resources(reply, cat, items, emitter_, recording_)) {
+        abandon();
+        return;
     }
 }
 
-void Query::guide_category_videos(const sc::SearchReplyProxy &reply,
-        const string &department_id) {
-    if (DEBUG_MODE) {
-        cerr << "Finding videos: " << department_id << endl;
+void Query::subscription_feed(const sc::SearchReplyProxy &reply) {
+    if (!start_stage("subscription feed")) {
+        return;
     }
 
-    auto cat = reply->register_category("youtube", _("Videos"), "",
-            sc::CategoryRenderer(SEARCH_TEMPLATE));
+    if (DEBUG_MODE) {
+        cerr << "Finding latest subscription uploads" << endl;
+    }
 
-    auto channels_future = client_.category_channels(department_id);
-    auto channels = get_or_throw(channels_future);
-    deque<future<Client::VideoList>> videos_futures;
-    for (Channel::Ptr channel : channels) {
-        if (DEBUG_MODE) {
-            cerr << "  channel: " << channel->id() << " " << channel->title()
-                    << endl;
+    auto cat = reply->register_category("subscription", _("Latest Uploads"),
+            "", renderers_->get(RendererRegistry::Template::browse));
+
+    Client::SubscriptionList subscriptions;
+    string page_token;
+    for (unsigned int page = 0; page < MAX_SUBSCRIPTION_PAGES; ++page) {
+        auto page_future = client_.subscription_page(page_token);
+        Client::SubscriptionPage found = get_or_throw(page_future, deadline_);
+        subscriptions.insert(subscriptions.end(), found.subscriptions.begin(),
+                found.subscriptions.end());
+        page_token = found.next_page_token;
+        if (page_token.empty()) {
+            break;
         }
-        videos_futures.emplace_back(client_.channel_videos(channel->id()));
     }
 
-    for (auto &it : videos_futures) {
-        Client::VideoList videos = it.get();
-        for (auto &video : videos) {
-            if (DEBUG_MODE) {
-                cerr << "    video: " << video->id() << " " << video->title()
-                        << endl;
-            }
-            push_resource(reply, cat, video, my_playlist_);
-        }
+    SubscriptionFeed::Ptr feed(subscription_feed_);
+    if (!feed) {
+        feed = make_shared<SubscriptionFeed>();
     }
 
-    if (channels.size() == 0) {
+    auto items = feed->latest(client_, subscriptions,
+            budget_.unlimited() ? 50 : budget_.wanted());
+    if (!push_resources(reply, cat, items, emitter_, recording_)) {
+        abandon();
+        return;
+    }
+}
+
+void Query::guide_category_videos(const sc::SearchReplyProxy &reply,
+        const string &department_id) {
+    auto cat = reply->register_category("youtube", _("Videos"), "",
+            renderers_->get(RendererRegistry::Template::search));
+
+    // The cache may call fetch again after we have gone
+    ResultBudget budget = budget_;
+    auto videos = browse<Client::VideoList>(BrowseCache::Type::category_videos,
+            department_id, [department_id, budget](Client &client,
+                    const PartialReply::Ptr &partial) {
+                return fetch_category_videos(client, department_id, partial,
+                        budget);
+            });
+    if (!push_resources(reply, cat, videos, emitter_, recording_)) {
+        abandon();
+        return;
+    }
+
+    if (videos.size() == 0 && !partial_->degraded()) {
         const sc::CannedQuery &query(sc::SearchQueryBase::query());
         const string &tips  = _("No video can be found in this channel");
-        push_tips(query, tips, reply);
-}
+        push_tips(query, tips, reply, *renderers_, recording_);
+    }
 }
 
 void Query::guide_category_channels(const sc::SearchReplyProxy &reply,
         const string &department_id) {
-    if (DEBUG_MODE) {
-        cerr << "Finding channels: " << department_id << endl;
-    }
-
     auto cat = reply->register_category("youtube", _("Channels"), "",
-            sc::CategoryRenderer(SEARCH_TEMPLATE));
-    auto channels_future = client_.category_channels(department_id);
-    auto channels = get_or_throw(channels_future);
-    for (Channel::Ptr channel : channels) {
-        push_resource(reply, cat, channel, my_playlist_);
-        if (DEBUG_MODE) {
-            cerr << "  channel: " << channel->id() << " " << channel->title()
-                    << endl;
-        }
+            renderers_->get(RendererRegistry::Template::search));
+
+    ResultBudget budget = budget_;
+    auto channels = browse<Client::ChannelList>(
+            BrowseCache::Type::category_channels, department_id,
+            [department_id, budget](Client &client, const PartialReply::Ptr &) {
+                return fetch_category_channels(client, department_id, budget);
+            });
+    if (!push_resources(reply, cat, channels, emitter_, recording_)) {
+        abandon();
+        return;
     }
 
     if (channels.size() == 0) {
         const sc::CannedQuery &query(sc::SearchQueryBase::query());
         const string &tips  = _("No channel can be found");
-        push_tips(query, tips, reply);
-}
+        push_tips(query, tips, reply, *renderers_, recording_);
+    }
 }
 
 void Query::guide_category_playlists(const sc::SearchReplyProxy &reply,
         const string &department_id) {
-    if (DEBUG_MODE) {
-        cerr << "Finding playlists: " << department_id << endl;
-    }
-
     auto cat = reply->register_category("youtube", _("Playlists"), "",
-            sc::CategoryRenderer(SEARCH_TEMPLATE));
-
-    auto channels_future = client_.category_channels(department_id);
-    auto channels = get_or_throw(channels_future);
-    deque<future<Client::PlaylistList>> playlists_futures;
-    for (Channel::Ptr channel : channels) {
-        if (DEBUG_MODE) {
-            cerr << "  channel: " << channel->id() << " " << channel->title()
-                << endl;
-        }
-        playlists_futures.emplace_back(
-                client_.channel_playlists(channel->id()));
-    }
-
-    for (auto &it : playlists_futures) {
-        Client::PlaylistList playlists = it.get();
-        for (auto &playlist : playlists) {
-            if (DEBUG_MODE) {
-                cerr << "    playlist: " << playlist->id() << " "
-                        << playlist->title() << endl;
-            }
-            push_resource(reply, cat, playlist, my_playlist_);
-        }
+            renderers_->get(RendererRegistry::Template::search));
+
+    // The cache may call fetch again after we have gone
+    ResultBudget budget = budget_;
+    auto playlists = browse<Client::PlaylistList>(
+            BrowseCache::Type::category_playlists, department_id,
+            [department_id, budget](Client &client,
+                    const PartialReply::Ptr &partial) {
+                return fetch_category_playlists(client, department_id, partial,
+                        budget);
+            });
+    if (!push_resources(reply, cat, playlists, emitter_, recording_)) {
+        abandon();
+        return;
     }
 
-    if (channels.size() == 0) {
+    if (playlists.size() == 0 && !partial_->degraded()) {
         const sc::CannedQuery &query(sc::SearchQueryBase::query());
         const string &tips  = _("No playlist can be found in this channel");
-        push_tips(query, tips, reply);
-}
+        push_tips(query, tips, reply, *renderers_, recording_);
+    }
 }
 
 void Query::playlist(const sc::SearchReplyProxy &reply,
@@ -685,58 +726,126 @@ void Query::playlist(const sc::SearchReplyProxy &reply,
     }
 
     auto cat = reply->register_category("youtube", _("Playlist contents"), "",
-            sc::CategoryRenderer(SEARCH_TEMPLATE));
-
-    auto playlist_future = client_.playlist_items(playlist_id);
-    Client::PlaylistItemList items = get_or_throw(playlist_future);
-
-    for (auto &playlist : items) {
-        push_resource(reply, cat, playlist, my_playlist_);
+            renderers_->get(RendererRegistry::Template::search));
+
+    ResultBudget budget = budget_;
+    auto items = browse<Client::PlaylistItemList>(BrowseCache::Type::playlist,
+            playlist_id, [playlist_id, budget](Client &client,
+                    const PartialReply::Ptr &) {
+                auto playlist_future = client.playlist_items(playlist_id,
+                        budget.page_size());
+                return get_or_throw(playlist_future, client.deadline());
+            });
+
+    if (!push_resources(reply, cat, items, emitter_, recording_)) {
+        abandon();
+        return;
     }
 }
 
 void Query::channel(const sc::SearchReplyProxy &reply,
         const string &channel_id) {
+    if (!start_stage("channel")) {
+        return;
+    }
+
     if (DEBUG_MODE) {
         cerr << "Channel: " << channel_id << endl;
     }
 
     auto cat = reply->register_category("youtube", _("Channel contents"), "",
-            sc::CategoryRenderer(SEARCH_TEMPLATE));
+            renderers_->get(RendererRegistry::Template::search));
 
     auto channel_future = client_.channels_statistics(channel_id);
-    Client::ChannelList channels = get_or_throw(channel_future);
+    Client::ChannelList channels = get_or_throw(channel_future, deadline_);
     if (channels.size() > 0) {
         sc::Category::SCPtr channel_cat = reply->register_category("channel", "", "",
-                sc::CategoryRenderer(CHANNEL_INFO_TEMPLATE));
+                renderers_->get(RendererRegistry::Template::channel_info));
 
-        push_channel_info(reply, channel_cat , channels[0]);
+        if (!push_channel_info(reply, channel_cat , channels[0], recording_)) {
+            abandon();
+            return;
+        }
     }
 
-    auto channels_future = client_.channel_videos(channel_id);
-    Client::VideoList videos = get_or_throw(channels_future);
-    for (auto &video : videos) {
-        push_resource(reply, cat, video, my_playlist_);
+    if (!start_stage("channel videos")) {
+        return;
     }
 
-    if (videos.size() == 0) {
+    // Most viewed of all time, rather than of the recent uploads
+    Client::VideoList videos = ChannelVideos::fetch(client_, { channel_id },
+            ChannelVideos::Strategy::search,
+            budget_.unlimited() ? VIDEOS_PER_CHANNEL : budget_.page_size(),
+            partial_).front();
+    if (!push_resources(reply, cat, videos, emitter_, recording_)) {
+        abandon();
+        return;
+    }
+
+    if (videos.size() == 0 && !partial_->degraded()) {
         const sc::CannedQuery &query(sc::SearchQueryBase::query());
         const string &tips  = _("No video can be found");
-        push_tips(query, tips, reply);
+        push_tips(query, tips, reply, *renderers_, recording_);
 }
 }
 
 void Query::popular_videos(const sc::SearchReplyProxy &reply, const std::string &category_id) {
-    auto resources_future = client_.chart_videos("mostPopular", country_code(), category_id);
-    auto resources = get_or_throw(resources_future);
+    ChartCache::Key key { "mostPopular", country_code(), category_id,
+            budget_.page_size() };
+
+    ChartCache::VideosPtr resources;
+    if (chart_cache_) {
+        resources = chart_cache_->get(key);
+    }
+    if (!resources) {
+        auto resources_future = client_.chart_videos(key.chart,
+                key.country_code, key.category_id, key.max_results);
+        resources = make_shared<const Client::VideoList>(
+                get_or_throw(resources_future, deadline_));
+        if (chart_cache_) {
+            chart_cache_->put(key, *resources);
+        }
+    }
 
     auto cat = reply->register_category("youtube", _("YouTube"), "",
-                                        sc::CategoryRenderer(SEARCH_TEMPLATE));
-    for (const Resource::Ptr& resource : resources) {
-        push_resource(reply, cat, resource, my_playlist_);
+                                        renderers_->get(RendererRegistry::Template::search));
+    if (!push_resources(reply, cat, *resources, emitter_, recording_)) {
+        abandon();
+        return;
     }
 }
 
+void Query::aggregated(const sc::SearchReplyProxy &reply,
+        const string &department) {
+    if (department == MUSIC_AGGREGATOR_DEPT) {
+        popular_videos(reply, MUSIC_CATEGORY_ID);
+    } else {
+        popular_videos(reply);
+    }
+}
+
+template<typename T>
+T Query::browse(BrowseCache::Type type, const string &key,
+        const BrowseCache::Fetch<T> &fetch) {
+    if (!browse_cache_) {
+        return fetch(client_, partial_);
+    }
+
+    // Playlists can be private, so never share entries between accounts
+    string account = client_.authenticated() ? to_string(client_.account_id()) : "";
+    return browse_cache_->get<T>(type,
+            account + "|" + budget_.key() + "|" + key, client_, partial_,
+            fetch);
+}
+
+bool Query::start_stage(const string &stage) {
+    if (deadline_.allows(MIN_STAGE_BUDGET)) {
+        return true;
+    }
+    partial_->skip(stage, "not enough time left");
+    return false;
+}
+
 string Query::country_code() const {
     string country_code = "US";
     auto metadata = search_metadata();
@@ -749,41 +858,19 @@ string Query::country_code() const {
     return country_code;
 }
 
-void Query::surfacing(const sc::SearchReplyProxy &reply) {
+DepartmentCache::Entry::SCPtr Query::build_departments(bool authenticated) {
     const sc::CannedQuery &query(sc::SearchQueryBase::query());
 
-    string raw_department_id = query.department_id();
-
-    bool authenticated = client_.authenticated();
-
-    bool include_login_nag = !authenticated;
-
-    if (!raw_department_id.empty()) {
-        DepartmentPath path(raw_department_id);
-        if (path.department_type == DepartmentType::aggregated) {
-            // Don't include the login nag when we are aggregated
-            include_login_nag = false;
-        }
-    }
-
-    if (include_login_nag) {
-        add_login_nag(reply);
-    }
+    auto entry = make_shared<DepartmentCache::Entry>();
 
     if (authenticated) {
         auto user_future = client_.auth_user_info();
-        auto channels = get_or_throw(user_future);
+        auto channels = get_or_throw(user_future, deadline_);
         if (channels.size() > 0) {
-            my_playlist_[_("Likes")] = channels[0]->likes_playlist();
-            my_playlist_[_("Favorites")] = channels[0]->favorites_playlist();
-            my_playlist_[_("Watch Later")] = channels[0]->watchLater_playlist();
-
-            if (raw_department_id.empty()) {
-                sc::Category::SCPtr channel_cat = reply->register_category("channel", "", "",
-                        sc::CategoryRenderer(CHANNEL_INFO_TEMPLATE));
-
-                push_channel_info(reply, channel_cat , channels[0]);
-            }
+            entry->user = channels[0];
+            entry->playlists[_("Likes")] = channels[0]->likes_playlist();
+            entry->playlists[_("Favorites")] = channels[0]->favorites_playlist();
+            entry->playlists[_("Watch Later")] = channels[0]->watchLater_playlist();
         }
     }
 
@@ -813,7 +900,9 @@ void Query::surfacing(const sc::SearchReplyProxy &reply) {
     // get youtube main categories
     auto departments_future = client_.guide_categories(country_code(),
             search_metadata().locale());
-    auto departments = get_or_throw(departments_future);
+    auto departments = get_or_throw(departments_future, deadline_);
+
+    entry->home_category = departments.at(0)->id();
 
     // if logged in, add My Subscriptions and My Playlist department to the list of top level departments
     // in position 1 (so Best of YouTube is position 0)
@@ -840,9 +929,18 @@ void Query::surfacing(const sc::SearchReplyProxy &reply) {
                         subscriptions_path.to_string(), query, _("My Subscriptions"));
                 all_depts->add_subdepartment(subscriptions_dept);
 
+                DepartmentPath feed_path { DepartmentType::subscription_feed,
+                        "all" };
+                subscriptions_dept->add_subdepartment(
+                        sc::Department::create(feed_path.to_string(), query,
+                                _("All Uploads")));
+
                 // we are logged in, so get user's subscription channels
+                if (!start_stage("subscription departments")) {
+                    continue;
+                }
                 auto subscriptions_future = client_.subscription_channels();
-                auto subscriptions = get_or_throw(subscriptions_future);
+                auto subscriptions = get_or_throw(subscriptions_future, deadline_);
                 for (Subscription::Ptr subscription : subscriptions) {
                     std::string department_id = "subscription:" + subscription->id();
                     sc::Department::SPtr dept_ = sc::Department::create(
@@ -861,8 +959,8 @@ void Query::surfacing(const sc::SearchReplyProxy &reply) {
                         playlist_path.to_string(), query, _("My Playlist"));
                 all_depts->add_subdepartment(playlist_dept);
 
-                for(map<string, string>::iterator iterator = my_playlist_.begin();
-                    iterator != my_playlist_.end(); iterator++) {
+                for(auto iterator = entry->playlists.cbegin();
+                    iterator != entry->playlists.cend(); iterator++) {
                     std::string department_id = "playlist:" + iterator->second;
                     sc::Department::SPtr dept_ = sc::Department::create(
                         department_id,
@@ -903,22 +1001,124 @@ void Query::surfacing(const sc::SearchReplyProxy &reply) {
         }
     }
 
+    entry->departments = all_depts;
+    return entry;
+}
+
+void Query::surfacing(const sc::SearchReplyProxy &reply) {
+    const sc::CannedQuery &query(sc::SearchQueryBase::query());
+
+    string raw_department_id = query.department_id();
+
+    // Aggregators ask far more often than users browse, and only want the
+    // chart, so they skip the account and the department tree altogether
+    if (!raw_department_id.empty()) {
+        DepartmentPath path(raw_department_id);
+        if (path.department_type == DepartmentType::aggregated) {
+            aggregated(reply, path.department);
+            return;
+        }
+    }
+
+    bool authenticated = client_.authenticated();
+    string account = authenticated ? to_string(client_.account_id()) : "";
+
+    // Going back to somewhere we have just been shows the same thing again
+    string result_key = ResultCache::make_key(query.to_uri(),
+            search_metadata().locale(), country_code(),
+            search_metadata().cardinality(), account,
+            browse_strategy(search_metadata()) == BrowseStrategy::chart ?
+                    "chart" : "channels");
+    if (result_cache_) {
+        auto recording = result_cache_->get(result_key);
+        if (recording) {
+            if (!recording->replay(reply)) {
+                abandon();
+            }
+            return;
+        }
+        recording_ = make_shared<ResultCache::Recording>();
+    }
+
+    departments(reply, authenticated, account);
+
+    // Only a complete reply is worth showing again
+    if (recording_ && !stopped_ && !partial_->degraded()) {
+        result_cache_->put(result_key, account, recording_);
+    }
+}
+
+void Query::departments(const sc::SearchReplyProxy &reply,
+        bool authenticated, const string &account) {
+    const sc::CannedQuery &query(sc::SearchQueryBase::query());
+
+    string raw_department_id = query.department_id();
+
+    bool include_login_nag = !authenticated;
+
+    if (include_login_nag) {
+        add_login_nag(reply);
+        if (stopped_) {
+            return;
+        }
+    }
+
+    // The department tree only changes with the locale, region and account,
+    // so we can skip all of the network requests needed to build it
+    string cache_key = DepartmentCache::make_key(search_metadata().locale(),
+            country_code(), account);
+
+    DepartmentCache::Entry::SCPtr cached;
+    if (department_cache_) {
+        cached = department_cache_->get(cache_key);
+    }
+    if (!cached) {
+        cached = build_departments(authenticated);
+        // Don't keep a tree that is missing the subscriptions
+        if (department_cache_ && !partial_->degraded()) {
+            department_cache_->put(cache_key, account, cached);
+        }
+    }
+
+    my_playlist_ = cached->playlists;
+    emitter_.set_playlists(my_playlist_);
+
+    if (cached->user && raw_department_id.empty()) {
+        sc::Category::SCPtr channel_cat = reply->register_category("channel", "", "",
+                renderers_->get(RendererRegistry::Template::channel_info));
+
+        if (!push_channel_info(reply, channel_cat , cached->user, recording_)) {
+            abandon();
+            return;
+        }
+    }
+
+    // The cached tree is shared, so re-root it before adding any dummy departments
+    sc::Department::SPtr all_depts = sc::Department::create("", query,
+            cached->departments->label());
+    all_depts->set_subdepartments(cached->departments->subdepartments());
+
     if (!raw_department_id.empty()) {
         DepartmentPath path(raw_department_id);
         switch (path.department_type) {
         case DepartmentType::subscriptions: {
-            reply->register_departments(all_depts);
+            register_departments(reply, all_depts, recording_);
             subscriptions(reply);
             break;
         }
         case DepartmentType::subscription: {
-            reply->register_departments(all_depts);
+            register_departments(reply, all_depts, recording_);
             subscription_videos(reply, path.department);
             break;
         }
+        case DepartmentType::subscription_feed: {
+            register_departments(reply, all_depts, recording_);
+            subscription_feed(reply);
+            break;
+        }
         case DepartmentType::guide_category: {
             // FIXME Working around the UI bug (have to register departments before results)
-            reply->register_departments(all_depts);
+            register_departments(reply, all_depts, recording_);
 
             switch (path.section_type) {
             case SectionType::none: {
@@ -963,7 +1163,7 @@ void Query::surfacing(const sc::SearchReplyProxy &reply) {
             all_depts->add_subdepartment(dummy);
             }
 
-            reply->register_departments(all_depts);
+            register_departments(reply, all_depts, recording_);
             playlist(reply, path.department);
             break;
         }
@@ -975,25 +1175,12 @@ void Query::surfacing(const sc::SearchReplyProxy &reply) {
                     raw_department_id, query, " ");
             all_depts->add_subdepartment(dummy);
 
-            reply->register_departments(all_depts);
+            register_departments(reply, all_depts, recording_);
             channel(reply, path.department);
             break;
         }
         case DepartmentType::aggregated: {
-            // If another scope has asked us to surface results
-
-            // Need to add a dummy department to pass the validation check
-            sc::Department::SPtr dummy = sc::Department::create(
-                    raw_department_id, query, " ");
-            all_depts->add_subdepartment(dummy);
-            reply->register_departments(all_depts);
-
-            if (path.department==MUSIC_AGGREGATOR_DEPT) {
-                popular_videos(reply, MUSIC_CATEGORY_ID);
-            } else {
-                popular_videos(reply);
-            }
-
+            // Already answered before building the department tree
             break;
         }
         }
@@ -1001,11 +1188,11 @@ void Query::surfacing(const sc::SearchReplyProxy &reply) {
         // This is the initial surfacing screen
 
         // FIXME Working around the UI bug (have to register departments before results)
-        reply->register_departments(all_depts);
+        register_departments(reply, all_depts, recording_);
 
-        guide_category(reply, departments.at(0)->id());
-    }
+        home(reply, cached->home_category);
     }
+}
 
 void Query::search(const sc::SearchReplyProxy &reply,
         const string &query_string) {
@@ -1028,26 +1215,156 @@ void Query::search(const sc::SearchReplyProxy &reply,
                 }
         }
     }
-    auto resources_future = client_.search(query_string, search_metadata().cardinality(), category_id);
-    auto resources = get_or_throw(resources_future);
+
+    SearchCache::Key key { query_string, category_id,
+            static_cast<unsigned int>(search_metadata().cardinality()),
+            country_code() };
+
+    SearchListResponse::Ptr resources;
+    if (search_cache_) {
+        resources = search_cache_->get(key);
+    }
+
+    DuplicateFilter pushed(key.cardinality);
+    if (!resources) {
+        // Show what we already have for the start of this query while the
+        // real search is running. The number of results isn't known yet, so
+        // they go above the real category without a title of their own.
+        if (search_cache_) {
+            auto provisional = search_cache_->provisional(key);
+            if (!provisional.empty()) {
+                auto cat = reply->register_category("youtube_provisional", "",
+                        "", renderers_->get(RendererRegistry::Template::search));
+                for (const Resource::Ptr& resource : provisional) {
+                    pushed.first(resource->id());
+                    if (!push_resource(reply, cat, *resource, emitter_, recording_)) {
+                        abandon();
+                        return;
+                    }
+                }
+            }
+        }
+
+        string session;
+        if (search_metadata().contains_hint("session-id")
+                && search_metadata()["session-id"].which()
+                        == sc::Variant::String) {
+            session = search_metadata()["session-id"].get_string();
+        }
+        SearchCache::InFlight in_flight(search_cache_, session, [this]() {
+            client_.cancel();
+        });
+
+        auto resources_future = client_.search(query_string, key.cardinality, category_id);
+        resources = get_or_throw(resources_future, deadline_);
+        in_flight.completed();
+
+        if (search_cache_) {
+            search_cache_->put(key, resources);
+        }
+    }
 
     auto cat = reply->register_category("youtube",
             _("1 result from YouTube", "%d results from YouTube",
                     resources->total_results()), "",
-            sc::CategoryRenderer(SEARCH_TEMPLATE));
+            renderers_->get(RendererRegistry::Template::search));
     for (const Resource::Ptr& resource : resources->items()) {
-        push_resource(reply, cat, resource, my_playlist_);
+        if (pushed.first(resource->id())) {
+            if (!push_resource(reply, cat, *resource, emitter_, recording_)) {
+                abandon();
+                return;
+            }
+        }
+    }
+}
+
+void Query::offline_search(const sc::SearchReplyProxy &reply,
+        const string &query_string) {
+    if (!offline_index_) {
+        return;
+    }
+
+    int cardinality = search_metadata().cardinality();
+    auto documents = offline_index_->search(query_string,
+            cardinality > 0 ? cardinality : 50);
+    if (documents.empty()) {
+        return;
+    }
+
+    auto cat = reply->register_category("youtube", _("YouTube"), "",
+            renderers_->get(RendererRegistry::Template::search));
+    for (const OfflineIndex::Document &document : documents) {
+        sc::CategorisedResult res(cat);
+        res.set_uri(document.uri);
+        res.set_title(document.title);
+        res.set_art(document.art);
+        res["kind"] = document.kind;
+        res["subtitle"] = document.channel;
+        res["description"] = document.description;
+        if (!document.link.empty()) {
+            res["link"] = document.link;
+        }
+        if (!reply->push(res)) {
+            return;
+        }
     }
 }
 
 void Query::run(sc::SearchReplyProxy const& reply) {
+    // Results are pushed from the reactor as responses come in, so none of
+    // the runtime's threads sit waiting for YouTube
+    auto done = make_shared<promise<void>>();
+    finished_ = done->get_future();
+
+    // The clock starts now, however long the task waits to be run
+    deadline_ = Deadline(query_budget(search_metadata()));
+    client_.set_deadline(deadline_);
+
+    Reactor::Task task = [this, reply, done]() {
+        try {
+            execute(reply);
+        } catch (exception &e) {
+            cerr << "ERROR: " << e.what() << endl;
+        }
+        // The index writes its journal out by itself every few seconds
+        emitter_.index();
+        // An abandoned reply isn't missing anything anyone would see
+        if (!stopped_) {
+            partial_->finish();
+        }
+        QuotaBudget::instance()->record_query(client_.quota_used());
+        if (DEBUG_MODE) {
+            cerr << "Quota units: " << client_.quota_used() << endl;
+        }
+        done->set_value();
+    };
+
+    if (!reactor_ || !reactor_->spawn(task)) {
+        task();
+    }
+}
+
+void Query::execute(sc::SearchReplyProxy const& reply) {
     try {
         const sc::SearchMetadata &meta(sc::SearchQueryBase::search_metadata());
-        if (meta.contains_hint("no-internet")
-                && meta["no-internet"].get_bool()) {
+        bool online = !(meta.contains_hint("no-internet")
+                && meta["no-internet"].get_bool());
+        if (home_refresher_) {
+            home_refresher_->set_online(online);
+        }
+        if (chart_cache_) {
+            chart_cache_->set_online(online);
+        }
+        if (!online) {
             sc::OperationInfo operation_info(sc::OperationInfo::NoInternet,
                     _("YouTube requires an internet connection"));
             reply->info(operation_info);
+
+            string query_string = alg::trim_copy(
+                    sc::SearchQueryBase::query().query_string());
+            if (!query_string.empty()) {
+                offline_search(reply, query_string);
+            }
             return;
         }
 
@@ -1059,6 +1376,12 @@ void Query::run(sc::SearchReplyProxy const& reply) {
         } else {
             search(reply, query_string);
         }
+
+        if (partial_->degraded() && !stopped_) {
+            sc::OperationInfo operation_info(sc::OperationInfo::ResultsIncomplete,
+                    _("Some results could not be loaded"));
+            reply->info(operation_info);
+        }
     } catch (domain_error &e) {
         cerr << "ERROR: " << e.what() << endl;
     }
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <youtube/scope/renderer-registry.h>
+
+#include <cstddef>
+#include <stdexcept>
+
+using namespace std;
+using namespace youtube::scope;
+
+namespace sc = unity::scopes;
+
+namespace {
+
+/*
+ * How deep a piece of JSON nests by its end, and the lowest it gets on the
+ * way, so mismatched brackets in a template fail the build
+ */
+struct Nesting {
+    int depth;
+
+    int lowest;
+};
+
+constexpr Nesting nesting(char c) {
+    return c == '{' || c == '[' ? Nesting { 1, 0 } :
+            c == '}' || c == ']' ? Nesting { -1, -1 } : Nesting { 0, 0 };
+}
+
+constexpr Nesting combine(Nesting first, Nesting second) {
+    return Nesting { first.depth + second.depth,
+            first.lowest < first.depth + second.lowest ?
+                    first.lowest : first.depth + second.lowest };
+}
+
+// Splits in halves rather than walking, to stay within the constexpr depth
+constexpr Nesting nesting(const char *text, size_t begin, size_t end) {
+    return end - begin == 1 ? nesting(text[begin]) :
+            combine(nesting(text, begin, begin + (end - begin) / 2),
+                    nesting(text, begin + (end - begin) / 2, end));
+}
+
+template<size_t N>
+constexpr bool balanced(const char (&text)[N]) {
+    return N > 1 && nesting(text, 0, N - 1).depth == 0
+            && nesting(text, 0, N - 1).lowest == 0;
+}
+
+static constexpr char BROWSE_TEMPLATE[] =
+        R"(
+{
+  "schema-version": 1,
+  "template": {
+    "category-layout": "grid",
+    "card-size": "medium",
+    "overlay": false,
+    "collapsed-rows": 1
+  },
+  "components": {
+    "title": "title",
+    "art" : {
+      "field": "art",
+      "aspect-ratio": 1.5
+    },
+    "subtitle": "subtitle"
+  }
+}
+)";
+
+static constexpr char SEARCH_TEMPLATE[] =
+        R"(
+{
+  "schema-version": 1,
+  "template": {
+    "category-layout": "grid",
+    "card-size": "medium",
+    "card-layout": "horizontal"
+  },
+  "components": {
+    "title": "title",
+    "art" : {
+      "field": "art",
+      "aspect-ratio": 1.7
+    },
+    "subtitle": "subtitle"
+  }
+}
+)";
+
+static constexpr char SUBSCRIPTIONS_TEMPLATE[] =
+        R"(
+{
+  "schema-version": 1,
+  "template": {
+    "category-layout": "grid",
+    "card-size": "medium",
+    "card-layout": "horizontal",
+    "non-interactive": "true"
+  },
+  "components": {
+    "title": "title",
+    "art" : {
+      "field": "art",
+      "aspect-ratio": 1.7
+    },
+    "subtitle": "subtitle"
+  }
+}
+)";
+
+static constexpr char POPULAR_TEMPLATE[] =
+        R"(
+{
+  "schema-version": 1,
+  "template": {
+    "category-layout": "grid",
+    "card-size": "large",
+    "overlay": true
+  },
+  "components": {
+    "title": "title",
+    "art" : {
+      "field": "art",
+      "aspect-ratio": 2.0
+    },
+    "subtitle": "subtitle"
+  }
+}
+)";
+
+static constexpr char SEARCH_CATEGORY_LOGIN_NAG[] =
+        R"(
+{
+  "schema-version": 1,
+  "template": {
+    "category-layout": "vertical-journal",
+    "card-size": "large",
+    "card-background": "color:///#B31217"
+  },
+  "components": {
+    "title": "title"
+  }
+}
+)";
+
+static constexpr char CHANNEL_INFO_TEMPLATE[] =
+        R"(
+{
+  "schema-version": 1,
+  "template": {
+    "category-layout": "grid",
+    "card-background": "color:///#FFFFFF",
+    "card-size": "medium",
+    "card-layout": "horizontal"
+  },
+  "components": {
+    "title": "title",
+    "art" : {
+       "field": "art"
+     },
+     "subtitle": "subtitle",
+     "attributes": {
+       "field": "attributes",
+       "max-count": 3
+    }
+  }
+}
+)";
+
+static constexpr char EMPTY_VIDEOS_TIPS[] =
+        R"(
+{
+  "schema-version": 1,
+  "template": {
+    "category-layout": "grid",
+    "card-size": "large",
+    "card-layout": "horizontal"
+  },
+  "components": {
+    "title": "title"
+  }
+}
+)";
+
+static_assert(balanced(BROWSE_TEMPLATE), "BROWSE_TEMPLATE isn't balanced");
+static_assert(balanced(SEARCH_TEMPLATE), "SEARCH_TEMPLATE isn't balanced");
+static_assert(balanced(SUBSCRIPTIONS_TEMPLATE), "SUBSCRIPTIONS_TEMPLATE isn't balanced");
+static_assert(balanced(POPULAR_TEMPLATE), "POPULAR_TEMPLATE isn't balanced");
+static_assert(balanced(SEARCH_CATEGORY_LOGIN_NAG), "SEARCH_CATEGORY_LOGIN_NAG isn't balanced");
+static_assert(balanced(CHANNEL_INFO_TEMPLATE), "CHANNEL_INFO_TEMPLATE isn't balanced");
+static_assert(balanced(EMPTY_VIDEOS_TIPS), "EMPTY_VIDEOS_TIPS isn't balanced");
+
+}
+
+RendererRegistry::RendererRegistry() {
+    renderers_.emplace(Template::browse, sc::CategoryRenderer(BROWSE_TEMPLATE));
+    renderers_.emplace(Template::search, sc::CategoryRenderer(SEARCH_TEMPLATE));
+    renderers_.emplace(Template::subscriptions,
+            sc::CategoryRenderer(SUBSCRIPTIONS_TEMPLATE));
+    renderers_.emplace(Template::popular, sc::CategoryRenderer(POPULAR_TEMPLATE));
+    renderers_.emplace(Template::login_nag,
+            sc::CategoryRenderer(SEARCH_CATEGORY_LOGIN_NAG));
+    renderers_.emplace(Template::channel_info,
+            sc::CategoryRenderer(CHANNEL_INFO_TEMPLATE));
+    renderers_.emplace(Template::empty_tips,
+            sc::CategoryRenderer(EMPTY_VIDEOS_TIPS));
+}
+
+const sc::CategoryRenderer & RendererRegistry::get(Template name) const {
+    return renderers_.at(name);
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <youtube/scope/result-cache.h>
+
+#include <unity/scopes/SearchReply.h>
+
+using namespace std;
+using namespace youtube::scope;
+
+namespace sc = unity::scopes;
+
+void ResultCache::Recording::departments(
+        const sc::Department::SCPtr &departments) {
+    steps_.emplace_back(Step { departments, sc::Category::SCPtr(),
+            sc::VariantMap() });
+}
+
+void ResultCache::Recording::result(const sc::CategorisedResult &result) {
+    steps_.emplace_back(Step { sc::Department::SCPtr(), result.category(),
+            result.serialize()["attrs"].get_dict() });
+}
+
+bool ResultCache::Recording::replay(const sc::SearchReplyProxy &reply) const {
+    map<string, sc::Category::SCPtr> categories;
+    for (const Step &step : steps_) {
+        if (step.departments) {
+            reply->register_departments(step.departments);
+            continue;
+        }
+
+        sc::Category::SCPtr &category = categories[step.category->id()];
+        if (!category) {
+            category = reply->register_category(step.category->id(),
+                    step.category->title(), step.category->icon(),
+                    step.category->renderer_template());
+        }
+
+        sc::CategorisedResult res(category);
+        for (const auto &attribute : step.attributes) {
+            res[attribute.first] = attribute.second;
+        }
+        if (!reply->push(res)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t ResultCache::Recording::size() const {
+    return steps_.size();
+}
+
+ResultCache::ResultCache(chrono::seconds ttl, size_t max_entries) :
+        ttl_(ttl), max_entries_(max_entries) {
+}
+
+string ResultCache::make_key(const string &uri, const string &locale,
+        const string &country_code, int cardinality, const string &account,
+        const string &variant) {
+    return locale + "|" + country_code + "|" + to_string(cardinality) + "|"
+            + account + "|" + variant + "|" + uri;
+}
+
+ResultCache::Recording::SCPtr ResultCache::get(const string &key) {
+    lock_guard<mutex> lock(mutex_);
+
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        ++stats_.misses;
+        return Recording::SCPtr();
+    }
+
+    if (chrono::steady_clock::now() - it->second.stored > ttl_) {
+        recently_used_.erase(it->second.position);
+        entries_.erase(it);
+        ++stats_.misses;
+        return Recording::SCPtr();
+    }
+
+    recently_used_.splice(recently_used_.begin(), recently_used_,
+            it->second.position);
+    ++stats_.hits;
+    return it->second.recording;
+}
+
+void ResultCache::put(const string &key, const string &account,
+        Recording::SCPtr recording) {
+    lock_guard<mutex> lock(mutex_);
+
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        recently_used_.erase(it->second.position);
+        entries_.erase(it);
+    }
+
+    recently_used_.emplace_front(key);
+    entries_[key] = Entry { recording, account, chrono::steady_clock::now(),
+            recently_used_.begin() };
+
+    while (entries_.size() > max_entries_) {
+        entries_.erase(recently_used_.back());
+        recently_used_.pop_back();
+    }
+}
+
+void ResultCache::invalidate(const string &account) {
+    lock_guard<mutex> lock(mutex_);
+
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->second.account == account) {
+            recently_used_.erase(it->second.position);
+            it = entries_.erase(it);
+            ++stats_.invalidated;
+        } else {
+            ++it;
+        }
+    }
+}
+
+ResultCache::Stats ResultCache::stats() {
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+void ResultCache::dump_stats(ostream &out) {
+    Stats stats = this->stats();
+    unsigned long lookups = stats.hits + stats.misses;
+
+    out << "Result cache: hits " << stats.hits << "/" << lookups;
+    if (lookups > 0) {
+        out << " (" << (100 * stats.hits / lookups) << "%)";
+    }
+    out << ", invalidated " << stats.invalidated << endl;
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <youtube/api/channel.h>
+#include <youtube/api/guide-category.h>
+#include <youtube/api/playlist.h>
+#include <youtube/api/playlist-item.h>
+#include <youtube/api/subscription-item.h>
+#include <youtube/api/video.h>
+#include <youtube/scope/department-path.h>
+#include <youtube/scope/localisation.h>
+#include <youtube/scope/result-emitter.h>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace sc = unity::scopes;
+
+ResultEmitter::ResultEmitter(OfflineIndex::Ptr offline_index) :
+        offline_index_(offline_index), query_(SCOPE_INSTALL_NAME),
+        scope_uri_(query_.to_uri()), music_aggregation_(true) {
+}
+
+void ResultEmitter::set_playlists(const map<string, string> &playlists) {
+    has_playlists_ = !playlists.empty();
+
+    auto favorites = playlists.find(_("Favorites"));
+    favorites_ = sc::Variant(
+            favorites != playlists.end() ? favorites->second : string());
+
+    auto watch_later = playlists.find(_("Watch Later"));
+    watch_later_ = sc::Variant(
+            watch_later != playlists.end() ? watch_later->second : string());
+}
+
+string ResultEmitter::department_uri(const string &department_id) {
+    query_.set_department_id(department_id);
+    return query_.to_uri();
+}
+
+sc::CategorisedResult ResultEmitter::result(const sc::Category::SCPtr &category,
+        const Resource &resource) {
+    string kind = resource.kind_str();
+
+    sc::CategorisedResult res(category);
+    res.set_title(resource.title());
+    res.set_art(resource.picture());
+    res["kind"] = kind;
+
+    //We won't pass 'likes' playlist id as youtube automatically
+    //add the videos into likes playlist when user clicks 'thumb up'
+    if (has_playlists_) {
+        res["fav_playlist"] = favorites_;
+        res["watch_playlist"] = watch_later_;
+    }
+
+    // Remember what we show, so it can be found again offline
+    OfflineIndex::Document document;
+
+    switch (resource.kind()) {
+    case Resource::Kind::channel: {
+        const Channel &channel = static_cast<const Channel &>(resource);
+        DepartmentPath path { DepartmentType::channel, channel.id() };
+        document.uri = department_uri(path.to_string());
+        res.set_uri(document.uri);
+        res["subtitle"] = _("1 subscriber", "%d subscribers", channel.subscriber_count());
+        res["description"] = channel.description();
+        document.description = channel.description();
+        break;
+    }
+    case Resource::Kind::guideCategory: {
+        DepartmentPath path { DepartmentType::guide_category, resource.id() };
+        res.set_uri(department_uri(path.to_string()));
+        break;
+    }
+    case Resource::Kind::subscription: {
+        res["art"] = resource.picture();
+        res.set_uri(scope_uri_);
+        break;
+    }
+    case Resource::Kind::subscriptionItem: {
+        const SubscriptionItem &subs_item =
+                static_cast<const SubscriptionItem &>(resource);
+        res["link"] = subs_item.link();
+        res["description"] = subs_item.description();
+        res["subtitle"] = subs_item.title();
+        // Which uploads the user follows is theirs alone, and the index
+        // is shared by every account, so these aren't indexed
+        res.set_uri(subs_item.video_id());
+        break;
+    }
+    case Resource::Kind::playlist: {
+        const Playlist &playlist = static_cast<const Playlist &>(resource);
+        DepartmentPath path { DepartmentType::playlist, playlist.id() };
+        res.set_uri(department_uri(path.to_string()));
+        res["subtitle"] = _("1 video", "%d videos", playlist.item_count());
+        res["description"] = playlist.description();
+        break;
+    }
+    case Resource::Kind::playlistItem: {
+        const PlaylistItem &playlist_item =
+                static_cast<const PlaylistItem &>(resource);
+        res["link"] = playlist_item.link();
+        res["description"] = playlist_item.description();
+        res["subtitle"] = playlist_item.username();
+        // Playlist items may come from the user's own Watch Later or
+        // Favorites, so they aren't indexed either
+        res.set_uri(playlist_item.video_id());
+        break;
+    }
+    case Resource::Kind::video: {
+        const Video &video = static_cast<const Video &>(resource);
+        res["link"] = video.link();
+        res["description"] = video.description();
+        res["subtitle"] = video.username();
+        res.set_uri(video.id());
+        document.uri = video.id();
+        document.channel = video.username();
+        document.description = video.description();
+        document.link = video.link();
+        // add a flag that will determine if this version of the youtube scope
+        // processes the department "aggregated:musicaggregator"
+        res["musicaggregation"] = music_aggregation_;
+        break;
+    }
+    default:
+      break;
+    }
+
+    if (offline_index_ && !document.uri.empty()) {
+        // The same video shows up as a video and as a playlist item, so key
+        // it on the URI
+        document.id = document.uri;
+        document.kind = move(kind);
+        document.title = resource.title();
+        document.art = resource.picture();
+        documents_.emplace_back(move(document));
+    }
+
+    return res;
+}
+
+bool ResultEmitter::emit(const sc::Category::SCPtr &category,
+        const Resource &resource, const Push &push) {
+    size_t documents = documents_.size();
+    if (!push(result(category, resource))) {
+        // It never reached the shell, so don't remember it
+        documents_.erase(documents_.begin() + documents, documents_.end());
+        return false;
+    }
+    return true;
+}
+
+void ResultEmitter::index() {
+    if (offline_index_ && !documents_.empty()) {
+        offline_index_->add(move(documents_));
+        documents_.clear();
+    }
+}
@@ -17,12 +17,20 @@
  *         Gary Wang  <gary.wang@canonical.com>
  */
 
+#include <youtube/api/circuit-breaker.h>
+#include <youtube/api/failure-cache.h>
+#include <youtube/api/quota-budget.h>
+#include <youtube/scope/duplicate-filter.h>
 #include <youtube/scope/localisation.h>
+#include <youtube/scope/partial-reply.h>
 #include <youtube/scope/scope.h>
 #include <youtube/scope/query.h>
 #include <youtube/scope/preview.h>
 #include <youtube/scope/activation.h>
 
+#include <fstream>
+#include <iostream>
+
 namespace sc = unity::scopes;
 using namespace std;
 using namespace youtube::scope;
@@ -39,14 +47,128 @@ void Scope::start(string const&) {
                 new sc::OnlineAccountClient(SCOPE_INSTALL_NAME,
                         "sharing", "google"));
     }
+
+    string cache_directory;
+    try {
+        cache_directory = ScopeBase::cache_directory();
+    } catch (exception &e) {
+        cerr << "No cache directory: " << e.what() << endl;
+    }
+
+    // Parse every card template once, and fail straight away if one is broken
+    renderers_ = make_shared<const RendererRegistry>();
+
+    department_cache_ = make_shared<DepartmentCache>();
+
+    featured_playlists_ = make_shared<FeaturedPlaylistCache>(oa_client_,
+            cache_directory.empty() ?
+                    string() : cache_directory + "/featured-playlists");
+    featured_playlists_->load();
+
+    home_refresher_ = make_shared<HomeRefresher>(oa_client_,
+            featured_playlists_);
+    home_refresher_->start();
+
+    browse_cache_ = make_shared<BrowseCache>(oa_client_);
+
+    chart_cache_ = make_shared<ChartCache>(oa_client_);
+    chart_cache_->start();
+
+    search_cache_ = make_shared<SearchCache>();
+
+    result_cache_ = make_shared<ResultCache>();
+
+    uploads_playlists_ = make_shared<UploadsPlaylistCache>(
+            cache_directory.empty() ?
+                    string() : cache_directory + "/uploads-playlists");
+    uploads_playlists_->load();
+
+    subscription_feed_ = make_shared<SubscriptionFeed>(uploads_playlists_);
+
+    if (!cache_directory.empty()) {
+        offline_index_ = make_shared<OfflineIndex>(cache_directory);
+        offline_index_->load();
+        offline_index_->start();
+    }
+
+    reactor_ = make_shared<Reactor>();
+    reactor_->start();
 }
 
 void Scope::stop() {
+    if (reactor_) {
+        reactor_->stop();
+    }
+    if (home_refresher_) {
+        home_refresher_->stop();
+    }
+    if (featured_playlists_) {
+        featured_playlists_->stop();
+        featured_playlists_->save();
+    }
+    if (browse_cache_) {
+        browse_cache_->stop();
+    }
+    if (chart_cache_) {
+        chart_cache_->stop();
+    }
+    if (uploads_playlists_) {
+        uploads_playlists_->save();
+    }
+    if (offline_index_) {
+        offline_index_->stop();
+        offline_index_->compact();
+    }
+
+    // The counters cover the life of the scope, so they go out as it stops:
+    // to stderr, or appended to the file YOUTUBE_SCOPE_STATS names
+    const char *stats_path = getenv("YOUTUBE_SCOPE_STATS");
+    if (stats_path != nullptr && *stats_path != '\0') {
+        ofstream out(stats_path, ios::app);
+        dump_stats(out);
+    } else if (stats_path != nullptr) {
+        dump_stats(cerr);
+    }
+}
+
+void Scope::dump_stats(ostream &out) {
+    if (featured_playlists_) {
+        featured_playlists_->dump_stats(out);
+    }
+    if (browse_cache_) {
+        browse_cache_->dump_stats(out);
+    }
+    if (chart_cache_) {
+        chart_cache_->dump_stats(out);
+    }
+    if (search_cache_) {
+        search_cache_->dump_stats(out);
+    }
+    if (result_cache_) {
+        result_cache_->dump_stats(out);
+    }
+    if (subscription_feed_) {
+        subscription_feed_->dump_stats(out);
+    }
+    if (offline_index_) {
+        out << "Offline index documents: " << offline_index_->size() << endl;
+    }
+    QuotaBudget::instance()->dump_stats(out);
+    CircuitBreaker::instance()->dump_stats(out);
+    out << "Known failures served: " << FailureCache::instance()->hits()
+            << endl;
+    out << "Duplicate results suppressed: "
+            << DuplicateFilter::total_suppressed() << endl;
+    PartialReply::dump_stats(out);
 }
 
 sc::SearchQueryBase::UPtr Scope::search(const sc::CannedQuery &query,
         const sc::SearchMetadata &metadata) {
-    return sc::SearchQueryBase::UPtr(new Query(query, metadata, oa_client_));
+    return sc::SearchQueryBase::UPtr(new Query(query, metadata, oa_client_,
+            department_cache_, home_refresher_, browse_cache_, reactor_,
+            search_cache_, offline_index_, subscription_feed_,
+            uploads_playlists_, featured_playlists_, chart_cache_,
+            result_cache_, renderers_));
 }
 
 sc::PreviewQueryBase::UPtr Scope::preview(sc::Result const& result,
@@ -59,7 +181,8 @@ sc::ActivationQueryBase::UPtr Scope::perform_action(const sc::Result &result,
                                                     const std::string &widget_id,
                                                     const std::string &action_id) {
     return sc::ActivationQueryBase::UPtr(new Activation(result, metadata, action_id,
-                                                        oa_client_));
+                                                        oa_client_, department_cache_,
+                                                        result_cache_, browse_cache_));
 }
 
 #define EXPORT __attribute__ ((visibility ("default")))
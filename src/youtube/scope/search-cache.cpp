@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/quota-budget.h>
+#include <youtube/scope/search-cache.h>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+
+#include <cctype>
+#include <vector>
+
+namespace alg = boost::algorithm;
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace {
+
+static string to_lower(const string &s) {
+    string result(s);
+    for (char &c : result) {
+        c = tolower(static_cast<unsigned char>(c));
+    }
+    return result;
+}
+
+}
+
+SearchCache::InFlight::InFlight(Ptr cache, const string &session,
+        const function<void()> &cancel) :
+        cache_(cache), session_(session) {
+    if (cache_ && !session_.empty()) {
+        id_ = cache_->begin(session_, cancel);
+    }
+}
+
+SearchCache::InFlight::~InFlight() {
+    if (cache_ && id_ != 0) {
+        cache_->end(session_, id_, completed_);
+    }
+}
+
+void SearchCache::InFlight::completed() {
+    completed_ = true;
+}
+
+SearchCache::SearchCache(chrono::seconds ttl, size_t max_entries) :
+        ttl_(ttl), max_entries_(max_entries) {
+}
+
+string SearchCache::normalize(const string &query) {
+    string result;
+    bool space = false;
+    for (char c : query) {
+        if (isspace(static_cast<unsigned char>(c))) {
+            space = !result.empty();
+            continue;
+        }
+        if (space) {
+            result += ' ';
+            space = false;
+        }
+        result += tolower(static_cast<unsigned char>(c));
+    }
+    return result;
+}
+
+string SearchCache::make_key(const Key &key, const string &query) {
+    return key.category_id + "|" + to_string(key.cardinality) + "|"
+            + key.country_code + "|" + query;
+}
+
+SearchCache::Entry * SearchCache::find(const string &full_key) {
+    auto it = entries_.find(full_key);
+    if (it == entries_.end()) {
+        return nullptr;
+    }
+
+    // Once the quota has run out, old results are better than none
+    if (chrono::steady_clock::now() - it->second.stored > ttl_
+            && QuotaBudget::instance()->level() != QuotaBudget::Level::exhausted) {
+        recently_used_.erase(it->second.position);
+        entries_.erase(it);
+        return nullptr;
+    }
+
+    recently_used_.splice(recently_used_.begin(), recently_used_,
+            it->second.position);
+    return &it->second;
+}
+
+SearchListResponse::Ptr SearchCache::get(const Key &key) {
+    lock_guard<mutex> lock(mutex_);
+
+    Entry *entry = find(make_key(key, normalize(key.query)));
+    if (!entry) {
+        ++stats_.misses;
+        return SearchListResponse::Ptr();
+    }
+
+    ++stats_.hits;
+    return entry->response;
+}
+
+SearchListResponse::ResourceList SearchCache::provisional(const Key &key) {
+    string query = normalize(key.query);
+    vector<string> words;
+    alg::split(words, query, alg::is_space(), alg::token_compress_on);
+
+    if (query.empty()) {
+        return SearchListResponse::ResourceList();
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    for (size_t length = query.size() - 1; length > 0; --length) {
+        Entry *entry = find(make_key(key, query.substr(0, length)));
+        if (!entry) {
+            continue;
+        }
+
+        // Only keep what would plausibly be a result for the longer query
+        SearchListResponse::ResourceList result;
+        for (const Resource::Ptr &resource : entry->response->items()) {
+            string title = to_lower(resource->title());
+            bool matches = true;
+            for (const string &word : words) {
+                if (title.find(word) == string::npos) {
+                    matches = false;
+                    break;
+                }
+            }
+            if (matches) {
+                result.emplace_back(resource);
+            }
+        }
+
+        if (!result.empty()) {
+            ++stats_.provisional;
+        }
+        return result;
+    }
+
+    return SearchListResponse::ResourceList();
+}
+
+void SearchCache::put(const Key &key, SearchListResponse::Ptr response) {
+    string full_key = make_key(key, normalize(key.query));
+
+    lock_guard<mutex> lock(mutex_);
+    auto it = entries_.find(full_key);
+    if (it != entries_.end()) {
+        recently_used_.erase(it->second.position);
+        entries_.erase(it);
+    }
+
+    recently_used_.emplace_front(full_key);
+    entries_[full_key] = Entry { response, chrono::steady_clock::now(),
+            recently_used_.begin() };
+
+    while (entries_.size() > max_entries_) {
+        entries_.erase(recently_used_.back());
+        recently_used_.pop_back();
+    }
+}
+
+unsigned long SearchCache::begin(const string &session,
+        const function<void()> &cancel) {
+    lock_guard<mutex> lock(mutex_);
+
+    auto it = sessions_.find(session);
+    if (it != sessions_.end()) {
+        // The user has typed something newer, so nobody wants this any more
+        it->second.cancel();
+        ++stats_.superseded;
+    }
+
+    unsigned long id = next_id_++;
+    sessions_[session] = Session { id, cancel };
+    return id;
+}
+
+void SearchCache::end(const string &session, unsigned long id,
+        bool completed) {
+    lock_guard<mutex> lock(mutex_);
+
+    auto it = sessions_.find(session);
+    if (it != sessions_.end() && it->second.id == id) {
+        sessions_.erase(it);
+    }
+    if (!completed) {
+        ++stats_.wasted_requests;
+    }
+}
+
+SearchCache::Stats SearchCache::stats() {
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+void SearchCache::dump_stats(ostream &out) {
+    Stats stats = this->stats();
+    unsigned long lookups = stats.hits + stats.misses;
+
+    out << "Search cache: hits " << stats.hits << "/" << lookups;
+    if (lookups > 0) {
+        out << " (" << (100 * stats.hits / lookups) << "%)";
+    }
+    out << ", provisional " << stats.provisional << ", superseded "
+            << stats.superseded << ", wasted requests "
+            << stats.wasted_requests << endl;
+}
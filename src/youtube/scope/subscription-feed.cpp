@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/fan-out.h>
+#include <youtube/scope/subscription-feed.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <queue>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace {
+static constexpr bool DEBUG_MODE = false;
+}
+
+SubscriptionFeed::SubscriptionFeed(
+        UploadsPlaylistCache::Ptr uploads_playlists, chrono::seconds ttl,
+        size_t max_in_flight, size_t max_channels) :
+        uploads_playlists_(uploads_playlists), ttl_(ttl), max_in_flight_(
+                max_in_flight), max_channels_(max_channels) {
+    if (!uploads_playlists_) {
+        uploads_playlists_ = make_shared<UploadsPlaylistCache>();
+    }
+}
+
+Client::SubscriptionItemList SubscriptionFeed::latest(Client &client,
+        const Client::SubscriptionList &subscriptions, size_t max_items) {
+    vector<string> stale;
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto now = chrono::steady_clock::now();
+        for (const Subscription::Ptr &subscription : subscriptions) {
+            auto it = channels_.find(subscription->id());
+            if (it == channels_.end() || !it->second.uploads
+                    || now - it->second.fetched > ttl_) {
+                stale.emplace_back(subscription->id());
+            } else {
+                ++stats_.channels_cached;
+            }
+        }
+    }
+
+    if (!stale.empty()) {
+        refresh(client, stale);
+    }
+
+    vector<shared_ptr<const Uploads>> lists;
+    {
+        lock_guard<mutex> lock(mutex_);
+        for (const Subscription::Ptr &subscription : subscriptions) {
+            auto it = channels_.find(subscription->id());
+            if (it != channels_.end() && it->second.uploads
+                    && !it->second.uploads->empty()) {
+                lists.emplace_back(it->second.uploads);
+            }
+        }
+
+        // Only now, so what we just fetched makes it into this feed
+        trim();
+    }
+
+    // Each list is already newest first, so merge them by always taking the
+    // newest head
+    struct Cursor {
+        int64_t published_at;
+
+        size_t list;
+
+        size_t position;
+
+        bool operator<(const Cursor &other) const {
+            return published_at < other.published_at;
+        }
+    };
+
+    priority_queue<Cursor> heads;
+    for (size_t list = 0; list < lists.size(); ++list) {
+        heads.push(Cursor { lists[list]->front()->published_at(), list, 0 });
+    }
+
+    Client::SubscriptionItemList result;
+    while (!heads.empty() && result.size() < max_items) {
+        Cursor head = heads.top();
+        heads.pop();
+
+        const Uploads &uploads = *lists[head.list];
+        result.emplace_back(uploads[head.position]);
+        if (++head.position < uploads.size()) {
+            head.published_at = uploads[head.position]->published_at();
+            heads.push(head);
+        }
+    }
+    return result;
+}
+
+void SubscriptionFeed::refresh(Client &client,
+        const vector<string> &channel_ids) {
+    vector<string> retry = fetch_uploads(client, channel_ids, false);
+    if (!retry.empty()) {
+        // The playlists we derived didn't work out, so ask YouTube
+        fetch_uploads(client, retry, true);
+    }
+}
+
+void SubscriptionFeed::trim() {
+    if (channels_.size() <= max_channels_) {
+        return;
+    }
+
+    typedef map<string, Channel>::iterator Entry;
+    vector<Entry> entries;
+    for (auto it = channels_.begin(); it != channels_.end(); ++it) {
+        entries.emplace_back(it);
+    }
+    size_t surplus = channels_.size() - max_channels_;
+    nth_element(entries.begin(), entries.begin() + surplus, entries.end(),
+            [](const Entry &a, const Entry &b) {
+                return a->second.fetched < b->second.fetched;
+            });
+    for (size_t index = 0; index < surplus; ++index) {
+        channels_.erase(entries[index]);
+    }
+}
+
+vector<string> SubscriptionFeed::fetch_uploads(Client &client,
+        const vector<string> &channel_ids, bool lookup) {
+    // Known and derived playlists don't need a request
+    vector<string> playlists(channel_ids.size());
+    vector<size_t> unknown;
+    for (size_t index = 0; index < channel_ids.size(); ++index) {
+        if (!lookup) {
+            playlists[index] = uploads_playlists_->get(channel_ids[index]);
+        }
+        if (playlists[index].empty()) {
+            unknown.emplace_back(index);
+        }
+    }
+    vector<bool> verified(channel_ids.size(), false);
+    for (size_t index = 0; index < channel_ids.size(); ++index) {
+        verified[index] = lookup || !playlists[index].empty();
+    }
+
+    FanOut<string>::Options playlists_options =
+            FanOut<string>::default_options();
+    playlists_options.max_in_flight = max_in_flight_;
+    FanOut<string> playlists_fan_out(playlists_options);
+    for (size_t index : unknown) {
+        const string &channel_id = channel_ids[index];
+        auto abort = make_shared<atomic<bool>>(false);
+        playlists_fan_out.add([&client, channel_id, lookup, abort]() -> future<string> {
+            Client::Ptr branch = client.abortable(abort);
+            if (lookup) {
+                return branch->lookup_channel_uploads(channel_id);
+            }
+            return branch->subscription_channel_uploads(channel_id);
+        }, abort);
+    }
+    playlists_fan_out.run(
+            [&channel_ids, &playlists, &verified, &unknown](size_t index,
+                    string &playlist) {
+                size_t channel = unknown[index];
+                playlists[channel] = playlist;
+                verified[channel] = verified[channel]
+                        || Client::derive_uploads_playlist(channel_ids[channel])
+                                != playlist;
+            },
+            [&channel_ids, &unknown](size_t index, exception_ptr) {
+                if (DEBUG_MODE) {
+                    cerr << "  no uploads playlist: "
+                            << channel_ids[unknown[index]] << endl;
+                }
+            });
+
+    vector<size_t> fetching;
+    FanOut<Client::SubscriptionItemList>::Options items_options =
+            FanOut<Client::SubscriptionItemList>::default_options();
+    items_options.max_in_flight = max_in_flight_;
+    FanOut<Client::SubscriptionItemList> items_fan_out(items_options);
+    for (size_t index = 0; index < channel_ids.size(); ++index) {
+        const string &playlist = playlists[index];
+        if (playlist.empty()) {
+            continue;
+        }
+        fetching.emplace_back(index);
+        auto abort = make_shared<atomic<bool>>(false);
+        items_fan_out.add([&client, playlist, abort]() {
+            return client.abortable(abort)->subscription_items(playlist);
+        }, abort);
+    }
+
+    vector<string> retry;
+    auto now = chrono::steady_clock::now();
+    items_fan_out.run(
+            [this, &channel_ids, &playlists, &fetching, now](size_t index,
+                    Client::SubscriptionItemList &items) {
+                size_t channel = fetching[index];
+                uploads_playlists_->put(channel_ids[channel], playlists[channel]);
+
+                // Parse once and sort here, rather than on every merge
+                auto uploads = make_shared<Uploads>(items.begin(), items.end());
+                stable_sort(uploads->begin(), uploads->end(),
+                        [](const SubscriptionItem::Ptr &a,
+                                const SubscriptionItem::Ptr &b) {
+                            return a->published_at() > b->published_at();
+                        });
+
+                lock_guard<mutex> lock(mutex_);
+                channels_[channel_ids[channel]] = Channel { uploads, now };
+                ++stats_.channels_fetched;
+            },
+            [&channel_ids, &fetching, &verified, &retry](size_t index,
+                    exception_ptr) {
+                // Otherwise keep showing what we had
+                size_t channel = fetching[index];
+                if (!verified[channel]) {
+                    retry.emplace_back(channel_ids[channel]);
+                }
+            });
+    return retry;
+}
+
+SubscriptionFeed::Stats SubscriptionFeed::stats() {
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+void SubscriptionFeed::dump_stats(ostream &out) {
+    Stats stats = this->stats();
+    out << "Subscription feed: channels fetched " << stats.channels_fetched
+            << ", served from cache " << stats.channels_cached << endl;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/scope/uploads-playlist-cache.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+using namespace youtube::scope;
+
+UploadsPlaylistCache::UploadsPlaylistCache(const string &path) :
+        path_(path) {
+}
+
+void UploadsPlaylistCache::load() {
+    if (path_.empty()) {
+        return;
+    }
+
+    ifstream in(path_);
+    string channel_id, playlist_id;
+
+    lock_guard<mutex> lock(mutex_);
+    while (in >> channel_id >> playlist_id) {
+        playlists_[channel_id] = playlist_id;
+    }
+}
+
+void UploadsPlaylistCache::save() {
+    lock_guard<mutex> lock(mutex_);
+    if (path_.empty() || !dirty_) {
+        return;
+    }
+
+    string temporary_path = path_ + ".tmp";
+    {
+        ofstream out(temporary_path, ios::trunc);
+        for (const auto &entry : playlists_) {
+            out << entry.first << ' ' << entry.second << '\n';
+        }
+        if (!out) {
+            cerr << "Failed to write uploads playlists: " << temporary_path
+                    << endl;
+            remove(temporary_path.c_str());
+            return;
+        }
+    }
+
+    if (rename(temporary_path.c_str(), path_.c_str()) != 0) {
+        cerr << "Failed to replace uploads playlists: " << path_ << endl;
+        return;
+    }
+    dirty_ = false;
+}
+
+string UploadsPlaylistCache::get(const string &channel_id) {
+    lock_guard<mutex> lock(mutex_);
+    auto it = playlists_.find(channel_id);
+    if (it == playlists_.end()) {
+        return string();
+    }
+    return it->second;
+}
+
+void UploadsPlaylistCache::put(const string &channel_id,
+        const string &playlist_id) {
+    if (channel_id.empty() || playlist_id.empty()) {
+        return;
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    string &existing = playlists_[channel_id];
+    if (existing != playlist_id) {
+        existing = playlist_id;
+        dirty_ = true;
+    }
+}
+
+size_t UploadsPlaylistCache::size() {
+    lock_guard<mutex> lock(mutex_);
+    return playlists_.size();
+}
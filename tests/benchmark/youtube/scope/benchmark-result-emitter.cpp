@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <youtube/api/client.h>
+#include <youtube/api/playlist-item.h>
+#include <youtube/scope/localisation.h>
+#include <youtube/scope/result-emitter.h>
+
+#include <gtest/gtest.h>
+#include <json/json.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <unity/scopes/CannedQuery.h>
+#include <unity/scopes/CategorisedResult.h>
+#include <unity/scopes/CategoryRenderer.h>
+#include <unity/scopes/testing/Category.h>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace sc = unity::scopes;
+namespace sct = unity::scopes::testing;
+
+namespace {
+
+static const size_t PLAYLIST_SIZE = 50;
+
+static const size_t ITERATIONS = 2000;
+
+static Client::PlaylistItemList make_playlist() {
+    Client::PlaylistItemList items;
+    for (size_t i = 0; i < PLAYLIST_SIZE; ++i) {
+        string video_id = "video" + to_string(i);
+
+        Json::Value data;
+        data["kind"] = "youtube#playlistItem";
+        data["id"] = "item" + to_string(i);
+        data["snippet"]["title"] = "Video number " + to_string(i);
+        data["snippet"]["description"] = string(400, 'x');
+        data["snippet"]["channelTitle"] = "Some channel";
+        data["snippet"]["thumbnails"]["high"]["url"] =
+                "https://i.ytimg.com/vi/" + video_id + "/hqdefault.jpg";
+        data["contentDetails"]["videoId"] = video_id;
+
+        items.emplace_back(make_shared<PlaylistItem>(data));
+    }
+    return items;
+}
+
+/**
+ * A playlist item's result as push_resource built it before ResultEmitter,
+ * with a canned query and the playlist lookups for every result.
+ */
+static sc::CategorisedResult push_resource_result(
+        const sc::Category::SCPtr &category, const Resource::Ptr &resource,
+        map<string, string> &playlist) {
+    sc::CategorisedResult res(category);
+    res.set_title(resource->title());
+    res.set_art(resource->picture());
+    res["kind"] = resource->kind_str();
+
+    if (playlist.size() > 0) {
+        res["fav_playlist"] = playlist[_("Favorites")];
+        res["watch_playlist"] = playlist[_("Watch Later")];
+    }
+
+    sc::CannedQuery new_query(SCOPE_INSTALL_NAME);
+
+    OfflineIndex::Document document;
+
+    PlaylistItem::Ptr playlist_item(static_pointer_cast<PlaylistItem>(resource));
+    res["link"] = playlist_item->link();
+    res["description"] = playlist_item->description();
+    res["subtitle"] = playlist_item->username();
+    res.set_uri(playlist_item->video_id());
+    document.uri = res.uri();
+    document.channel = playlist_item->username();
+    document.description = playlist_item->description();
+    document.link = playlist_item->link();
+
+    return res;
+}
+
+static void report(const string &name, chrono::steady_clock::duration elapsed) {
+    double seconds = chrono::duration<double>(elapsed).count();
+    double per_second = PLAYLIST_SIZE * ITERATIONS / max(seconds, 1e-9);
+    cout << setw(16) << name << setw(12)
+            << chrono::duration_cast<chrono::milliseconds>(elapsed).count()
+            << setw(16) << fixed << setprecision(0) << per_second << endl;
+}
+
+TEST(BenchmarkResultEmitter, playlist_results) {
+    Client::PlaylistItemList items = make_playlist();
+    sc::Category::SCPtr category = make_shared<sct::Category>("youtube",
+            "Playlist contents", "", sc::CategoryRenderer());
+    map<string, string> playlists { { _("Favorites"), "FL1" }, {
+            _("Watch Later"), "WL1" } };
+
+    cout << "Results for a " << PLAYLIST_SIZE << " item playlist, "
+            << ITERATIONS << " times" << endl;
+    cout << setw(16) << "emitter" << setw(12) << "total ms" << setw(16)
+            << "results/s" << endl;
+
+    size_t count = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < ITERATIONS; ++i) {
+        for (const PlaylistItem::Ptr &item : items) {
+            count += !push_resource_result(category, item, playlists).uri().empty();
+        }
+    }
+    report("push_resource", chrono::steady_clock::now() - start);
+    EXPECT_EQ(PLAYLIST_SIZE * ITERATIONS, count);
+
+    count = 0;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < ITERATIONS; ++i) {
+        ResultEmitter emitter;
+        emitter.set_playlists(playlists);
+        emitter.emit_all(category, items,
+                [&count](const sc::CategorisedResult &res) {
+                    count += !res.uri().empty();
+                    return true;
+                });
+    }
+    report("batch", chrono::steady_clock::now() - start);
+    EXPECT_EQ(PLAYLIST_SIZE * ITERATIONS, count);
+}
+
+}
@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/scheduler.h>
+#include <youtube/scope/scope.h>
+
+#include <core/posix/exec.h>
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unity/scopes/SearchReply.h>
+#include <unity/scopes/SearchReplyProxyFwd.h>
+#include <unity/scopes/testing/Category.h>
+#include <unity/scopes/testing/MockSearchReply.h>
+#include <unity/scopes/testing/TypedScopeFixture.h>
+
+using namespace std;
+using namespace testing;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace posix = core::posix;
+namespace sc = unity::scopes;
+namespace sct = unity::scopes::testing;
+
+namespace {
+
+// Simulated round trip time to YouTube, in seconds
+static const string RESPONSE_DELAY = "0.2";
+
+static size_t thread_count() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 8, "Threads:") == 0) {
+            return stoul(line.substr(8));
+        }
+    }
+    return 0;
+}
+
+typedef sct::TypedScopeFixture<Scope> TypedScopeFixtureScope;
+
+class BenchmarkYoutubeScope: public TypedScopeFixtureScope {
+protected:
+    struct Measurement {
+        chrono::milliseconds elapsed;
+
+        size_t peak_threads;
+    };
+
+    void SetUp() override
+    {
+        fake_youtube_server_ = posix::exec(FAKE_YOUTUBE_SERVER, { },
+                { { "FAKE_YOUTUBE_DELAY", RESPONSE_DELAY } },
+                posix::StandardStream::stdout);
+
+        ASSERT_GT(fake_youtube_server_.pid(), 0);
+        string port;
+        fake_youtube_server_.cout() >> port;
+
+        string apiroot = "http://127.0.0.1:" + port;
+        setenv("YOUTUBE_SCOPE_APIROOT", apiroot.c_str(), true);
+
+        setenv("YOUTUBE_SCOPE_IGNORE_ACCOUNTS", "true", true);
+
+        // Do the parent SetUp
+        TypedScopeFixture::set_scope_directory(TEST_SCOPE_DIRECTORY);
+        TypedScopeFixtureScope::SetUp();
+    }
+
+    /**
+     * Starts count copies of the query at once, and waits for all of them
+     * to finish.
+     */
+    Measurement run_concurrently(const sc::CannedQuery &query, size_t count,
+            const sc::SearchMetadata &meta_data = sc::SearchMetadata("en_EN", "phone")) {
+        mutex finished_mutex;
+        condition_variable finished_changed;
+        size_t finished = 0;
+
+        vector<unique_ptr<NiceMock<sct::MockSearchReply>>> replies;
+        vector<sc::SearchQueryBase::UPtr> queries;
+
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            replies.emplace_back(new NiceMock<sct::MockSearchReply>());
+            NiceMock<sct::MockSearchReply> &reply = *replies.back();
+            ON_CALL(reply, register_category(_, _, _, _)).WillByDefault(
+                    Invoke([](const string &id, const string &title,
+                            const string &icon,
+                            const sc::CategoryRenderer &renderer) {
+                        return make_shared<sct::Category>(id, title, icon, renderer);
+                    }));
+            ON_CALL(reply, push(Matcher<sc::CategorisedResult const&>(_))).WillByDefault(
+                    Return(true));
+
+            // Like the runtime, treat the query as finished once the last
+            // reference to its reply has gone
+            sc::SearchReplyProxy reply_proxy(&reply,
+                    [&finished_mutex, &finished_changed, &finished](sc::SearchReply*) {
+                        lock_guard<mutex> lock(finished_mutex);
+                        ++finished;
+                        finished_changed.notify_all();
+                    });
+
+            queries.emplace_back(scope->search(query, meta_data));
+            queries.back()->run(reply_proxy);
+        }
+
+        size_t peak_threads = thread_count();
+        unique_lock<mutex> lock(finished_mutex);
+        while (finished < count) {
+            finished_changed.wait_for(lock, chrono::milliseconds(10));
+            peak_threads = max(peak_threads, thread_count());
+        }
+        lock.unlock();
+
+        auto elapsed = chrono::duration_cast<chrono::milliseconds>(
+                chrono::steady_clock::now() - start);
+        queries.clear();
+
+        return Measurement { elapsed, peak_threads };
+    }
+
+    void report(const string &name, const sc::CannedQuery &query) {
+        cout << name << " (" << RESPONSE_DELAY << "s per request)" << endl;
+        cout << setw(12) << "concurrent" << setw(12) << "total ms"
+                << setw(12) << "queries/s" << setw(12) << "threads" << endl;
+
+        for (size_t count : { 1, 10, 100, 500 }) {
+            Measurement measurement = run_concurrently(query, count);
+            double per_second = count * 1000.0
+                    / max<long long>(measurement.elapsed.count(), 1);
+            cout << setw(12) << count << setw(12)
+                    << measurement.elapsed.count() << setw(12) << fixed
+                    << setprecision(1) << per_second << setw(12)
+                    << measurement.peak_threads << endl;
+        }
+    }
+
+    posix::ChildProcess fake_youtube_server_ = posix::ChildProcess::invalid();
+};
+
+TEST_F(BenchmarkYoutubeScope, concurrent_searches) {
+    report("Search", sc::CannedQuery(SCOPE_NAME, "banana", ""));
+}
+
+TEST_F(BenchmarkYoutubeScope, concurrent_department_browsing) {
+    report("Department",
+            sc::CannedQuery(SCOPE_NAME, "", "guideCategory:GCTXVzaWM"));
+}
+
+TEST_F(BenchmarkYoutubeScope, category_browse_strategies) {
+    sc::CannedQuery query(SCOPE_NAME, "", "guideCategory:GCTXVzaWM");
+
+    // Let the scope learn each channel's featured playlist first, as it
+    // would have done long before in use. A different locale keeps the
+    // reply itself from being replayed below.
+    run_concurrently(query, 1, sc::SearchMetadata("en_GB", "phone"));
+
+    cout << "Department by strategy (" << RESPONSE_DELAY
+            << "s per request)" << endl;
+    cout << setw(12) << "strategy" << setw(12) << "cardinality"
+            << setw(12) << "requests" << setw(12) << "total ms" << endl;
+
+    for (const string strategy : { "channels", "chart" }) {
+        for (int cardinality : { 0, 5 }) {
+            sc::SearchMetadata meta_data("en_EN", "phone");
+            meta_data.set_cardinality(cardinality);
+            meta_data.set_hint("browse-strategy", sc::Variant(strategy));
+
+            unsigned long started = Scheduler::instance()->stats(
+                    Scheduler::Priority::foreground).started;
+            Measurement measurement = run_concurrently(query, 1, meta_data);
+            unsigned long requests = Scheduler::instance()->stats(
+                    Scheduler::Priority::foreground).started - started;
+
+            cout << setw(12) << strategy << setw(12) << cardinality
+                    << setw(12) << requests << setw(12)
+                    << measurement.elapsed.count() << endl;
+        }
+    }
+}
+
+TEST_F(BenchmarkYoutubeScope, concurrent_aggregator_queries) {
+    report("Aggregated music",
+            sc::CannedQuery(SCOPE_NAME, "", "aggregated:musicaggregator"));
+}
+
+} // namespace
@@ -20,6 +20,7 @@
 import base64
 import json
 import os
+import tornado.gen
 import tornado.httpserver
 import tornado.ioloop
 import tornado.netutil
@@ -36,12 +37,21 @@ def read_file(path):
         with open(file, 'r') as fp:
             content = fp.read()
     else:
-        raise Exception("File '%s' not found\n" % file)
+        # YouTube answers requests for things that don't exist with a 404
+        raise tornado.web.HTTPError(404, "File '%s' not found" % file)
     return content
 
 GUIDE_CATEGORIES = read_file('guide-categories.json')
 
+# Artificial latency in seconds, so the benchmarks see realistic response times
+RESPONSE_DELAY = float(os.environ.get('FAKE_YOUTUBE_DELAY', '0'))
+
 class ErrorHandler(tornado.web.RequestHandler):
+    @tornado.gen.coroutine
+    def prepare(self):
+        if RESPONSE_DELAY > 0:
+            yield tornado.gen.sleep(RESPONSE_DELAY)
+
     def write_error(self, status_code, **kwargs):
         self.write(json.dumps({'error': '%s: %d' % (kwargs["exc_info"][1], status_code)}))
 
@@ -110,11 +120,22 @@ class Search(ErrorHandler):
 class Videos(ErrorHandler):
     def get(self):
         validate_header(self, 'Accept-Encoding', 'gzip')
-        validate_argument(self, 'part', 'snippet')
 
         videoCategoryId = self.get_argument('videoCategoryId', None)
+        id = self.get_argument('id', None)
         if videoCategoryId:
+            validate_argument(self, 'part', 'snippet')
             self.write(read_file('videos/videoCategoryId/%s.json' % videoCategoryId))
+        elif id:
+            validate_argument(self, 'part', 'snippet,statistics')
+            # Like YouTube, leave out the ids that don't match a video
+            items = []
+            for video_id in id.split(','):
+                file = 'videos/id/%s.json' % video_id
+                if os.path.isfile(os.path.join(os.path.dirname(__file__), file)):
+                    items.append(json.loads(read_file(file)))
+            self.write(json.dumps({'kind': 'youtube#videoListResponse',
+                                   'items': items}))
 
         self.finish()
 
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/circuit-breaker.h>
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+using namespace std;
+using namespace youtube::api;
+
+namespace {
+
+class TestCircuitBreaker: public testing::Test {
+protected:
+    void fail(const string &endpoint, int times) {
+        for (int i = 0; i < times; ++i) {
+            ASSERT_TRUE(breaker_.allow(endpoint));
+            breaker_.record(endpoint, false);
+        }
+    }
+
+    void wait_to_probe() {
+        this_thread::sleep_for(chrono::milliseconds(30));
+    }
+
+    CircuitBreaker breaker_ { CircuitBreaker::Options { 4, 4, 0.5,
+            chrono::milliseconds(20) } };
+};
+
+TEST_F(TestCircuitBreaker, opens_once_enough_requests_fail) {
+    fail("search", 3);
+    EXPECT_EQ(CircuitBreaker::State::closed, breaker_.state("search"));
+
+    fail("search", 1);
+    EXPECT_EQ(CircuitBreaker::State::open, breaker_.state("search"));
+    EXPECT_FALSE(breaker_.allow("search"));
+
+    // Other endpoints carry on
+    EXPECT_TRUE(breaker_.allow("videos"));
+    EXPECT_EQ(1ul, breaker_.stats().opened);
+    EXPECT_EQ(1ul, breaker_.stats().rejected);
+}
+
+TEST_F(TestCircuitBreaker, stays_closed_while_most_requests_succeed) {
+    for (int i = 0; i < 12; ++i) {
+        ASSERT_TRUE(breaker_.allow("search"));
+        breaker_.record("search", i % 4 != 0);
+    }
+    EXPECT_EQ(CircuitBreaker::State::closed, breaker_.state("search"));
+
+    // Only the last few outcomes count
+    fail("search", 1);
+    EXPECT_EQ(CircuitBreaker::State::closed, breaker_.state("search"));
+    fail("search", 1);
+    EXPECT_EQ(CircuitBreaker::State::open, breaker_.state("search"));
+}
+
+TEST_F(TestCircuitBreaker, lets_one_probe_through_after_a_while) {
+    fail("search", 4);
+    wait_to_probe();
+
+    EXPECT_TRUE(breaker_.allow("search"));
+    EXPECT_EQ(CircuitBreaker::State::half_open, breaker_.state("search"));
+    EXPECT_FALSE(breaker_.allow("search"));
+
+    breaker_.record("search", true);
+    EXPECT_EQ(CircuitBreaker::State::closed, breaker_.state("search"));
+    EXPECT_TRUE(breaker_.allow("search"));
+}
+
+TEST_F(TestCircuitBreaker, opens_again_when_the_probe_fails) {
+    fail("search", 4);
+    wait_to_probe();
+
+    EXPECT_TRUE(breaker_.allow("search"));
+    breaker_.record("search", false);
+    EXPECT_EQ(CircuitBreaker::State::open, breaker_.state("search"));
+    EXPECT_FALSE(breaker_.allow("search"));
+    EXPECT_EQ(2ul, breaker_.stats().opened);
+}
+
+TEST_F(TestCircuitBreaker, probes_again_when_the_probe_tells_us_nothing) {
+    fail("search", 4);
+    wait_to_probe();
+
+    EXPECT_TRUE(breaker_.allow("search"));
+    breaker_.release("search");
+    EXPECT_TRUE(breaker_.allow("search"));
+}
+
+TEST_F(TestCircuitBreaker, probes_again_when_the_probe_never_comes_back) {
+    fail("search", 4);
+    wait_to_probe();
+
+    EXPECT_TRUE(breaker_.allow("search"));
+    EXPECT_FALSE(breaker_.allow("search"));
+    wait_to_probe();
+    EXPECT_TRUE(breaker_.allow("search"));
+}
+
+TEST_F(TestCircuitBreaker, reset_instance_starts_afresh) {
+    CircuitBreaker::Ptr breaker = CircuitBreaker::instance();
+    EXPECT_EQ(breaker, CircuitBreaker::instance());
+
+    CircuitBreaker::reset_instance();
+    EXPECT_NE(breaker, CircuitBreaker::instance());
+}
+
+}
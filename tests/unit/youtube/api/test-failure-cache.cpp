@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/failure-cache.h>
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace youtube::api;
+
+namespace {
+
+TEST(TestFailureCache, remembers_failures_until_they_expire) {
+    FailureCache cache(chrono::seconds(60));
+    cache.put("key /youtube/v3/channels?id=x", "Channel not found");
+
+    string message;
+    EXPECT_TRUE(cache.get("key /youtube/v3/channels?id=x", message));
+    EXPECT_EQ("Channel not found", message);
+    EXPECT_FALSE(cache.get("key /youtube/v3/channels?id=y", message));
+    EXPECT_EQ(1ul, cache.hits());
+}
+
+TEST(TestFailureCache, remembers_what_was_not_found) {
+    FailureCache cache(chrono::seconds(60));
+    cache.put("key /youtube/v3/playlistItems?playlistId=x",
+            "Playlist not found", true);
+    cache.put("key /youtube/v3/search?q=", "Bad request");
+
+    string message;
+    bool not_found = false;
+    EXPECT_TRUE(cache.get("key /youtube/v3/playlistItems?playlistId=x",
+            message, not_found));
+    EXPECT_TRUE(not_found);
+    EXPECT_TRUE(cache.get("key /youtube/v3/search?q=", message, not_found));
+    EXPECT_FALSE(not_found);
+}
+
+TEST(TestFailureCache, forgets_expired_failures) {
+    FailureCache cache(chrono::seconds(0));
+    cache.put("key /youtube/v3/channels?id=x", "Channel not found");
+    this_thread::sleep_for(chrono::milliseconds(1));
+
+    string message;
+    EXPECT_FALSE(cache.get("key /youtube/v3/channels?id=x", message));
+    EXPECT_EQ(0ul, cache.hits());
+}
+
+TEST(TestFailureCache, evicts_the_oldest_failures_first) {
+    FailureCache cache(chrono::seconds(60), 2);
+    cache.put("a", "first");
+    cache.put("b", "second");
+    // Storing again makes it the newest
+    cache.put("a", "first again");
+    cache.put("c", "third");
+
+    string message;
+    EXPECT_FALSE(cache.get("b", message));
+    EXPECT_TRUE(cache.get("a", message));
+    EXPECT_EQ("first again", message);
+    EXPECT_TRUE(cache.get("c", message));
+}
+
+TEST(TestFailureCache, reset_instance_forgets_every_failure) {
+    FailureCache::instance()->put("a", "failed");
+
+    FailureCache::reset_instance();
+    string message;
+    EXPECT_FALSE(FailureCache::instance()->get("a", message));
+}
+
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/fan-out.h>
+#include <youtube/api/reactor.h>
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace youtube::api;
+
+namespace {
+
+FanOut<int>::Options options(size_t max_in_flight,
+        chrono::milliseconds branch_timeout) {
+    FanOut<int>::Options options = FanOut<int>::default_options();
+    options.max_in_flight = max_in_flight;
+    options.branch_timeout = branch_timeout;
+    return options;
+}
+
+future<int> ready(int value) {
+    promise<int> result;
+    result.set_value(value);
+    return result.get_future();
+}
+
+TEST(TestFanOut, hands_over_results_with_their_index) {
+    FanOut<int> fan_out(options(2, chrono::seconds(5)));
+    for (int i = 0; i < 5; ++i) {
+        fan_out.add([i]() {return ready(i * 10);});
+    }
+
+    vector<int> results(5, -1);
+    fan_out.run([&results](size_t index, int &result) {
+        results[index] = result;
+    });
+    EXPECT_EQ(vector<int>({0, 10, 20, 30, 40}), results);
+}
+
+TEST(TestFanOut, reports_failures_without_stopping_the_others) {
+    FanOut<int> fan_out;
+    fan_out.add([]() {return ready(1);});
+    fan_out.add([]() -> future<int> {throw domain_error("failed");});
+    fan_out.add([]() {return ready(3);});
+
+    vector<size_t> succeeded, failed;
+    fan_out.run([&succeeded](size_t index, int &) {
+        succeeded.emplace_back(index);
+    }, [&failed](size_t index, exception_ptr) {
+        failed.emplace_back(index);
+    });
+    EXPECT_EQ(vector<size_t>({0, 2}), succeeded);
+    EXPECT_EQ(vector<size_t>({1}), failed);
+}
+
+TEST(TestFanOut, error_handlers_may_wait_for_requests) {
+    Reactor reactor(1);
+    reactor.start();
+    atomic<int> waited(0);
+    atomic<bool> done(false);
+    ASSERT_TRUE(reactor.spawn([&waited, &done]() {
+        FanOut<int> fan_out;
+        fan_out.add([]() -> future<int> {throw domain_error("failed");});
+        fan_out.add([]() {
+            promise<int> failed;
+            failed.set_exception(make_exception_ptr(domain_error("failed")));
+            return failed.get_future();
+        });
+        fan_out.run([](size_t, int &) {
+        }, [&waited](size_t, exception_ptr) {
+            // Would throw logic_error from inside a catch block
+            Reactor::suspend([]() {return true;},
+                    Reactor::TimePoint::max());
+            ++waited;
+        });
+        done = true;
+    }));
+
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+    while (!done && chrono::steady_clock::now() < deadline) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    reactor.stop();
+    EXPECT_TRUE(done);
+    EXPECT_EQ(2, waited);
+}
+
+TEST(TestFanOut, wakes_up_when_notified_outside_of_a_task) {
+    auto answer = make_shared<promise<int>>();
+    FanOut<int> fan_out(options(1, chrono::seconds(5)));
+    fan_out.add([answer]() {return answer->get_future();});
+
+    thread answering([answer]() {
+        this_thread::sleep_for(chrono::milliseconds(20));
+        answer->set_value(7);
+        Reactor::notify_all();
+    });
+
+    int result = 0;
+    fan_out.run([&result](size_t, int &value) {
+        result = value;
+    });
+    answering.join();
+    EXPECT_EQ(7, result);
+}
+
+TEST(TestFanOut, aborts_branches_that_time_out) {
+    promise<int> never;
+    auto slow = make_shared<atomic<bool>>(false);
+    auto quick = make_shared<atomic<bool>>(false);
+    FanOut<int> fan_out(options(2, chrono::milliseconds(20)));
+    fan_out.add([&never]() {return never.get_future();}, slow);
+    fan_out.add([]() {return ready(2);}, quick);
+
+    auto started = chrono::steady_clock::now();
+    vector<size_t> failed;
+    fan_out.run([](size_t, int &) {
+    }, [&failed](size_t index, exception_ptr) {
+        failed.emplace_back(index);
+    });
+    EXPECT_GE(chrono::steady_clock::now() - started, chrono::milliseconds(20));
+    EXPECT_EQ(vector<size_t>({0}), failed);
+    EXPECT_TRUE(*slow);
+    EXPECT_FALSE(*quick);
+}
+
+TEST(TestFanOut, aborts_the_rest_when_rethrowing_a_failure) {
+    promise<int> never;
+    auto pending = make_shared<atomic<bool>>(false);
+    FanOut<int> fan_out(options(2, chrono::seconds(5)));
+    fan_out.add([&never]() {return never.get_future();}, pending);
+    fan_out.add([]() -> future<int> {throw domain_error("failed");});
+
+    EXPECT_THROW(fan_out.run([](size_t, int &) {}), domain_error);
+    EXPECT_TRUE(*pending);
+}
+
+}
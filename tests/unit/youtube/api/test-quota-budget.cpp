@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/quota-budget.h>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace youtube::api;
+
+namespace {
+
+typedef QuotaBudget::Level Level;
+
+typedef Scheduler::Priority Priority;
+
+TEST(TestQuotaBudget, gets_more_careful_as_the_quota_runs_low) {
+    QuotaBudget budget(100);
+    budget.charge(69);
+    EXPECT_EQ(Level::normal, budget.level());
+    EXPECT_TRUE(budget.admit(Priority::background));
+
+    budget.charge(1);
+    EXPECT_EQ(Level::shed_background, budget.level());
+    EXPECT_FALSE(budget.admit(Priority::background));
+    EXPECT_TRUE(budget.admit(Priority::foreground));
+
+    budget.charge(15);
+    EXPECT_EQ(Level::cache_only, budget.level());
+    EXPECT_TRUE(budget.admit(Priority::interactive));
+
+    budget.charge(10);
+    EXPECT_EQ(Level::exhausted, budget.level());
+    EXPECT_FALSE(budget.admit(Priority::foreground));
+    EXPECT_FALSE(budget.admit(Priority::interactive));
+
+    EXPECT_EQ(95ul, budget.spent());
+    EXPECT_EQ(3ul, budget.stats().refused);
+}
+
+TEST(TestQuotaBudget, stops_once_youtube_says_the_quota_is_exceeded) {
+    QuotaBudget budget(10000);
+    budget.quota_exceeded();
+    EXPECT_EQ(Level::exhausted, budget.level());
+    EXPECT_FALSE(budget.admit(Priority::interactive));
+
+    // Raising the limit doesn't help until the quota resets
+    budget.set_daily_limit(1000000);
+    EXPECT_EQ(Level::exhausted, budget.level());
+    EXPECT_EQ(1ul, budget.stats().quota_exceeded);
+}
+
+TEST(TestQuotaBudget, a_zero_limit_is_never_restricted) {
+    QuotaBudget budget(0);
+    budget.charge(1000000);
+    EXPECT_EQ(Level::normal, budget.level());
+    EXPECT_TRUE(budget.admit(Priority::background));
+}
+
+TEST(TestQuotaBudget, charges_searches_and_writes_more) {
+    EXPECT_EQ(1u, QuotaBudget::cost("videos", false));
+    EXPECT_EQ(100u, QuotaBudget::cost("search", false));
+    EXPECT_EQ(50u, QuotaBudget::cost("subscriptions", true));
+}
+
+TEST(TestQuotaBudget, records_what_each_query_spent) {
+    QuotaBudget budget;
+    budget.record_query(3);
+    budget.record_query(101);
+    budget.record_query(2);
+
+    QuotaBudget::Stats stats = budget.stats();
+    EXPECT_EQ(3ul, stats.queries);
+    EXPECT_EQ(106ul, stats.query_units);
+    EXPECT_EQ(101ul, stats.peak_query_units);
+}
+
+}
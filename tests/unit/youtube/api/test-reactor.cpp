@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/reactor.h>
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+using namespace youtube::api;
+
+namespace {
+
+class TestReactor: public testing::Test {
+protected:
+    void SetUp() override {
+        reactor_.start();
+    }
+
+    /**
+     * Waits for a number of spawned tasks to finish.
+     */
+    void wait_for(unsigned long completed) {
+        auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+        while (reactor_.stats().completed < completed
+                && chrono::steady_clock::now() < deadline) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        ASSERT_EQ(completed, reactor_.stats().completed);
+    }
+
+    Reactor reactor_ { 2 };
+};
+
+TEST_F(TestReactor, runs_spawned_tasks_as_fibers) {
+    atomic<int> ran(0);
+    atomic<bool> in_task(false);
+    ASSERT_TRUE(reactor_.spawn([&ran, &in_task]() {
+        in_task = Reactor::in_task();
+        ++ran;
+    }));
+    wait_for(1);
+
+    EXPECT_EQ(1, ran);
+    EXPECT_TRUE(in_task);
+    EXPECT_FALSE(Reactor::in_task());
+    EXPECT_EQ(1ul, reactor_.stats().spawned);
+    EXPECT_EQ(0ul, reactor_.stats().active);
+}
+
+TEST_F(TestReactor, refuses_tasks_once_stopped) {
+    reactor_.stop();
+    EXPECT_FALSE(reactor_.spawn([]() {}));
+}
+
+TEST_F(TestReactor, resumes_a_suspended_task_when_notified) {
+    promise<int> answer;
+    future<int> answer_future = answer.get_future();
+    atomic<int> result(0);
+    ASSERT_TRUE(reactor_.spawn([&answer_future, &result]() {
+        if (Reactor::await(answer_future, chrono::seconds(5))
+                == future_status::ready) {
+            result = answer_future.get();
+        }
+    }));
+
+    // Other tasks carry on while the first one waits
+    atomic<bool> other(false);
+    reactor_.spawn([&other]() {other = true;});
+    wait_for(1);
+    EXPECT_TRUE(other);
+    EXPECT_EQ(1ul, reactor_.stats().active);
+
+    answer.set_value(42);
+    Reactor::notify_all();
+    wait_for(2);
+    EXPECT_EQ(42, result);
+}
+
+TEST_F(TestReactor, resumes_a_suspended_task_at_its_deadline) {
+    atomic<int> outcome(0);
+    auto started = chrono::steady_clock::now();
+    ASSERT_TRUE(reactor_.spawn([&outcome]() {
+        bool ready = Reactor::suspend([]() {return false;},
+                chrono::steady_clock::now() + chrono::milliseconds(50));
+        outcome = ready ? 1 : 2;
+    }));
+    wait_for(1);
+
+    EXPECT_EQ(2, outcome);
+    EXPECT_GE(chrono::steady_clock::now() - started, chrono::milliseconds(50));
+}
+
+TEST_F(TestReactor, stopping_wakes_suspended_tasks_with_an_error) {
+    atomic<bool> threw(false);
+    atomic<bool> suspended(false);
+    ASSERT_TRUE(reactor_.spawn([&threw, &suspended]() {
+        try {
+            suspended = true;
+            Reactor::suspend([]() {return false;},
+                    Reactor::TimePoint::max());
+        } catch (domain_error &e) {
+            threw = true;
+        }
+    }));
+    while (!suspended) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+
+    reactor_.stop();
+    EXPECT_TRUE(threw);
+    EXPECT_EQ(1ul, reactor_.stats().completed);
+}
+
+TEST_F(TestReactor, refuses_to_suspend_inside_a_catch_block) {
+    atomic<bool> refused(false);
+    ASSERT_TRUE(reactor_.spawn([&refused]() {
+        try {
+            throw runtime_error("failed");
+        } catch (runtime_error &e) {
+            try {
+                Reactor::suspend([]() {return true;},
+                        Reactor::TimePoint::max());
+            } catch (logic_error &e) {
+                refused = true;
+            }
+        }
+    }));
+    wait_for(1);
+
+    EXPECT_TRUE(refused);
+}
+
+TEST_F(TestReactor, suspend_outside_of_a_task_throws) {
+    EXPECT_THROW(Reactor::suspend([]() {return true;},
+            Reactor::TimePoint::max()), logic_error);
+}
+
+TEST_F(TestReactor, offloads_blocking_work_without_holding_up_other_tasks) {
+    promise<void> release;
+    shared_future<void> released = release.get_future().share();
+    atomic<int> result(0);
+    ASSERT_TRUE(reactor_.spawn([released, &result]() {
+        result = Reactor::offload<int>([released]() {
+            released.wait();
+            return 7;
+        });
+    }));
+
+    atomic<int> others(0);
+    for (int i = 0; i < 4; ++i) {
+        reactor_.spawn([&others]() {++others;});
+    }
+    wait_for(4);
+    EXPECT_EQ(4, others);
+
+    release.set_value();
+    wait_for(5);
+    EXPECT_EQ(7, result);
+}
+
+TEST_F(TestReactor, offload_passes_exceptions_back) {
+    atomic<bool> threw(false);
+    ASSERT_TRUE(reactor_.spawn([&threw]() {
+        try {
+            Reactor::offload<int>([]() -> int {
+                throw domain_error("no accounts");
+            });
+        } catch (domain_error &e) {
+            threw = true;
+        }
+    }));
+    wait_for(1);
+
+    EXPECT_TRUE(threw);
+}
+
+TEST_F(TestReactor, offloads_onto_a_bounded_set_of_threads) {
+    mutex threads_mutex;
+    set<thread::id> threads;
+    atomic<int> in_flight(0);
+    atomic<int> peak(0);
+    promise<void> release;
+    shared_future<void> released = release.get_future().share();
+    for (int i = 0; i < 5; ++i) {
+        reactor_.spawn([&threads_mutex, &threads, &in_flight, &peak, released]() {
+            Reactor::offload<int>([&threads_mutex, &threads, &in_flight, &peak, released]() {
+                {
+                    lock_guard<mutex> lock(threads_mutex);
+                    threads.insert(this_thread::get_id());
+                }
+                int now = ++in_flight;
+                int seen = peak;
+                while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+                }
+                released.wait();
+                --in_flight;
+                return 0;
+            });
+        });
+    }
+
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+    while (in_flight < 2 && chrono::steady_clock::now() < deadline) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    // Give the rest the chance to overtake the pool, if they could
+    this_thread::sleep_for(chrono::milliseconds(20));
+    EXPECT_EQ(2, in_flight);
+
+    release.set_value();
+    wait_for(5);
+    EXPECT_EQ(2, peak);
+    EXPECT_EQ(2u, threads.size());
+    EXPECT_EQ(5ul, reactor_.stats().offloaded);
+}
+
+TEST_F(TestReactor, stop_drops_offloaded_work_that_has_not_started) {
+    Reactor reactor(1, 512 * 1024, 1);
+    reactor.start();
+
+    promise<void> started;
+    promise<void> release;
+    shared_future<void> released = release.get_future().share();
+    atomic<bool> ran(false);
+    reactor.spawn([&started, released]() {
+        Reactor::offload<int>([&started, released]() {
+            started.set_value();
+            released.wait();
+            return 0;
+        });
+    });
+    started.get_future().wait();
+    reactor.spawn([&ran]() {
+        Reactor::offload<int>([&ran]() {
+            ran = true;
+            return 0;
+        });
+    });
+
+    // Stopping waits for the work under way
+    thread stopper([&reactor]() {reactor.stop();});
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+    while (reactor.spawn([]() {}) && chrono::steady_clock::now() < deadline) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    release.set_value();
+    stopper.join();
+
+    EXPECT_FALSE(ran);
+}
+
+TEST_F(TestReactor, spreads_tasks_over_its_threads) {
+    mutex threads_mutex;
+    set<thread::id> threads;
+    promise<void> release;
+    shared_future<void> released = release.get_future().share();
+    for (int i = 0; i < 2; ++i) {
+        reactor_.spawn([&threads_mutex, &threads, released]() {
+            {
+                lock_guard<mutex> lock(threads_mutex);
+                threads.insert(this_thread::get_id());
+            }
+            // Block the thread outright, as a slow push to the shell would
+            released.wait();
+        });
+    }
+
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+    while (chrono::steady_clock::now() < deadline) {
+        lock_guard<mutex> lock(threads_mutex);
+        if (threads.size() == 2) {
+            break;
+        }
+    }
+    release.set_value();
+    wait_for(2);
+
+    EXPECT_EQ(2u, threads.size());
+}
+
+}
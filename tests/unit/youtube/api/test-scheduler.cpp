@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/scheduler.h>
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace youtube::api;
+
+namespace {
+
+typedef Scheduler::Priority Priority;
+
+class TestScheduler: public testing::Test {
+protected:
+    /**
+     * A job that stays in flight until its finished function is called.
+     */
+    Scheduler::Job hold() {
+        return [this](const function<void()> &finished) {
+            held_.emplace_back(finished);
+        };
+    }
+
+    /**
+     * A job that notes its name and completes straight away.
+     */
+    Scheduler::Job note(const string &name) {
+        return [this, name](const function<void()> &finished) {
+            started_.emplace_back(name);
+            finished();
+        };
+    }
+
+    vector<function<void()>> held_;
+
+    vector<string> started_;
+
+    int owner_ = 0;
+
+    int other_owner_ = 0;
+};
+
+TEST_F(TestScheduler, starts_waiting_requests_in_priority_order) {
+    auto scheduler = make_shared<Scheduler>(Scheduler::Limits { 1, 0, 1 });
+    scheduler->submit(&owner_, Priority::foreground, hold());
+    scheduler->submit(&owner_, Priority::background, note("background"));
+    scheduler->submit(&owner_, Priority::foreground, note("foreground"));
+    scheduler->submit(&owner_, Priority::interactive, note("interactive"));
+    EXPECT_TRUE(started_.empty());
+    EXPECT_EQ(1u, scheduler->stats(Priority::foreground).queued);
+
+    ASSERT_EQ(1u, held_.size());
+    held_.front()();
+    EXPECT_EQ(vector<string>({"interactive", "foreground", "background"}),
+            started_);
+    EXPECT_EQ(0u, scheduler->in_flight());
+    EXPECT_EQ(2ul, scheduler->stats(Priority::foreground).started);
+}
+
+TEST_F(TestScheduler, keeps_slots_free_for_interactive_requests) {
+    auto scheduler = make_shared<Scheduler>(Scheduler::Limits { 3, 1, 3 });
+    for (int i = 0; i < 3; ++i) {
+        scheduler->submit(&owner_, Priority::foreground, hold());
+    }
+    EXPECT_EQ(2u, scheduler->in_flight());
+    EXPECT_EQ(1u, scheduler->stats(Priority::foreground).queued);
+
+    scheduler->submit(&owner_, Priority::interactive, note("interactive"));
+    EXPECT_EQ(vector<string>({"interactive"}), started_);
+    EXPECT_EQ(2u, scheduler->in_flight());
+}
+
+TEST_F(TestScheduler, caps_background_requests) {
+    auto scheduler = make_shared<Scheduler>(Scheduler::Limits { 10, 2, 2 });
+    for (int i = 0; i < 4; ++i) {
+        scheduler->submit(&owner_, Priority::background, hold());
+    }
+    EXPECT_EQ(2u, scheduler->in_flight());
+    EXPECT_EQ(2u, scheduler->stats(Priority::background).queued);
+    EXPECT_EQ(2u, scheduler->stats(Priority::background).peak_queued);
+
+    // Other requests still get through
+    scheduler->submit(&owner_, Priority::foreground, note("foreground"));
+    EXPECT_EQ(vector<string>({"foreground"}), started_);
+
+    // Finishing one lets the next background request out
+    held_.front()();
+    EXPECT_EQ(2u, scheduler->in_flight());
+    EXPECT_EQ(1u, scheduler->stats(Priority::background).queued);
+}
+
+TEST_F(TestScheduler, forget_drops_the_requests_of_an_owner) {
+    auto scheduler = make_shared<Scheduler>(Scheduler::Limits { 1, 0, 1 });
+    scheduler->submit(&owner_, Priority::foreground, hold());
+    scheduler->submit(&owner_, Priority::foreground, note("forgotten"));
+    scheduler->submit(&other_owner_, Priority::foreground, note("other"));
+
+    // The held slot is released, and only the other owner's request starts
+    scheduler->forget(&owner_);
+    EXPECT_EQ(vector<string>({"other"}), started_);
+    EXPECT_EQ(0u, scheduler->in_flight());
+
+    // Finishing after being forgotten doesn't release anyone else's slot
+    scheduler->submit(&other_owner_, Priority::foreground, hold());
+    ASSERT_EQ(2u, held_.size());
+    held_.front()();
+    EXPECT_EQ(1u, scheduler->in_flight());
+}
+
+TEST_F(TestScheduler, forget_waits_for_requests_being_started) {
+    auto scheduler = make_shared<Scheduler>();
+    promise<void> release;
+    shared_future<void> released = release.get_future().share();
+    atomic<bool> starting(false);
+    atomic<bool> started(false);
+
+    thread submitting([this, scheduler, released, &starting, &started]() {
+        scheduler->submit(&owner_, Priority::foreground,
+                [released, &starting, &started](const function<void()> &) {
+                    starting = true;
+                    released.wait();
+                    started = true;
+                });
+    });
+    while (!starting) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+
+    atomic<bool> forgotten(false);
+    atomic<bool> started_first(false);
+    thread forgetting([this, scheduler, &forgotten, &started, &started_first]() {
+        scheduler->forget(&owner_);
+        started_first = started.load();
+        forgotten = true;
+    });
+
+    this_thread::sleep_for(chrono::milliseconds(20));
+    EXPECT_FALSE(forgotten);
+
+    release.set_value();
+    submitting.join();
+    forgetting.join();
+    EXPECT_TRUE(forgotten);
+    EXPECT_TRUE(started_first);
+    EXPECT_EQ(0u, scheduler->in_flight());
+}
+
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <youtube/scope/browse-cache.h>
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace {
+
+typedef vector<string> List;
+
+class TestBrowseCache: public testing::Test {
+protected:
+    /**
+     * A fetch that counts how often it is called and returns the current
+     * contents of the list.
+     */
+    BrowseCache::Fetch<List> fetch(const List &list, int &calls) {
+        return [&list, &calls](Client &, const PartialReply::Ptr &) {
+            ++calls;
+            return list;
+        };
+    }
+
+    /**
+     * Waits for the background refreshes to get somewhere.
+     */
+    void wait_for_refreshes(BrowseCache &cache, BrowseCache::Type type,
+            unsigned long refreshes) {
+        for (int i = 0; i < 500; ++i) {
+            BrowseCache::Stats stats = cache.stats(type);
+            if (stats.refreshes + stats.failed_refreshes >= refreshes) {
+                return;
+            }
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+    }
+
+    Client client_ { nullptr };
+
+    PartialReply::Ptr partial_ = make_shared<PartialReply>();
+};
+
+TEST_F(TestBrowseCache, serves_fresh_entries_without_fetching) {
+    BrowseCache cache(nullptr);
+    List list { "a", "b" };
+    int calls = 0;
+
+    EXPECT_EQ(list, cache.get<List>(BrowseCache::Type::playlist, "|10|PL1",
+            client_, partial_, fetch(list, calls)));
+    EXPECT_EQ(list, cache.get<List>(BrowseCache::Type::playlist, "|10|PL1",
+            client_, partial_, fetch(list, calls)));
+
+    EXPECT_EQ(1, calls);
+    EXPECT_EQ(1ul, cache.stats(BrowseCache::Type::playlist).fresh);
+    EXPECT_EQ(1ul, cache.stats(BrowseCache::Type::playlist).misses);
+}
+
+TEST_F(TestBrowseCache, does_not_store_degraded_lists) {
+    BrowseCache cache(nullptr);
+    int calls = 0;
+    BrowseCache::Fetch<List> degraded = [&calls](Client &,
+            const PartialReply::Ptr &partial) {
+        ++calls;
+        partial->skip("UC1", "failed");
+        return List { "a" };
+    };
+
+    EXPECT_EQ(List { "a" }, cache.get<List>(
+            BrowseCache::Type::category_videos, "GC1", client_, partial_,
+            degraded));
+    EXPECT_EQ(List { "a" }, cache.get<List>(
+            BrowseCache::Type::category_videos, "GC1", client_, partial_,
+            degraded));
+
+    EXPECT_EQ(2, calls);
+    EXPECT_EQ(0ul, cache.size());
+    EXPECT_EQ(2ul, cache.stats(BrowseCache::Type::category_videos).degraded);
+    EXPECT_EQ(List({ "UC1", "UC1" }), partial_->skipped());
+}
+
+TEST_F(TestBrowseCache, drops_least_recently_used_entries) {
+    BrowseCache cache(nullptr, 2);
+    List list { "a" };
+    int calls = 0;
+
+    cache.get<List>(BrowseCache::Type::playlist, "PL1", client_, partial_,
+            fetch(list, calls));
+    cache.get<List>(BrowseCache::Type::playlist, "PL2", client_, partial_,
+            fetch(list, calls));
+    // Used again, so PL2 is the oldest
+    cache.get<List>(BrowseCache::Type::playlist, "PL1", client_, partial_,
+            fetch(list, calls));
+    cache.get<List>(BrowseCache::Type::playlist, "PL3", client_, partial_,
+            fetch(list, calls));
+    EXPECT_EQ(3, calls);
+    EXPECT_EQ(2ul, cache.size());
+
+    cache.get<List>(BrowseCache::Type::playlist, "PL1", client_, partial_,
+            fetch(list, calls));
+    EXPECT_EQ(3, calls);
+    cache.get<List>(BrowseCache::Type::playlist, "PL2", client_, partial_,
+            fetch(list, calls));
+    EXPECT_EQ(4, calls);
+}
+
+TEST_F(TestBrowseCache, reads_policies_from_configuration) {
+    BrowseCache cache(nullptr);
+    cache.configure("playlist=10:20,guideCategory-channels=30:40,bogus=1:2,"
+            "guideCategory-videos=50");
+
+    EXPECT_EQ(chrono::seconds(10), cache.policy(BrowseCache::Type::playlist).soft_ttl);
+    EXPECT_EQ(chrono::seconds(20), cache.policy(BrowseCache::Type::playlist).hard_ttl);
+    EXPECT_EQ(chrono::seconds(30),
+            cache.policy(BrowseCache::Type::category_channels).soft_ttl);
+    EXPECT_EQ(chrono::seconds(40),
+            cache.policy(BrowseCache::Type::category_channels).hard_ttl);
+    // Left alone
+    EXPECT_EQ(chrono::minutes(15),
+            cache.policy(BrowseCache::Type::category_videos).soft_ttl);
+}
+
+TEST_F(TestBrowseCache, serves_stale_entries_while_refreshing) {
+    // Outlives the cache, and so its refreshes
+    List list { "a" };
+    int calls = 0;
+    BrowseCache cache(nullptr);
+    cache.set_policy(BrowseCache::Type::playlist,
+            BrowseCache::Policy { chrono::seconds(0), chrono::hours(1) });
+
+    cache.get<List>(BrowseCache::Type::playlist, "PL1", client_, partial_,
+            fetch(list, calls));
+    list.emplace_back("b");
+    EXPECT_EQ(List { "a" }, cache.get<List>(BrowseCache::Type::playlist,
+            "PL1", client_, partial_, fetch(list, calls)));
+
+    wait_for_refreshes(cache, BrowseCache::Type::playlist, 1);
+    EXPECT_EQ(1ul, cache.stats(BrowseCache::Type::playlist).refreshes);
+    // Stale again straight away, but it is the refreshed list
+    EXPECT_EQ(list, cache.get<List>(BrowseCache::Type::playlist, "PL1",
+            client_, partial_, fetch(list, calls)));
+    EXPECT_EQ(2ul, cache.stats(BrowseCache::Type::playlist).stale);
+}
+
+TEST_F(TestBrowseCache, keeps_the_old_entry_when_a_refresh_is_degraded) {
+    bool fail = false;
+    BrowseCache::Fetch<List> fetch = [&fail](Client &,
+            const PartialReply::Ptr &partial) {
+        if (fail) {
+            partial->skip("UC1", "failed");
+            return List { "b" };
+        }
+        return List { "a" };
+    };
+    BrowseCache cache(nullptr);
+    cache.set_policy(BrowseCache::Type::category_videos,
+            BrowseCache::Policy { chrono::seconds(0), chrono::hours(1) });
+
+    cache.get<List>(BrowseCache::Type::category_videos, "GC1", client_,
+            partial_, fetch);
+    fail = true;
+    cache.get<List>(BrowseCache::Type::category_videos, "GC1", client_,
+            partial_, fetch);
+
+    wait_for_refreshes(cache, BrowseCache::Type::category_videos, 1);
+    EXPECT_EQ(1ul, cache.stats(BrowseCache::Type::category_videos).failed_refreshes);
+    EXPECT_EQ(List { "a" }, cache.get<List>(
+            BrowseCache::Type::category_videos, "GC1", client_, partial_,
+            fetch));
+    // Skipped by the refresh, not by any query
+    EXPECT_TRUE(partial_->skipped().empty());
+}
+
+TEST_F(TestBrowseCache, refetches_playlists_the_account_changed) {
+    BrowseCache cache(nullptr);
+    List watch_later { "a" };
+    List other { "x" };
+    int calls = 0;
+    int other_calls = 0;
+
+    cache.get<List>(BrowseCache::Type::playlist, "7|10|WL", client_,
+            partial_, fetch(watch_later, calls));
+    cache.get<List>(BrowseCache::Type::playlist, "8|10|WL", client_,
+            partial_, fetch(other, other_calls));
+
+    // Added to Watch Later
+    watch_later.emplace_back("b");
+    cache.invalidate(BrowseCache::Type::playlist, "7");
+
+    EXPECT_EQ(watch_later, cache.get<List>(BrowseCache::Type::playlist,
+            "7|10|WL", client_, partial_, fetch(watch_later, calls)));
+    EXPECT_EQ(2, calls);
+
+    // Other accounts keep theirs
+    cache.get<List>(BrowseCache::Type::playlist, "8|10|WL", client_,
+            partial_, fetch(other, other_calls));
+    EXPECT_EQ(1, other_calls);
+}
+
+TEST_F(TestBrowseCache, fetches_past_the_hard_ttl) {
+    BrowseCache cache(nullptr);
+    cache.set_policy(BrowseCache::Type::playlist,
+            BrowseCache::Policy { chrono::seconds(0), chrono::seconds(0) });
+    List list { "a" };
+    int calls = 0;
+
+    cache.get<List>(BrowseCache::Type::playlist, "PL1", client_, partial_,
+            fetch(list, calls));
+    list.emplace_back("b");
+    EXPECT_EQ(list, cache.get<List>(BrowseCache::Type::playlist, "PL1",
+            client_, partial_, fetch(list, calls)));
+    EXPECT_EQ(2, calls);
+}
+
+}
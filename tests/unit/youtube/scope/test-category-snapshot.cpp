@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <youtube/api/not-found.h>
+#include <youtube/api/quota-budget.h>
+#include <youtube/scope/category-snapshot.h>
+
+#include <gtest/gtest.h>
+#include <json/json.h>
+#include <future>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace {
+
+/**
+ * Serves a category's channels and their playlists from memory. Playlists
+ * it doesn't know fail with the error given for them.
+ */
+class FakeClient: public Client {
+public:
+    FakeClient() :
+            Client(nullptr) {
+    }
+
+    Ptr abortable(const Abort &) override {
+        return Ptr(this, [](Client *) {});
+    }
+
+    future<ChannelList> category_channels(const string &,
+            unsigned int) override {
+        promise<ChannelList> result;
+        result.set_value(channels);
+        return result.get_future();
+    }
+
+    future<PlaylistItemList> playlist_items(const string &playlist_id,
+            unsigned int) override {
+        promise<PlaylistItemList> result;
+        if (errors.count(playlist_id) > 0) {
+            result.set_exception(errors[playlist_id]);
+        } else {
+            result.set_value(playlists[playlist_id]);
+        }
+        return result.get_future();
+    }
+
+    ChannelList channels;
+
+    map<string, PlaylistItemList> playlists;
+
+    map<string, exception_ptr> errors;
+};
+
+class TestCategorySnapshot: public testing::Test {
+protected:
+    void SetUp() override {
+        QuotaBudget::reset_instance();
+        featured_playlists_ = make_shared<FeaturedPlaylistCache>(nullptr);
+        // Stopped, so nothing is revalidated over the network
+        featured_playlists_->stop();
+    }
+
+    /**
+     * Adds a channel whose featured playlist is already known.
+     */
+    void add_channel(const string &channel_id, const string &playlist_id) {
+        Json::Value data;
+        data["kind"] = "youtube#channel";
+        data["id"] = channel_id;
+        data["snippet"]["title"] = channel_id;
+        data["statistics"]["viewCount"] = "0";
+        data["statistics"]["subscriberCount"] = "0";
+        data["statistics"]["videoCount"] = "0";
+        client_.channels.emplace_back(make_shared<Channel>(data));
+        featured_playlists_->put(channel_id, playlist_id);
+    }
+
+    static PlaylistItem::Ptr item(const string &video_id) {
+        Json::Value data;
+        data["kind"] = "youtube#playlistItem";
+        data["id"] = video_id;
+        data["snippet"]["title"] = video_id;
+        data["contentDetails"]["videoId"] = video_id;
+        return make_shared<PlaylistItem>(data);
+    }
+
+    FakeClient client_;
+
+    FeaturedPlaylistCache::Ptr featured_playlists_;
+};
+
+TEST_F(TestCategorySnapshot, forgets_playlists_that_are_gone) {
+    add_channel("UCa", "PLa");
+    add_channel("UCb", "PLb");
+    client_.playlists["PLb"] = { item("v1") };
+    client_.errors["PLa"] = make_exception_ptr(NotFound("Playlist not found"));
+
+    auto snapshot = CategorySnapshot::fetch(client_, "GCa",
+            featured_playlists_);
+    ASSERT_EQ(1ul, snapshot->sections.size());
+    EXPECT_EQ(vector<string>({ "UCa" }), snapshot->skipped);
+
+    string playlist_id;
+    EXPECT_FALSE(featured_playlists_->get("UCa", playlist_id));
+    EXPECT_TRUE(featured_playlists_->get("UCb", playlist_id));
+}
+
+TEST_F(TestCategorySnapshot, keeps_playlists_through_transient_failures) {
+    add_channel("UCa", "PLa");
+    add_channel("UCb", "PLb");
+    add_channel("UCc", "PLc");
+    client_.playlists["PLc"] = { item("v1") };
+    client_.errors["PLa"] = make_exception_ptr(
+            domain_error("HTTP request timeout"));
+    client_.errors["PLb"] = make_exception_ptr(
+            domain_error("YouTube playlistItems unavailable"));
+
+    auto snapshot = CategorySnapshot::fetch(client_, "GCa",
+            featured_playlists_);
+    EXPECT_EQ(vector<string>({ "UCa", "UCb" }), snapshot->skipped);
+
+    string playlist_id;
+    EXPECT_TRUE(featured_playlists_->get("UCa", playlist_id));
+    EXPECT_EQ("PLa", playlist_id);
+    EXPECT_TRUE(featured_playlists_->get("UCb", playlist_id));
+    EXPECT_EQ("PLb", playlist_id);
+}
+
+}
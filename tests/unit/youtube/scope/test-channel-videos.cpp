@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <youtube/api/circuit-breaker.h>
+#include <youtube/api/not-found.h>
+#include <youtube/api/quota-budget.h>
+#include <youtube/scope/channel-videos.h>
+
+#include <boost/algorithm/string.hpp>
+#include <gtest/gtest.h>
+#include <json/json.h>
+#include <future>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace {
+
+/**
+ * Serves uploads, view counts and searches from memory, counting the
+ * searches made. Requests it has an error for fail with it.
+ */
+class FakeClient: public Client {
+public:
+    FakeClient() :
+            Client(nullptr) {
+    }
+
+    Ptr abortable(const Abort &) override {
+        return Ptr(this, [](Client *) {});
+    }
+
+    future<PlaylistItemList> playlist_items(const string &playlist_id,
+            unsigned int) override {
+        promise<PlaylistItemList> result;
+        if (errors.count(playlist_id) > 0) {
+            result.set_exception(errors[playlist_id]);
+        } else if (uploads.count(playlist_id) == 0) {
+            result.set_exception(make_exception_ptr(
+                    NotFound("Playlist not found")));
+        } else {
+            result.set_value(uploads[playlist_id]);
+        }
+        return result.get_future();
+    }
+
+    future<VideoList> videos(const string &video_ids) override {
+        promise<VideoList> result;
+        if (errors.count(video_ids) > 0) {
+            result.set_exception(errors[video_ids]);
+            return result.get_future();
+        }
+        vector<string> ids;
+        boost::split(ids, video_ids, boost::is_any_of(","));
+        VideoList found;
+        for (const string &id : ids) {
+            if (statistics.count(id) > 0) {
+                found.emplace_back(statistics[id]);
+            }
+        }
+        result.set_value(found);
+        return result.get_future();
+    }
+
+    future<VideoList> channel_videos(const string &channel_id,
+            unsigned int) override {
+        ++searches[channel_id];
+        promise<VideoList> result;
+        result.set_value(searched[channel_id]);
+        return result.get_future();
+    }
+
+    map<string, PlaylistItemList> uploads;
+
+    map<string, Video::Ptr> statistics;
+
+    map<string, VideoList> searched;
+
+    map<string, exception_ptr> errors;
+
+    map<string, int> searches;
+};
+
+class TestChannelVideos: public testing::Test {
+protected:
+    void SetUp() override {
+        CircuitBreaker::reset_instance();
+        QuotaBudget::reset_instance();
+        partial_ = make_shared<PartialReply>();
+    }
+
+    /**
+     * A standard channel id, so its uploads playlist is derived.
+     */
+    static string channel_id(char c) {
+        return "UC" + string(22, c);
+    }
+
+    static string uploads_playlist(char c) {
+        return "UU" + string(22, c);
+    }
+
+    /**
+     * Adds an upload to the channel, and its view count.
+     */
+    void add_upload(char c, const string &video_id, long view_count) {
+        Json::Value item;
+        item["kind"] = "youtube#playlistItem";
+        item["id"] = video_id;
+        item["contentDetails"]["videoId"] = video_id;
+        client_.uploads[uploads_playlist(c)].emplace_back(
+                make_shared<PlaylistItem>(item));
+        client_.statistics[video_id] = video(video_id, view_count);
+    }
+
+    static Video::Ptr video(const string &video_id, long view_count) {
+        Json::Value data;
+        data["kind"] = "youtube#video";
+        data["id"] = video_id;
+        data["snippet"]["title"] = video_id;
+        data["statistics"]["commentCount"] = "0";
+        data["statistics"]["dislikeCount"] = "0";
+        data["statistics"]["favoriteCount"] = "0";
+        data["statistics"]["likeCount"] = "0";
+        data["statistics"]["viewCount"] = to_string(view_count);
+        return make_shared<Video>(data);
+    }
+
+    static vector<string> ids(const Client::VideoList &videos) {
+        vector<string> result;
+        for (const Video::Ptr &video : videos) {
+            result.emplace_back(video->id());
+        }
+        return result;
+    }
+
+    FakeClient client_;
+
+    PartialReply::Ptr partial_;
+};
+
+TEST_F(TestChannelVideos, orders_uploads_by_view_count) {
+    add_upload('a', "v1", 10);
+    add_upload('a', "v2", 300);
+    add_upload('a', "v3", 20);
+    add_upload('b', "v4", 5);
+
+    auto result = ChannelVideos::fetch(client_,
+            { channel_id('a'), channel_id('b') },
+            ChannelVideos::Strategy::uploads, 2, partial_);
+    ASSERT_EQ(2ul, result.size());
+    EXPECT_EQ(vector<string>({ "v2", "v3" }), ids(result[0]));
+    EXPECT_EQ(vector<string>({ "v4" }), ids(result[1]));
+    EXPECT_TRUE(partial_->skipped().empty());
+    EXPECT_TRUE(client_.searches.empty());
+}
+
+TEST_F(TestChannelVideos, searches_channels_without_uploads) {
+    add_upload('a', "v1", 10);
+    client_.searched[channel_id('b')] = { video("v2", 50) };
+
+    auto result = ChannelVideos::fetch(client_,
+            { channel_id('a'), channel_id('b'), "legacy" },
+            ChannelVideos::Strategy::uploads, 5, partial_);
+    EXPECT_EQ(vector<string>({ "v1" }), ids(result[0]));
+    EXPECT_EQ(vector<string>({ "v2" }), ids(result[1]));
+    EXPECT_EQ(1, client_.searches[channel_id('b')]);
+    // Its uploads playlist can't be derived
+    EXPECT_EQ(1, client_.searches["legacy"]);
+    EXPECT_TRUE(partial_->skipped().empty());
+}
+
+TEST_F(TestChannelVideos, skips_the_search_when_quota_is_short) {
+    QuotaBudget::instance()->quota_exceeded();
+
+    auto result = ChannelVideos::fetch(client_, { channel_id('a') },
+            ChannelVideos::Strategy::uploads, 5, partial_);
+    EXPECT_TRUE(result[0].empty());
+    EXPECT_TRUE(client_.searches.empty());
+    EXPECT_EQ(vector<string>({ channel_id('a') }), partial_->skipped());
+}
+
+TEST_F(TestChannelVideos, skips_the_search_while_search_is_failing) {
+    for (int i = 0; i < 10; ++i) {
+        CircuitBreaker::instance()->record("search", false);
+    }
+    ASSERT_EQ(CircuitBreaker::State::open,
+            CircuitBreaker::instance()->state("search"));
+
+    auto result = ChannelVideos::fetch(client_, { channel_id('a') },
+            ChannelVideos::Strategy::uploads, 5, partial_);
+    EXPECT_TRUE(result[0].empty());
+    EXPECT_TRUE(client_.searches.empty());
+    EXPECT_EQ(vector<string>({ channel_id('a') }), partial_->skipped());
+}
+
+TEST_F(TestChannelVideos, records_channels_whose_lookups_failed) {
+    add_upload('a', "v1", 10);
+    add_upload('b', "v2", 20);
+    add_upload('c', "v3", 30);
+    client_.errors[uploads_playlist('a')] = make_exception_ptr(
+            domain_error("HTTP request timeout"));
+    // b and c share a batch of statistics
+    client_.errors["v2,v3"] = make_exception_ptr(
+            domain_error("YouTube videos unavailable"));
+
+    auto result = ChannelVideos::fetch(client_,
+            { channel_id('a'), channel_id('b'), channel_id('c') },
+            ChannelVideos::Strategy::uploads, 5, partial_);
+    for (const Client::VideoList &videos : result) {
+        EXPECT_TRUE(videos.empty());
+    }
+    // None of them is worth a search
+    EXPECT_TRUE(client_.searches.empty());
+    EXPECT_EQ(vector<string>({ channel_id('a'), channel_id('b'),
+            channel_id('c') }), partial_->skipped());
+}
+
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/quota-budget.h>
+#include <youtube/scope/chart-cache.h>
+
+#include <gtest/gtest.h>
+#include <json/json.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace {
+
+class TestChartCache: public testing::Test {
+protected:
+    void SetUp() override {
+        QuotaBudget::reset_instance();
+    }
+
+    static ChartCache::Key key(const string &country_code) {
+        return ChartCache::Key { "mostPopular", country_code, "", 0 };
+    }
+
+    static Client::VideoList videos(const string &id) {
+        Json::Value data;
+        data["kind"] = "youtube#video";
+        data["id"] = id;
+        return Client::VideoList { make_shared<Video>(data) };
+    }
+};
+
+TEST_F(TestChartCache, shares_a_chart_between_queries_for_the_same_region) {
+    ChartCache cache(nullptr);
+    EXPECT_FALSE(cache.get(key("GB")));
+
+    cache.put(key("GB"), videos("a"));
+    auto chart = cache.get(key("GB"));
+    ASSERT_TRUE(bool(chart));
+    ASSERT_EQ(1u, chart->size());
+    EXPECT_EQ("a", chart->front()->id());
+    EXPECT_FALSE(cache.get(key("US")));
+    EXPECT_FALSE(cache.get(ChartCache::Key { "mostPopular", "GB", "10", 0 }));
+
+    EXPECT_EQ(1ul, cache.stats().hits);
+    EXPECT_EQ(3ul, cache.stats().misses);
+}
+
+TEST_F(TestChartCache, stops_serving_a_chart_past_its_maximum_age) {
+    ChartCache cache(nullptr, chrono::minutes(20), chrono::minutes(4),
+            chrono::seconds(0));
+    cache.put(key("GB"), videos("a"));
+    this_thread::sleep_for(chrono::milliseconds(2));
+    EXPECT_FALSE(cache.get(key("GB")));
+
+    // Unless the quota has run out, when an old chart beats none
+    QuotaBudget::instance()->quota_exceeded();
+    EXPECT_TRUE(bool(cache.get(key("GB"))));
+}
+
+}
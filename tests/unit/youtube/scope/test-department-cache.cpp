@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/scope/department-cache.h>
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <string>
+
+using namespace std;
+using namespace youtube::scope;
+
+namespace {
+
+DepartmentCache::Entry::SCPtr entry(const string &home_category) {
+    auto entry = make_shared<DepartmentCache::Entry>();
+    entry->home_category = home_category;
+    return entry;
+}
+
+TEST(TestDepartmentCache, keys_on_locale_country_and_account) {
+    DepartmentCache cache;
+    auto british = entry("10");
+    cache.put(DepartmentCache::make_key("en_GB", "GB", "1"), "1", british);
+
+    EXPECT_EQ(british, cache.get(DepartmentCache::make_key("en_GB", "GB", "1")));
+    EXPECT_FALSE(cache.get(DepartmentCache::make_key("en_US", "GB", "1")));
+    EXPECT_FALSE(cache.get(DepartmentCache::make_key("en_GB", "US", "1")));
+    EXPECT_FALSE(cache.get(DepartmentCache::make_key("en_GB", "GB", "2")));
+}
+
+TEST(TestDepartmentCache, expires_entries_after_the_ttl) {
+    DepartmentCache cache(chrono::seconds(0));
+    cache.put(DepartmentCache::make_key("en_GB", "GB", "1"), "1", entry("10"));
+    EXPECT_FALSE(cache.get(DepartmentCache::make_key("en_GB", "GB", "1")));
+}
+
+TEST(TestDepartmentCache, invalidates_only_the_entries_of_an_account) {
+    DepartmentCache cache;
+    cache.put(DepartmentCache::make_key("en_GB", "GB", "1"), "1", entry("10"));
+    cache.put(DepartmentCache::make_key("en_US", "US", "1"), "1", entry("10"));
+    cache.put(DepartmentCache::make_key("en_GB", "GB", "2"), "2", entry("10"));
+
+    cache.invalidate("1");
+    EXPECT_FALSE(cache.get(DepartmentCache::make_key("en_GB", "GB", "1")));
+    EXPECT_FALSE(cache.get(DepartmentCache::make_key("en_US", "US", "1")));
+    EXPECT_TRUE(cache.get(DepartmentCache::make_key("en_GB", "GB", "2")));
+
+    cache.clear();
+    EXPECT_FALSE(cache.get(DepartmentCache::make_key("en_GB", "GB", "2")));
+}
+
+}
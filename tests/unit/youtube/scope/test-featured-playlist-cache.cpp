@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/quota-budget.h>
+#include <youtube/scope/featured-playlist-cache.h>
+
+#include <gtest/gtest.h>
+#include <json/json.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace {
+
+class TestFeaturedPlaylistCache: public testing::Test {
+protected:
+    void SetUp() override {
+        QuotaBudget::reset_instance();
+
+        char directory[] = "/tmp/youtube-featured-playlists-XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(directory));
+        directory_ = directory;
+        path_ = directory_ + "/featured-playlists";
+    }
+
+    void TearDown() override {
+        remove(path_.c_str());
+        rmdir(directory_.c_str());
+    }
+
+    static ChannelSection::Ptr section(const string &playlist_id) {
+        Json::Value data;
+        data["kind"] = "youtube#channelSection";
+        data["id"] = "section";
+        if (!playlist_id.empty()) {
+            data["contentDetails"]["playlists"].append(playlist_id);
+        }
+        return make_shared<ChannelSection>(data);
+    }
+
+    string directory_;
+
+    string path_;
+};
+
+TEST_F(TestFeaturedPlaylistCache, keeps_playlists_between_runs) {
+    {
+        FeaturedPlaylistCache cache(nullptr, path_);
+        cache.load();
+        cache.put("UCa", "PLa");
+        // A channel without a playlist is worth remembering too
+        cache.put("UCb", "");
+        cache.save();
+    }
+
+    FeaturedPlaylistCache cache(nullptr, path_);
+    cache.load();
+    string playlist_id;
+    EXPECT_TRUE(cache.get("UCa", playlist_id));
+    EXPECT_EQ("PLa", playlist_id);
+    EXPECT_TRUE(cache.get("UCb", playlist_id));
+    EXPECT_EQ("", playlist_id);
+    EXPECT_FALSE(cache.get("UCc", playlist_id));
+
+    EXPECT_EQ(2ul, cache.stats().fresh);
+    EXPECT_EQ(1ul, cache.stats().misses);
+}
+
+TEST_F(TestFeaturedPlaylistCache, still_serves_stale_entries) {
+    FeaturedPlaylistCache cache(nullptr, "", chrono::seconds(0));
+    // Stopped, so nothing is revalidated over the network
+    cache.stop();
+    cache.put("UCa", "PLa");
+
+    string playlist_id;
+    EXPECT_TRUE(cache.get("UCa", playlist_id));
+    EXPECT_EQ("PLa", playlist_id);
+    EXPECT_EQ(1ul, cache.stats().stale);
+    EXPECT_EQ(0ul, cache.stats().revalidations);
+
+    cache.invalidate("UCa");
+    EXPECT_FALSE(cache.get("UCa", playlist_id));
+}
+
+TEST_F(TestFeaturedPlaylistCache, features_the_first_section_with_a_playlist) {
+    EXPECT_EQ("PLb", FeaturedPlaylistCache::featured_playlist(
+            Client::ChannelSectionList { section(""), section("PLb"),
+                    section("PLc") }));
+    EXPECT_EQ("", FeaturedPlaylistCache::featured_playlist(
+            Client::ChannelSectionList { section("") }));
+}
+
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/quota-budget.h>
+#include <youtube/scope/home-refresher.h>
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace {
+
+class TestHomeRefresher: public testing::Test {
+protected:
+    void SetUp() override {
+        QuotaBudget::reset_instance();
+    }
+
+    void TearDown() override {
+        QuotaBudget::reset_instance();
+    }
+
+    static CategorySnapshot::SCPtr snapshot(const string &category_id) {
+        auto snapshot = make_shared<CategorySnapshot>();
+        snapshot->category_id = category_id;
+        return snapshot;
+    }
+};
+
+TEST_F(TestHomeRefresher, serves_the_snapshot_of_the_same_surface) {
+    HomeRefresher refresher(nullptr, nullptr);
+    EXPECT_FALSE(refresher.snapshot("en_US", "US", "GCTXVzaWM"));
+
+    auto music = snapshot("GCTXVzaWM");
+    refresher.update("en_US", "US", music);
+    EXPECT_EQ(music, refresher.snapshot("en_US", "US", "GCTXVzaWM"));
+    EXPECT_FALSE(refresher.snapshot("en_GB", "GB", "GCTXVzaWM"));
+    EXPECT_FALSE(refresher.snapshot("en_US", "US", "GCU3BvcnRz"));
+}
+
+TEST_F(TestHomeRefresher, never_stores_a_snapshot_missing_channels) {
+    HomeRefresher refresher(nullptr, nullptr);
+    auto degraded = make_shared<CategorySnapshot>();
+    degraded->category_id = "GCTXVzaWM";
+    degraded->skipped.emplace_back("UCa");
+    refresher.update("en_US", "US", degraded);
+    EXPECT_FALSE(refresher.snapshot("en_US", "US", "GCTXVzaWM"));
+
+    // Nor does one replace a complete snapshot
+    auto music = snapshot("GCTXVzaWM");
+    refresher.update("en_US", "US", music);
+    refresher.update("en_US", "US", degraded);
+    EXPECT_EQ(music, refresher.snapshot("en_US", "US", "GCTXVzaWM"));
+}
+
+TEST_F(TestHomeRefresher, stops_serving_a_snapshot_past_its_max_age) {
+    HomeRefresher refresher(nullptr, nullptr, chrono::minutes(15),
+            chrono::minutes(3), chrono::seconds(0));
+    refresher.update("en_US", "US", snapshot("GCTXVzaWM"));
+    this_thread::sleep_for(chrono::milliseconds(1));
+
+    EXPECT_FALSE(refresher.snapshot("en_US", "US", "GCTXVzaWM"));
+}
+
+TEST_F(TestHomeRefresher, serves_an_old_snapshot_once_the_quota_is_gone) {
+    HomeRefresher refresher(nullptr, nullptr, chrono::minutes(15),
+            chrono::minutes(3), chrono::seconds(0));
+    auto music = snapshot("GCTXVzaWM");
+    refresher.update("en_US", "US", music);
+    this_thread::sleep_for(chrono::milliseconds(1));
+
+    QuotaBudget::instance()->quota_exceeded();
+    EXPECT_EQ(music, refresher.snapshot("en_US", "US", "GCTXVzaWM"));
+}
+
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/scope/offline-index.h>
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace youtube::scope;
+
+namespace {
+
+class TestOfflineIndex: public testing::Test {
+protected:
+    void SetUp() override {
+        char directory[] = "/tmp/youtube-offline-index-XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(directory));
+        directory_ = directory;
+    }
+
+    void TearDown() override {
+        remove((directory_ + "/offline-index").c_str());
+        remove((directory_ + "/offline-index.journal").c_str());
+        remove((directory_ + "/offline-index.tmp").c_str());
+        rmdir(directory_.c_str());
+    }
+
+    static OfflineIndex::Document document(const string &id,
+            const string &title, int64_t last_seen = 1000,
+            const string &description = string()) {
+        OfflineIndex::Document document;
+        document.id = id;
+        document.kind = "youtube#video";
+        document.uri = id;
+        document.title = title;
+        document.description = description;
+        document.last_seen = last_seen;
+        return document;
+    }
+
+    static vector<string> ids(const vector<OfflineIndex::Document> &documents) {
+        vector<string> ids;
+        for (const auto &document : documents) {
+            ids.emplace_back(document.id);
+        }
+        return ids;
+    }
+
+    off_t file_size(const string &name) {
+        struct stat st;
+        if (stat((directory_ + "/" + name).c_str(), &st) != 0) {
+            return -1;
+        }
+        return st.st_size;
+    }
+
+    string directory_;
+};
+
+TEST_F(TestOfflineIndex, ranks_matches_of_more_terms_first) {
+    OfflineIndex index(directory_);
+    index.load();
+    index.add(document("a", "cats", 3000, "playing piano"));
+    index.add(document("b", "cats playing piano", 1000));
+    index.add(document("c", "dogs", 2000, "cats"));
+    index.add(document("d", "birds", 4000));
+
+    // Every term beats a title match, and a title beats a description
+    EXPECT_EQ(vector<string>({"b", "a", "c"}), ids(index.search("cats piano", 10)));
+    EXPECT_EQ(vector<string>({"a", "b", "c"}), ids(index.search("cats", 10)));
+
+    // The last term is a prefix, as it may still be being typed
+    EXPECT_EQ(vector<string>({"b", "a", "c"}), ids(index.search("cats pia", 10)));
+    EXPECT_EQ(vector<string>({"b"}), ids(index.search("cats piano", 1)));
+}
+
+TEST_F(TestOfflineIndex, ranks_the_same_after_compaction) {
+    OfflineIndex index(directory_);
+    index.load();
+    index.add(document("a", "cats", 3000, "playing piano"));
+    index.add(document("b", "cats playing piano", 1000));
+    index.add(document("c", "dogs", 2000, "cats"));
+    index.compact();
+    EXPECT_EQ(0, file_size("offline-index.journal"));
+
+    OfflineIndex reloaded(directory_);
+    reloaded.load();
+    EXPECT_EQ(3u, reloaded.size());
+    EXPECT_EQ(vector<string>({"b", "a", "c"}), ids(reloaded.search("cats piano", 10)));
+
+    // A newer copy in the journal replaces the one in the main file
+    reloaded.add(document("c", "lions", 5000));
+    EXPECT_EQ(vector<string>({"a", "b"}), ids(reloaded.search("cats", 10)));
+    EXPECT_EQ(vector<string>({"c"}), ids(reloaded.search("lions", 10)));
+}
+
+TEST_F(TestOfflineIndex, replays_a_torn_journal_up_to_the_tear) {
+    {
+        OfflineIndex index(directory_);
+        index.load();
+        index.add(document("a", "first"));
+        index.add(document("b", "second"));
+        index.add(document("c", "third"));
+        index.flush();
+    }
+
+    // As if we crashed part way through writing the last record
+    off_t size = file_size("offline-index.journal");
+    ASSERT_GT(size, 10);
+    ASSERT_EQ(0, truncate((directory_ + "/offline-index.journal").c_str(),
+            size - 10));
+
+    OfflineIndex index(directory_);
+    index.load();
+    EXPECT_EQ(2u, index.size());
+    EXPECT_EQ(vector<string>({"b"}), ids(index.search("second", 10)));
+    EXPECT_TRUE(index.search("third", 10).empty());
+}
+
+TEST_F(TestOfflineIndex, keeps_only_the_most_recently_seen_documents) {
+    OfflineIndex index(directory_, 10, 5);
+    index.load();
+    for (int i = 0; i < 30; ++i) {
+        index.add(document("video" + to_string(i), "video number", 1000 + i));
+    }
+    index.compact();
+
+    EXPECT_EQ(10u, index.size());
+    auto found = index.search("video", 100);
+    ASSERT_EQ(10u, found.size());
+    for (const auto &document : found) {
+        EXPECT_GE(document.last_seen, 1020);
+    }
+}
+
+TEST_F(TestOfflineIndex, compacts_in_the_background_once_started) {
+    OfflineIndex index(directory_, 100, 5);
+    index.load();
+    index.start();
+    for (int i = 0; i < 5; ++i) {
+        index.add(document("video" + to_string(i), "video number", 1000 + i));
+    }
+
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+    while (file_size("offline-index") <= 0
+            && chrono::steady_clock::now() < deadline) {
+        this_thread::sleep_for(chrono::milliseconds(5));
+    }
+    EXPECT_GT(file_size("offline-index"), 0);
+    EXPECT_EQ(5u, index.size());
+    EXPECT_EQ(5u, index.search("video", 10).size());
+
+    index.stop();
+}
+
+TEST_F(TestOfflineIndex, throws_away_an_index_from_an_older_version) {
+    {
+        OfflineIndex index(directory_);
+        index.load();
+        index.add(document("a", "first"));
+        index.flush();
+    }
+    {
+        // A version 1 header, which may hold private playlist items
+        ofstream out(directory_ + "/offline-index", ios::binary);
+        const char magic[8] = { 'Y', 'T', 'O', 'F', 'F', 'I', 'D', 'X' };
+        uint32_t header[6] = { 1, 0, 0, 0, 0, 0 };
+        out.write(magic, sizeof(magic));
+        out.write(reinterpret_cast<const char *>(header), sizeof(header));
+    }
+
+    OfflineIndex index(directory_);
+    index.load();
+    EXPECT_EQ(0u, index.size());
+    EXPECT_EQ(-1, file_size("offline-index"));
+    EXPECT_EQ(0, file_size("offline-index.journal"));
+}
+
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/scope/result-cache.h>
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace youtube::scope;
+
+namespace {
+
+class TestResultCache: public testing::Test {
+protected:
+    static string key(const string &uri, const string &account) {
+        return ResultCache::make_key(uri, "en_GB", "GB", 20, account);
+    }
+
+    ResultCache::Recording::SCPtr recording_ =
+            make_shared<ResultCache::Recording>();
+};
+
+TEST_F(TestResultCache, keys_on_everything_that_changes_the_reply) {
+    EXPECT_NE(key("scope://youtube", "1"), key("scope://youtube", "2"));
+    EXPECT_NE(ResultCache::make_key("scope://youtube", "en_GB", "GB", 20, "1"),
+            ResultCache::make_key("scope://youtube", "en_GB", "GB", 10, "1"));
+    EXPECT_NE(ResultCache::make_key("scope://youtube", "en_GB", "GB", 20, "1"),
+            ResultCache::make_key("scope://youtube", "en_GB", "GB", 20, "1",
+                    "channel videos"));
+
+    ResultCache cache;
+    cache.put(key("scope://youtube", "1"), "1", recording_);
+    EXPECT_EQ(recording_, cache.get(key("scope://youtube", "1")));
+    EXPECT_FALSE(cache.get(key("scope://youtube", "2")));
+    EXPECT_EQ(1ul, cache.stats().hits);
+    EXPECT_EQ(1ul, cache.stats().misses);
+}
+
+TEST_F(TestResultCache, expires_entries_after_the_ttl) {
+    ResultCache cache(chrono::seconds(0));
+    cache.put(key("scope://youtube", "1"), "1", recording_);
+    this_thread::sleep_for(chrono::milliseconds(2));
+    EXPECT_FALSE(cache.get(key("scope://youtube", "1")));
+}
+
+TEST_F(TestResultCache, drops_the_least_recently_used_entry) {
+    ResultCache cache(chrono::minutes(5), 2);
+    cache.put(key("a", "1"), "1", recording_);
+    cache.put(key("b", "1"), "1", recording_);
+    EXPECT_TRUE(cache.get(key("a", "1")));
+
+    cache.put(key("c", "1"), "1", recording_);
+    EXPECT_TRUE(cache.get(key("a", "1")));
+    EXPECT_FALSE(cache.get(key("b", "1")));
+    EXPECT_TRUE(cache.get(key("c", "1")));
+}
+
+TEST_F(TestResultCache, invalidates_only_the_entries_of_an_account) {
+    ResultCache cache;
+    cache.put(key("a", "1"), "1", recording_);
+    cache.put(key("b", "1"), "1", recording_);
+    cache.put(key("a", "2"), "2", recording_);
+
+    cache.invalidate("1");
+    EXPECT_FALSE(cache.get(key("a", "1")));
+    EXPECT_FALSE(cache.get(key("b", "1")));
+    EXPECT_TRUE(cache.get(key("a", "2")));
+    EXPECT_EQ(2ul, cache.stats().invalidated);
+}
+
+}
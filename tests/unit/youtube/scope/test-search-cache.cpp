@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/api/quota-budget.h>
+#include <youtube/scope/search-cache.h>
+
+#include <gtest/gtest.h>
+#include <json/json.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace {
+
+class TestSearchCache: public testing::Test {
+protected:
+    void SetUp() override {
+        QuotaBudget::reset_instance();
+    }
+
+    static SearchCache::Key key(const string &query) {
+        return SearchCache::Key { query, "", 20, "GB" };
+    }
+
+    static SearchListResponse::Ptr response(const vector<string> &titles) {
+        Json::Value data;
+        data["pageInfo"]["totalResults"] = int(titles.size());
+        for (const string &title : titles) {
+            Json::Value item;
+            item["kind"] = "youtube#searchResult";
+            item["id"]["kind"] = "youtube#video";
+            item["id"]["videoId"] = title;
+            item["snippet"]["title"] = title;
+            data["items"].append(item);
+        }
+        return make_shared<SearchListResponse>(data);
+    }
+
+    static vector<string> titles(const SearchListResponse::ResourceList &items) {
+        vector<string> titles;
+        for (const Resource::Ptr &item : items) {
+            titles.emplace_back(item->title());
+        }
+        return titles;
+    }
+};
+
+TEST_F(TestSearchCache, normalizes_case_and_spaces) {
+    EXPECT_EQ("cute cats", SearchCache::normalize("  Cute   CATS "));
+
+    SearchCache cache;
+    auto cats = response({ "Cute cats" });
+    cache.put(key("cute cats"), cats);
+    EXPECT_EQ(cats, cache.get(key(" Cute  Cats")));
+    EXPECT_FALSE(cache.get(SearchCache::Key { "cute cats", "10", 20, "GB" }));
+
+    EXPECT_EQ(1ul, cache.stats().hits);
+    EXPECT_EQ(1ul, cache.stats().misses);
+}
+
+TEST_F(TestSearchCache, expires_entries_after_the_ttl) {
+    SearchCache cache(chrono::seconds(0));
+    cache.put(key("cats"), response({ "Cats" }));
+    this_thread::sleep_for(chrono::milliseconds(2));
+    EXPECT_FALSE(cache.get(key("cats")));
+}
+
+TEST_F(TestSearchCache, drops_the_least_recently_used_entry) {
+    SearchCache cache(chrono::minutes(10), 2);
+    cache.put(key("cats"), response({ "Cats" }));
+    cache.put(key("dogs"), response({ "Dogs" }));
+    EXPECT_TRUE(cache.get(key("cats")));
+
+    cache.put(key("birds"), response({ "Birds" }));
+    EXPECT_TRUE(cache.get(key("cats")));
+    EXPECT_FALSE(cache.get(key("dogs")));
+    EXPECT_TRUE(cache.get(key("birds")));
+}
+
+TEST_F(TestSearchCache, offers_matching_results_of_a_shorter_query) {
+    SearchCache cache;
+    cache.put(key("cat"), response({ "Cat videos", "Funny cats", "Cat piano" }));
+
+    EXPECT_EQ(vector<string>({ "Cat piano" }),
+            titles(cache.provisional(key("cat pia"))));
+    EXPECT_EQ(vector<string>({ "Funny cats" }),
+            titles(cache.provisional(key("cats"))));
+    EXPECT_TRUE(cache.provisional(key("dogs")).empty());
+    EXPECT_EQ(2ul, cache.stats().provisional);
+}
+
+TEST_F(TestSearchCache, a_newer_search_cancels_the_last_one_of_the_session) {
+    auto cache = make_shared<SearchCache>();
+    int cancelled = 0;
+    {
+        SearchCache::InFlight first(cache, "session", [&cancelled]() {
+            ++cancelled;
+        });
+        SearchCache::InFlight second(cache, "session", []() {});
+        second.completed();
+
+        // Other sessions are left alone
+        SearchCache::InFlight other(cache, "other", []() {});
+        other.completed();
+    }
+
+    EXPECT_EQ(1, cancelled);
+    EXPECT_EQ(1ul, cache->stats().superseded);
+    EXPECT_EQ(1ul, cache->stats().wasted_requests);
+}
+
+}
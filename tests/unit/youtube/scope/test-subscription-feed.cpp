@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/scope/subscription-feed.h>
+
+#include <gtest/gtest.h>
+#include <json/json.h>
+#include <chrono>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace youtube::api;
+using namespace youtube::scope;
+
+namespace {
+
+/**
+ * Serves uploads from memory, counting the playlists asked for.
+ */
+class FakeClient: public Client {
+public:
+    FakeClient() :
+            Client(nullptr) {
+    }
+
+    Ptr abortable(const Abort &) override {
+        return Ptr(this, [](Client *) {});
+    }
+
+    future<SubscriptionItemList> subscription_items(const string &playlist_id,
+            unsigned int) override {
+        ++requests[playlist_id];
+        promise<SubscriptionItemList> result;
+        result.set_value(uploads[playlist_id]);
+        return result.get_future();
+    }
+
+    map<string, SubscriptionItemList> uploads;
+
+    map<string, int> requests;
+};
+
+class TestSubscriptionFeed: public testing::Test {
+protected:
+    /**
+     * A standard channel id, so its uploads playlist is derived.
+     */
+    static string channel_id(char c) {
+        return "UC" + string(22, c);
+    }
+
+    static string uploads_playlist(char c) {
+        return "UU" + string(22, c);
+    }
+
+    static SubscriptionItem::Ptr upload(const string &video_id,
+            const string &published_at) {
+        Json::Value data;
+        data["kind"] = "youtube#playlistItem";
+        data["id"] = video_id;
+        data["snippet"]["title"] = video_id;
+        data["snippet"]["publishedAt"] = published_at;
+        data["snippet"]["resourceId"]["videoId"] = video_id;
+        return make_shared<SubscriptionItem>(data);
+    }
+
+    Client::SubscriptionList subscribe(const string &channels) {
+        Client::SubscriptionList subscriptions;
+        for (char c : channels) {
+            Json::Value data;
+            data["kind"] = "youtube#subscription";
+            data["snippet"]["title"] = string(1, c);
+            data["snippet"]["resourceId"]["channelId"] = channel_id(c);
+            subscriptions.emplace_back(make_shared<Subscription>(data));
+        }
+        return subscriptions;
+    }
+
+    static vector<string> ids(const Client::SubscriptionItemList &items) {
+        vector<string> ids;
+        for (const SubscriptionItem::Ptr &item : items) {
+            ids.emplace_back(item->video_id());
+        }
+        return ids;
+    }
+
+    void SetUp() override {
+        client_.uploads[uploads_playlist('a')] = {
+                upload("a1", "2014-07-01T10:00:00.000Z"),
+                upload("a2", "2014-07-03T10:00:00.000Z") };
+        client_.uploads[uploads_playlist('b')] = {
+                upload("b1", "2014-07-02T10:00:00.000Z") };
+        client_.uploads[uploads_playlist('c')] = {
+                upload("c1", "2014-07-04T10:00:00.000Z") };
+    }
+
+    FakeClient client_;
+};
+
+TEST_F(TestSubscriptionFeed, merges_the_uploads_newest_first) {
+    SubscriptionFeed feed;
+    EXPECT_EQ(vector<string>({"c1", "a2", "b1", "a1"}),
+            ids(feed.latest(client_, subscribe("abc"), 10)));
+    EXPECT_EQ(vector<string>({"c1", "a2"}),
+            ids(feed.latest(client_, subscribe("abc"), 2)));
+}
+
+TEST_F(TestSubscriptionFeed, only_fetches_channels_older_than_the_ttl) {
+    SubscriptionFeed feed;
+    feed.latest(client_, subscribe("ab"), 10);
+    feed.latest(client_, subscribe("abc"), 10);
+
+    EXPECT_EQ(1, client_.requests[uploads_playlist('a')]);
+    EXPECT_EQ(1, client_.requests[uploads_playlist('c')]);
+    EXPECT_EQ(3ul, feed.stats().channels_fetched);
+    EXPECT_EQ(2ul, feed.stats().channels_cached);
+
+    SubscriptionFeed expiring(nullptr, chrono::seconds(0));
+    expiring.latest(client_, subscribe("a"), 10);
+    this_thread::sleep_for(chrono::milliseconds(2));
+    expiring.latest(client_, subscribe("a"), 10);
+    EXPECT_EQ(3, client_.requests[uploads_playlist('a')]);
+}
+
+TEST_F(TestSubscriptionFeed, keeps_at_most_max_channels) {
+    SubscriptionFeed feed(nullptr, chrono::minutes(15), 6, 2);
+
+    // Everything just fetched still makes it into the feed
+    EXPECT_EQ(4u, feed.latest(client_, subscribe("abc"), 10).size());
+
+    // But one of them has to be fetched again next time
+    feed.latest(client_, subscribe("abc"), 10);
+    EXPECT_EQ(4ul, feed.stats().channels_fetched);
+}
+
+}
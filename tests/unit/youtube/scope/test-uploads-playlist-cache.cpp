@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2014 Canonical, Ltd.
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of version 3 of the GNU Lesser General Public License as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <youtube/scope/uploads-playlist-cache.h>
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace youtube::scope;
+
+namespace {
+
+class TestUploadsPlaylistCache: public testing::Test {
+protected:
+    void SetUp() override {
+        char directory[] = "/tmp/youtube-uploads-playlists-XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(directory));
+        directory_ = directory;
+        path_ = directory_ + "/uploads-playlists";
+    }
+
+    void TearDown() override {
+        remove(path_.c_str());
+        rmdir(directory_.c_str());
+    }
+
+    bool exists(const string &path) {
+        struct stat st;
+        return stat(path.c_str(), &st) == 0;
+    }
+
+    string directory_;
+
+    string path_;
+};
+
+TEST_F(TestUploadsPlaylistCache, keeps_playlists_between_runs) {
+    {
+        UploadsPlaylistCache cache(path_);
+        cache.load();
+        cache.put("UCa", "UUa");
+        cache.put("UCb", "PLb");
+        cache.save();
+    }
+
+    UploadsPlaylistCache cache(path_);
+    cache.load();
+    EXPECT_EQ(2u, cache.size());
+    EXPECT_EQ("UUa", cache.get("UCa"));
+    EXPECT_EQ("PLb", cache.get("UCb"));
+    EXPECT_EQ("", cache.get("UCc"));
+}
+
+TEST_F(TestUploadsPlaylistCache, only_writes_out_changes) {
+    UploadsPlaylistCache cache(path_);
+    cache.load();
+    cache.put("UCa", "");
+    cache.save();
+    EXPECT_FALSE(exists(path_));
+    EXPECT_EQ(0u, cache.size());
+
+    cache.put("UCa", "UUa");
+    cache.save();
+    EXPECT_TRUE(exists(path_));
+}
+
+}
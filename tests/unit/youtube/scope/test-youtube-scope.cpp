@@ -16,12 +16,20 @@
  * Author: Pete Woods <pete.woods@canonical.com>
  */
 
+#include <youtube/api/circuit-breaker.h>
+#include <youtube/api/failure-cache.h>
+#include <youtube/api/quota-budget.h>
+#include <youtube/api/scheduler.h>
 #include <youtube/scope/scope.h>
 
 #include <core/posix/exec.h>
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <unity/scopes/SearchReply.h>
 #include <unity/scopes/SearchReplyProxyFwd.h>
@@ -31,6 +39,8 @@
 #include <unity/scopes/testing/TypedScopeFixture.h>
 #include <unity/scopes/testing/ScopeMetadataBuilder.h>
 
+#include <unistd.h>
+
 using namespace std;
 using namespace testing;
 using namespace youtube::scope;
@@ -94,6 +104,12 @@ protected:
 
         setenv("YOUTUBE_SCOPE_IGNORE_ACCOUNTS", "true", true);
 
+        // Nothing one test spends or breaks may carry over to the next
+        youtube::api::CircuitBreaker::reset_instance();
+        youtube::api::FailureCache::reset_instance();
+        youtube::api::QuotaBudget::reset_instance();
+        youtube::api::Scheduler::reset_instance();
+
         // Do the parent SetUp
         TypedScopeFixture::set_scope_directory(TEST_SCOPE_DIRECTORY);
         TypedScopeFixtureScope::SetUp();
@@ -1027,17 +1043,8 @@ TEST_F(TestYoutubeScope, surface_music) {
 
     sc::CannedQuery query(SCOPE_NAME, "", "aggregated:musicaggregator"); // pick the music department
 
-    sc::Department::SPtr departments = sc::Department::create("", query,
-                "Best of YouTube");
-    add_department(departments, "GCRmVhdHVyZWQ", "Featured", query);
-    add_department(departments, "GCUGFpZCBDaGFubmVscw", "Paid Channels", query);
-    add_department(departments, "GCTXVzaWM", "Music", query);
-    add_department(departments, "GCQ29tZWR5", "Comedy", query);
-    departments->add_subdepartment(
-            sc::Department::create("aggregated:musicaggregator", query, " "));
-
-    EXPECT_CALL(reply, register_departments(IsDepartment(departments))).Times(
-            1);
+    // Aggregators get the chart without the department tree
+    EXPECT_CALL(reply, register_departments(_)).Times(0);
 
     expect_category(reply, renderer, "youtube", "YouTube");
 
@@ -1145,4 +1152,33 @@ TEST_F(TestYoutubeScope, search_music) {
     search_query->run(reply_proxy);
 }
 
+TEST_F(TestYoutubeScope, dump_stats_covers_every_cache) {
+    ostringstream out;
+    scope->dump_stats(out);
+    string stats = out.str();
+
+    EXPECT_THAT(stats, HasSubstr("Featured playlists: "));
+    EXPECT_THAT(stats, HasSubstr("Quota: "));
+    EXPECT_THAT(stats, HasSubstr("Known failures served: 0\n"));
+    EXPECT_THAT(stats, HasSubstr("Duplicate results suppressed: "));
+}
+
+TEST_F(TestYoutubeScope, stop_exports_stats_when_asked) {
+    char path[] = "/tmp/youtube-scope-stats-XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_NE(-1, fd);
+    close(fd);
+
+    setenv("YOUTUBE_SCOPE_STATS", path, true);
+    scope->stop();
+    unsetenv("YOUTUBE_SCOPE_STATS");
+
+    ifstream in(path);
+    stringstream stats;
+    stats << in.rdbuf();
+    remove(path);
+
+    EXPECT_THAT(stats.str(), HasSubstr("Known failures served: 0\n"));
+}
+
 } // namespace